@@ -2,8 +2,18 @@
 #include <GLFW/glfw3.h>
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <map>
 
+// 전역 operator new/delete를 할당 횟수를 세는 것으로 교체 (alloc_tracker.h)
+#define ALLOC_TRACKER_IMPLEMENTATION
+#include "alloc_tracker.h"
 #include "game.h"
+#include "mapped_file.h"
+#include "input_recorder.h"
+#include "net_transport.h"
 
 // 함수 선언
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -14,11 +24,235 @@ const unsigned int SCREEN_WIDTH = 800;
 const unsigned int SCREEN_HEIGHT = 600;
 
 Game BouncyBall(SCREEN_WIDTH, SCREEN_HEIGHT);
+std::string traceFile; // --trace
+//--record <파일> : 입력(A/D/좌우/R/SPACE/BACKSPACE)을 파일로 기록, --replay <파일> : 기록한 입력으로 플레이 (그동안 키보드 입력은 무시)
+//틱은 로딩이 끝난 뒤의 프레임 하나, 둘 다 프레임마다 1/60초로 진행해서 재생이 기록과 같은 상태를 지나감
+const float INPUT_TICK = 1.0f / 60.0f;
+InputRecorder inputRecorder;
+InputPlayback inputReplay;
+bool replaying = false;
+//--versus <0|1> <로컬 포트> <상대 주소:포트> [--versus-level <n>] : 2인 대전 (롤백 넷코드, UDP)
+//같은 기기에서 둘: --versus 0 7000 127.0.0.1:7001 / --versus 1 7001 127.0.0.1:7000, 로딩이 끝나면 메뉴 없이 바로 출발
+UdpTransport versusLink;
+int versusPlayer = -1;
+unsigned int versusLevel = 1;
+
+//--alloc-check : 메뉴를 건너뛰고 레벨을 진행하면서 정상 상태 프레임(레벨 교체/리셋이 없는 ACTIVE 프레임)에서
+//메인 스레드가 힙 할당을 하면 실패 (워밍업 후 ALLOC_CHECK_FRAMES 프레임, 종료 코드 1)
+const unsigned int ALLOC_CHECK_WARMUP = 60;
+const unsigned int ALLOC_CHECK_FRAMES = 600;
+struct AllocCheck {
+    bool Enabled = false;
+    unsigned int Frames = 0, Failures = 0;
+    uint64_t allocations = 0;
+    unsigned int levelLoads = 0;
+    bool active = false;
+    AllocTracker::TagCounts tags[AllocTracker::MAX_TAGS];
+    unsigned int tagCount = 0;
+
+    void BeginFrame(const Game &game)
+    {
+        allocations = AllocTracker::ThreadAllocations();
+        levelLoads = game.levelLoads;
+        active = game.State == GAME_ACTIVE;
+        tagCount = AllocTracker::Main().Snapshot(tags);
+    }
+    // 검사가 끝나면 true
+    bool EndFrame(const Game &game)
+    {
+        if (!active || game.State != GAME_ACTIVE || game.levelLoads != levelLoads)
+            return false;
+        if (++Frames <= ALLOC_CHECK_WARMUP)
+            return false;
+        uint64_t count = AllocTracker::ThreadAllocations() - allocations;
+        if (count > 0)
+        {
+            ++Failures;
+            std::cout << "ERROR::ALLOC: Steady-state frame " << Frames - ALLOC_CHECK_WARMUP << " allocated " << count << " times" << std::endl;
+            // 태그별 증가분 (다른 스레드의 할당도 포함)
+            AllocTracker::TagCounts now[AllocTracker::MAX_TAGS];
+            unsigned int nowCount = AllocTracker::Main().Snapshot(now);
+            for (unsigned int i = 0; i < nowCount; ++i)
+            {
+                uint64_t before = i < tagCount ? tags[i].Allocations : 0;
+                if (now[i].Allocations > before)
+                    std::cout << "    " << now[i].Name << ": " << now[i].Allocations - before << std::endl;
+            }
+        }
+        if (Frames < ALLOC_CHECK_WARMUP + ALLOC_CHECK_FRAMES)
+            return false;
+        std::cout << "Alloc check: " << ALLOC_CHECK_FRAMES << " steady-state frames, " << Failures << " allocated" << std::endl;
+        return true;
+    }
+};
+AllocCheck allocCheck;
+
+//--startup-bench <n> : 자신을 --startup-run으로 콜드/웜 각각 n번 실행해서 단계별 시간의 중앙값과
+//첫 프레임/메뉴 첫 프레임까지의 최소/중앙값/최대를 출력 (나머지 인자는 그대로 전달)
+//콜드는 실행 전에 텍스처 캐시(resources/.cache)를 비우고 에셋, 쉐이더, 실행 파일을 OS 파일 캐시에서 내림
+//(매번 텍스처를 디코딩해서 캐시를 다시 만듦, 드라이버 쉐이더 캐시는 그대로)
+struct StartupRun {
+    std::map<std::string, double> Phases; // 같은 이름은 합계
+    std::map<std::string, double> Starts;
+    std::map<std::string, double> Milestones;
+};
+static bool readStartupRun(const std::string &file, StartupRun &run)
+{
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream split(line);
+        for (std::string field; std::getline(split, field, '\t'); )
+            fields.push_back(field);
+        if (fields.size() == 5 && fields[0] == "phase")
+        {
+            run.Phases[fields[1]] += std::atof(fields[4].c_str());
+            if (!run.Starts.count(fields[1]))
+                run.Starts[fields[1]] = std::atof(fields[3].c_str());
+        }
+        else if (fields.size() == 3 && fields[0] == "milestone")
+            run.Milestones[fields[1]] = std::atof(fields[2].c_str());
+    }
+    return !run.Milestones.empty();
+}
+static double median(std::vector<double> values)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t half = values.size() / 2;
+    return values.size() % 2 ? values[half] : (values[half - 1] + values[half]) / 2.0;
+}
+static int startupBench(const char *program, unsigned int runs, const std::string &arguments)
+{
+    std::string report = (std::filesystem::temp_directory_path() / "bouncyball_startup.txt").string();
+    std::string command = std::string("\"") + program + "\" --startup-run \"" + report + "\"" + arguments;
+#ifdef _WIN32
+    command = "\"" + command + "\""; // cmd.exe는 따옴표로 시작하는 명령의 바깥 따옴표를 벗겨냄
+#endif
+    auto launch = [&](StartupRun &run) {
+        std::remove(report.c_str());
+        return std::system(command.c_str()) == 0 && readStartupRun(report, run);
+    };
+    auto dropCaches = [&]() {
+        std::error_code ec;
+        // 남아있으면 첫 콜드 실행만 디코딩하고 나머지는 캐시 항목을 읽음
+        std::filesystem::remove_all(TextureCache::Directory(), ec);
+        for (const char *folder : { "resources", "src/shader" })
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(folder, ec))
+                if (entry.is_regular_file(ec))
+                    MappedFile::DropFromCache(entry.path().string().c_str());
+        MappedFile::DropFromCache(program);
+    };
+    std::vector<StartupRun> cold, warm;
+    for (unsigned int i = 0; i < runs; ++i)
+    {
+        dropCaches();
+        StartupRun run;
+        if (launch(run))
+            cold.push_back(run);
+    }
+    StartupRun discard;
+    launch(discard); // 캐시 채우기 (텍스처 캐시와 OS 파일 캐시)
+    for (unsigned int i = 0; i < runs; ++i)
+    {
+        StartupRun run;
+        if (launch(run))
+            warm.push_back(run);
+    }
+    if (cold.empty() || warm.empty())
+    {
+        std::cout << "ERROR::STARTUP: Runs failed (" << cold.size() << " cold, " << warm.size() << " warm finished)" << std::endl;
+        return 1;
+    }
+
+    // 단계 순서는 웜 실행의 시작 시각 중앙값
+    std::map<std::string, std::vector<double>> starts;
+    for (const StartupRun &run : warm)
+        for (const auto &start : run.Starts)
+            starts[start.first].push_back(start.second);
+    std::vector<std::pair<double, std::string>> order;
+    for (const auto &start : starts)
+        order.push_back({ median(start.second), start.first });
+    std::sort(order.begin(), order.end());
+    auto phaseMedian = [](const std::vector<StartupRun> &set, const std::string &name) {
+        std::vector<double> values;
+        for (const StartupRun &run : set)
+        {
+            auto found = run.Phases.find(name);
+            values.push_back(found != run.Phases.end() ? found->second : 0.0);
+        }
+        return median(values);
+    };
+    std::printf("Startup bench: %zu cold, %zu warm runs, median ms\n%-40s %10s %10s\n", cold.size(), warm.size(), "phase", "cold", "warm");
+    for (const auto &phase : order)
+        std::printf("%-40s %10.2f %10.2f\n", phase.second.c_str(), phaseMedian(cold, phase.second), phaseMedian(warm, phase.second));
+    std::printf("\n%-20s %28s %28s\n", "milestone", "cold min / median / max", "warm min / median / max");
+    for (const char *milestone : { "first frame", "assets loaded", "first menu frame" })
+    {
+        std::printf("%-20s", milestone);
+        for (const std::vector<StartupRun> *set : { &cold, &warm })
+        {
+            std::vector<double> times;
+            for (const StartupRun &run : *set)
+            {
+                auto found = run.Milestones.find(milestone);
+                if (found != run.Milestones.end())
+                    times.push_back(found->second);
+            }
+            if (times.empty())
+                std::printf(" %28s", "-");
+            else
+                std::printf("  %8.1f / %8.1f / %8.1f", *std::min_element(times.begin(), times.end()), median(times),
+                            *std::max_element(times.begin(), times.end()));
+        }
+        std::printf("\n");
+    }
+    std::remove(report.c_str());
+    return 0;
+}
 
 // 메인 함수 ---------------------------------------------------------------------------------------
 int main(int argc, char *argv[])
 {
-    glfwInit();
+    //--trace <파일> : 최근 10초의 구간 이벤트를 기록, F4와 종료 시 Chrome trace JSON으로 저장 (Perfetto에서 열기)
+    Tracer::NameThread("main");
+    StartupReport::Main(); // 시작 시각 기준점
+    //--startup-report : 시작 단계별 시간표 출력, --startup-run <파일> : 메뉴 첫 프레임을 그리면 단계를 파일로 저장하고 종료
+    bool startupReport = false;
+    std::string startupRunFile, forwarded;
+    unsigned int startupBenchRuns = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--trace" && i + 1 < argc)
+        {
+            traceFile = argv[i + 1];
+            Tracer::Main().Enable(10.0);
+        }
+        else if (arg == "--startup-report")
+            startupReport = true;
+        else if (arg == "--startup-run" && i + 1 < argc)
+        {
+            startupRunFile = argv[++i];
+            continue;
+        }
+        else if (arg == "--startup-bench" && i + 1 < argc)
+        {
+            startupBenchRuns = std::max(1, std::atoi(argv[++i]));
+            continue;
+        }
+        forwarded += std::string(" \"") + arg + "\"";
+    }
+    if (startupBenchRuns > 0)
+        return startupBench(argv[0], startupBenchRuns, forwarded);
+
+    {
+        STARTUP_PHASE("glfw init");
+        glfwInit();
+    }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -26,13 +260,20 @@ int main(int argc, char *argv[])
 
     glfwWindowHint(GLFW_RESIZABLE, false);
 
-    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "OpenGL_BouncyBall // kkr970 (Shin-Icksu) // h:ICKSU", nullptr, nullptr);
-    glfwMakeContextCurrent(window); 
+    GLFWwindow* window;
+    {
+        STARTUP_PHASE("window and context");
+        window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "OpenGL_BouncyBall // kkr970 (Shin-Icksu) // h:ICKSU", nullptr, nullptr);
+        glfwMakeContextCurrent(window); 
+    }
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        STARTUP_PHASE("glad");
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            return -1;
+        }
     }
 
     glfwSetKeyCallback(window, key_callback);
@@ -49,8 +290,73 @@ int main(int argc, char *argv[])
     float deltaTime = 0.0f;
     float lastFrame = 0.0f;
 
+    //--audio <irrklang|null|wav:파일> : 오디오 출력 선택 (사운드 장치가 없으면 null)
+    //--gl-stats <파일> : GL 호출(그리기, 바인드, 유니폼, 업로드, 오브젝트 생성/삭제)을 세어 오버레이(F3)에 표시, 종료 시 파일로 저장
+    std::string glStatsFile;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--audio")
+            BouncyBall.SetAudioOutput(argv[i + 1]);
+        else if (std::string(argv[i]) == "--gl-stats")
+        {
+            glStatsFile = argv[i + 1];
+            GLStats::Main().Install();
+        }
+    }
     //게임 초기화
-    BouncyBall.Init();
+    {
+        TRACE_SCOPE("init");
+        STARTUP_PHASE("game init");
+        BouncyBall.Init();
+    }
+    //--hot-reload : 레벨, 쉐이더, texture 파일을 수정하면 실행 중에 다시 읽음
+    //--profile <파일> : 종료 시 최근 프레임의 구간별 시간을 CSV로 저장 (오버레이는 F3)
+    //--fixed-physics : 고정소수점(16.16) 물리, 60Hz 고정 틱 - 같은 입력이면 어느 기기에서나 같은 결과
+    //--no-ghosts : 고스트(레벨별 최고 기록의 공, ghosts/ 폴더에 저장)를 끔
+    std::string profileFile;
+    bool ghosts = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--hot-reload")
+            BouncyBall.EnableHotReload();
+        else if (std::string(argv[i]) == "--profile" && i + 1 < argc)
+            profileFile = argv[++i];
+        else if (std::string(argv[i]) == "--alloc-check")
+            allocCheck.Enabled = true;
+        else if (std::string(argv[i]) == "--fixed-physics")
+            BouncyBall.EnableFixedPhysics();
+        else if (std::string(argv[i]) == "--no-ghosts")
+            ghosts = false;
+        else if (std::string(argv[i]) == "--record" && i + 1 < argc)
+        {
+            if (!inputRecorder.Open(argv[++i]))
+                std::cout << "ERROR::INPUT: Could not create " << argv[i] << std::endl;
+        }
+        else if (std::string(argv[i]) == "--versus" && i + 3 < argc)
+        {
+            versusPlayer = std::atoi(argv[++i]) == 1 ? 1 : 0;
+            unsigned short localPort = static_cast<unsigned short>(std::atoi(argv[++i]));
+            std::string remote = argv[++i];
+            size_t colon = remote.rfind(':');
+            if (colon == std::string::npos || !versusLink.Open(localPort, remote.substr(0, colon), static_cast<unsigned short>(std::atoi(remote.c_str() + colon + 1))))
+            {
+                std::cout << "ERROR::NET: Could not start the versus game (--versus <0|1> <local port> <host:port>)" << std::endl;
+                versusPlayer = -1;
+            }
+        }
+        else if (std::string(argv[i]) == "--versus-level" && i + 1 < argc)
+            versusLevel = std::max(1, std::atoi(argv[++i]));
+        else if (std::string(argv[i]) == "--replay" && i + 1 < argc)
+        {
+            replaying = inputReplay.Open(argv[++i]);
+            if (!replaying)
+                std::cout << "ERROR::INPUT: Could not read " << argv[i] << std::endl;
+        }
+    }
+    // 첫 레벨은 로딩이 끝날 때 들어가므로 (Update) 여기서 켜도 됨
+    if (ghosts)
+        BouncyBall.EnableGhosts("ghosts");
+    bool firstFrame = true;
 
     //직교 투영 행렬 projection
     glm::mat4 projection = glm::ortho(0.0f, 800.0f, 600.0f, 0.0f, -1.0f, 1.0f);
@@ -58,30 +364,115 @@ int main(int argc, char *argv[])
     //렌더링 함수
     while (!glfwWindowShouldClose(window))
     { 
+        PROFILE_FRAME_BEGIN();
+        if (allocCheck.Enabled)
+        {
+            // 로딩이 끝나면 바로 게임 시작 (SPACE 대신)
+            if (BouncyBall.State == GAME_MENU)
+                BouncyBall.State = GAME_ACTIVE;
+            allocCheck.BeginFrame(BouncyBall);
+        }
+        if (versusPlayer >= 0 && BouncyBall.State == GAME_MENU && !BouncyBall.Racing())
+            BouncyBall.StartRace(std::min(versusLevel, BouncyBall.maxLevel + 1) - 1, versusPlayer, versusLink);
         //delta 시간
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("poll events");
+            glfwPollEvents();
+        }
+        //입력 기록, 재생 - 로딩이 끝난 뒤부터 (로딩 프레임 수는 실행마다 다름)
+        if ((inputRecorder.IsOpen() || replaying) && BouncyBall.State != GAME_LOADING)
+        {
+            deltaTime = INPUT_TICK;
+            if (replaying && !inputReplay.Next(BouncyBall.Keys, BouncyBall.KeysProcessed))
+            {
+                std::cout << "Replay finished after " << inputReplay.Length() << " ticks" << std::endl;
+                replaying = false;
+            }
+            if (inputRecorder.IsOpen())
+                inputRecorder.Record(BouncyBall.Keys);
+        }
  
         //게임 state update
-        BouncyBall.Update(deltaTime);
+        {
+            PROFILE_SCOPE("update");
+            BouncyBall.Update(deltaTime);
+        }
 
         //입력
-        BouncyBall.ProcessInput(deltaTime);
+        {
+            PROFILE_SCOPE("input");
+            BouncyBall.ProcessInput(deltaTime);
+        }
 
         //렌더링
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        BouncyBall.Render();
+        {
+            PROFILE_SCOPE("render");
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            BouncyBall.Render();
+        }
 
-        glfwSwapBuffers(window); 
+        {
+            PROFILE_SCOPE("swap");
+            glfwSwapBuffers(window); 
+        }
+        PROFILE_FRAME_END();
+        GLStats::Main().EndFrame();
+        if (allocCheck.Enabled && allocCheck.EndFrame(BouncyBall))
+            glfwSetWindowShouldClose(window, true);
+        //시작부터 첫 화면(로딩 화면)과 메뉴 첫 화면이 실제로 표시될 때까지 걸린 시간 (glFinish로 표시 완료까지 대기)
+        if (firstFrame)
+        {
+            glFinish();
+            StartupReport::Main().Mark("first frame");
+            firstFrame = false;
+        }
+        if (StartupReport::Main().Recording() && BouncyBall.State != GAME_LOADING)
+        {
+            glFinish();
+            StartupReport &startup = StartupReport::Main();
+            startup.Mark("first menu frame");
+            startup.Close();
+            std::cout << "Time to first frame: " << startup.MilestoneTime("first frame") << " ms, to menu: "
+                      << startup.MilestoneTime("first menu frame") << " ms" << std::endl;
+            if (startupReport)
+                startup.Print();
+            if (!startupRunFile.empty())
+            {
+                if (!startup.Write(startupRunFile))
+                    std::cout << "ERROR::STARTUP: Could not write " << startupRunFile << std::endl;
+                glfwSetWindowShouldClose(window, true);
+            }
+        }
     }
 
+    if (inputRecorder.IsOpen())
+    {
+        inputRecorder.Close();
+        std::cout << "Recorded " << inputRecorder.Ticks() << " ticks of input in " << inputRecorder.Bytes() << " bytes" << std::endl;
+    }
+    if (BouncyBall.Racing())
+    {
+        const RollbackSession::Stats &stats = BouncyBall.Race()->GetStats();
+        std::cout << "Versus: " << BouncyBall.Race()->Tick() << " ticks, " << stats.Rollbacks << " rollbacks ("
+                  << stats.ResimulatedTicks << " ticks resimulated, longest " << stats.LongestRollback << ", worst "
+                  << stats.WorstRollbackMs << " ms), waited " << stats.WaitingCalls << " times" << std::endl;
+    }
+    if (!traceFile.empty() && !Tracer::Main().Write(traceFile))
+        std::cout << "ERROR::TRACER: Could not write " << traceFile << std::endl;
+    if (!profileFile.empty() && !Profiler::Main().WriteCSV(profileFile))
+        std::cout << "ERROR::PROFILER: Could not write " << profileFile << std::endl;
+    if (!glStatsFile.empty() && !GLStats::Main().Write(glStatsFile))
+        std::cout << "ERROR::GLSTATS: Could not write " << glStatsFile << std::endl;
+    // GL 컨텍스트가 살아있을 때 정리 (BouncyBall은 전역이라 파괴자는 glfwTerminate 뒤에 돎)
+    BouncyBall.Shutdown();
     ResourceManager::Clear();
 
     glfwTerminate(); 
-    return 0; 
+    return allocCheck.Failures > 0 ? 1 : 0; 
 }
 
 void key_callback(GLFWwindow* window, int key, int  scancode, int action, int mode)
@@ -89,6 +480,15 @@ void key_callback(GLFWwindow* window, int key, int  scancode, int action, int mo
     // ESC 종료 버튼
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    // F4 트레이스 저장 (--trace 일 때)
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS && !traceFile.empty())
+    {
+        if (Tracer::Main().Write(traceFile))
+            std::cout << "Wrote trace " << traceFile << std::endl;
+    }
+    // 재생 중에는 기록된 키를 키보드로 바꿀 수 없음
+    if (replaying && IsInputKey(key))
+        return;
     // 나머지 key 입력 확인
     if (key >= 0 && key < 1024)
     {
@@ -0,0 +1,253 @@
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+
+// AllocTracker counts the heap allocations made through operator new, per
+// thread and per tag. A tag is the innermost ALLOC_SCOPE (or PROFILE_SCOPE)
+// of the allocating thread, so a stray allocation in a frame can be traced
+// to the scope that made it. The counting operator new/delete are defined
+// by the one translation unit that defines ALLOC_TRACKER_IMPLEMENTATION
+// before including this header; without it nothing is counted. Memory that
+// libraries get from malloc directly (drivers, stb_image) is not counted.
+class AllocTracker
+{
+public:
+    static constexpr unsigned int MAX_TAGS = 32;
+
+    struct TagCounts {
+        const char *Name;
+        uint64_t Allocations, Bytes;
+    };
+
+    static AllocTracker &Main()
+    {
+        // constant initialized, so operator new may use it before main
+        static AllocTracker tracker;
+        return tracker;
+    }
+
+    // returns the index of a tag name (tag 0 collects allocations outside every scope)
+    unsigned int Register(const char *name)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        unsigned int count = this->tagCount.load(std::memory_order_relaxed);
+        for (unsigned int i = 0; i < count; ++i)
+            if (std::strcmp(this->names[i], name) == 0)
+                return i;
+        if (count == MAX_TAGS)
+            return 0; // folded into untagged
+        this->names[count] = name;
+        this->tagCount.store(count + 1, std::memory_order_release);
+        return count;
+    }
+    // called by operator new on the allocating thread
+    void Count(size_t size)
+    {
+        ++threadAllocations();
+        Tag &tag = this->tags[CurrentTag()];
+        tag.Allocations.fetch_add(1, std::memory_order_relaxed);
+        tag.Bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+    void CountFree()
+    {
+        ++threadFrees();
+    }
+    // allocations and frees of the calling thread since it started
+    static uint64_t ThreadAllocations() { return threadAllocations(); }
+    static uint64_t ThreadFrees() { return threadFrees(); }
+    // totals of every registered tag, all threads
+    unsigned int Snapshot(TagCounts *counts) const
+    {
+        unsigned int count = this->tagCount.load(std::memory_order_acquire);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            counts[i].Name = this->names[i];
+            counts[i].Allocations = this->tags[i].Allocations.load(std::memory_order_relaxed);
+            counts[i].Bytes = this->tags[i].Bytes.load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+    static unsigned int &CurrentTag()
+    {
+        thread_local unsigned int tag = 0;
+        return tag;
+    }
+
+private:
+    struct Tag {
+        std::atomic<uint64_t> Allocations{ 0 }, Bytes{ 0 };
+    };
+
+    constexpr AllocTracker() { }
+
+    std::mutex mutex; // guards registration only
+    const char *names[MAX_TAGS] = { "untagged" };
+    std::atomic<unsigned int> tagCount{ 1 };
+    Tag tags[MAX_TAGS];
+
+    static uint64_t &threadAllocations()
+    {
+        thread_local uint64_t count = 0;
+        return count;
+    }
+    static uint64_t &threadFrees()
+    {
+        thread_local uint64_t count = 0;
+        return count;
+    }
+};
+
+// tags the allocations of the calling thread until the end of the enclosing block
+class AllocScope
+{
+public:
+    explicit AllocScope(unsigned int tag) : previous(AllocTracker::CurrentTag()) { AllocTracker::CurrentTag() = tag; }
+    ~AllocScope() { AllocTracker::CurrentTag() = this->previous; }
+    AllocScope(const AllocScope&) = delete;
+    AllocScope &operator=(const AllocScope&) = delete;
+
+private:
+    unsigned int previous;
+};
+
+#ifndef BOUNCYBALL_NO_PROFILER
+#define ALLOC_JOIN_(a, b) a##b
+#define ALLOC_JOIN(a, b) ALLOC_JOIN_(a, b)
+#define ALLOC_SCOPE(name) \
+    static const unsigned int ALLOC_JOIN(allocTagId, __LINE__) = AllocTracker::Main().Register(name); \
+    AllocScope ALLOC_JOIN(allocScope, __LINE__)(ALLOC_JOIN(allocTagId, __LINE__))
+#else
+#define ALLOC_SCOPE(name)
+#endif
+
+
+// FrameArena hands out memory for data that only lives until the end of the
+// frame (formatted text, scratch arrays) from one block allocated up front.
+// Reset at the start of every frame releases everything at once. A request
+// that does not fit fails instead of growing the block, so the arena never
+// allocates after construction; HighWater tells how big it needs to be.
+class FrameArena
+{
+public:
+    explicit FrameArena(size_t capacity) : memory(new unsigned char[capacity]), capacity(capacity) { }
+    ~FrameArena() { delete[] this->memory; }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena &operator=(const FrameArena&) = delete;
+
+    // returns size bytes aligned to align, nullptr when the frame's memory is used up
+    void *Allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+        size_t offset = (this->used + align - 1) & ~(align - 1);
+        if (offset + size > this->capacity)
+        {
+            ++this->failures;
+            return nullptr;
+        }
+        this->used = offset + size;
+        if (this->used > this->highWater)
+            this->highWater = this->used;
+        return this->memory + offset;
+    }
+    // uninitialized array of count T (T must be trivially destructible, nothing is destroyed)
+    template <typename T>
+    T *Array(size_t count)
+    {
+        return static_cast<T*>(this->Allocate(sizeof(T) * count, alignof(T)));
+    }
+    // printf into the arena, "" when it does not fit
+    const char *Format(const char *format, ...)
+    {
+        char *text = static_cast<char*>(this->Allocate(0, 1));
+        size_t room = this->capacity - this->used;
+        va_list args;
+        va_start(args, format);
+        int length = std::vsnprintf(text, room, format, args);
+        va_end(args);
+        if (length < 0 || size_t(length) >= room)
+        {
+            ++this->failures;
+            return "";
+        }
+        this->Allocate(size_t(length) + 1, 1);
+        return text;
+    }
+    void Reset() { this->used = 0; }
+
+    size_t Used() const { return this->used; }
+    size_t HighWater() const { return this->highWater; }
+    size_t Capacity() const { return this->capacity; }
+    unsigned int Failures() const { return this->failures; }
+
+private:
+    unsigned char *memory;
+    size_t capacity;
+    size_t used = 0, highWater = 0;
+    unsigned int failures = 0;
+};
+
+
+#ifdef ALLOC_TRACKER_IMPLEMENTATION
+// counting replacements of the global allocation functions (aligned new is left to the library)
+static void *allocTrackerNew(size_t size)
+{
+    if (size == 0)
+        size = 1;
+    for (;;)
+    {
+        if (void *memory = std::malloc(size))
+        {
+            AllocTracker::Main().Count(size);
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            return nullptr;
+        handler();
+    }
+}
+static void allocTrackerDelete(void *memory) noexcept
+{
+    if (!memory)
+        return;
+    AllocTracker::Main().CountFree();
+    std::free(memory);
+}
+
+void *operator new(size_t size)
+{
+    if (void *memory = allocTrackerNew(size))
+        return memory;
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocTrackerNew(size); }
+    catch (...) { return nullptr; }
+}
+void *operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+void operator delete(void *memory) noexcept { allocTrackerDelete(memory); }
+void operator delete[](void *memory) noexcept { allocTrackerDelete(memory); }
+void operator delete(void *memory, size_t) noexcept { allocTrackerDelete(memory); }
+void operator delete[](void *memory, size_t) noexcept { allocTrackerDelete(memory); }
+void operator delete(void *memory, const std::nothrow_t&) noexcept { allocTrackerDelete(memory); }
+void operator delete[](void *memory, const std::nothrow_t&) noexcept { allocTrackerDelete(memory); }
+#endif
+
+#endif
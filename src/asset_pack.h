@@ -0,0 +1,236 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <fstream>
+#include <iostream>
+
+#include "mapped_file.h"
+#include "lz_codec.h"
+
+
+// On-disk layout of an asset pack (all values little endian):
+//   PackHeader
+//   PackEntry[EntryCount]   sorted by NameHash
+//   name table              entry names, not null terminated
+//   blobs                   each starting at a PACK_ALIGNMENT boundary
+// Entry names are the same relative paths the game uses for loose files
+// (e.g. "resources/textures/ball.png"), so a pack is a drop-in replacement.
+const char     PACK_MAGIC[4] = { 'B', 'B', 'P', 'K' };
+const uint32_t PACK_VERSION = 1;
+const uint32_t PACK_ALIGNMENT = 64;
+const uint16_t PACK_FLAG_LZ = 1 << 0; // blob is compressed with LZCompress
+
+struct PackHeader {
+    char     Magic[4];
+    uint32_t Version;
+    uint32_t EntryCount;
+    uint32_t NameTableSize;
+    uint64_t IndexOffset;
+    uint64_t NameTableOffset;
+};
+
+struct PackEntry {
+    uint64_t NameHash;
+    uint64_t Offset;     // blob offset from the start of the pack
+    uint64_t Size;       // stored size
+    uint64_t RawSize;    // size after decompression
+    uint32_t NameOffset; // into the name table
+    uint16_t NameLength;
+    uint16_t Flags;
+};
+
+// 64-bit FNV-1a, used to hash entry names
+inline uint64_t HashName(const char *str, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(str[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+inline uint64_t HashName(const std::string &str)
+{
+    return HashName(str.data(), str.size());
+}
+
+
+// AssetData holds the bytes of a single asset. Data either points straight
+// into the mapped pack (zero-copy) or into the owned buffer when the asset
+// came from a loose file. An empty AssetData means the asset was not found.
+struct AssetData {
+    const unsigned char *Data = nullptr;
+    size_t Size = 0;
+    std::vector<unsigned char> Owned;
+
+    AssetData() { }
+    AssetData(const AssetData &other) { *this = other; }
+    AssetData &operator=(const AssetData &other)
+    {
+        this->Owned = other.Owned;
+        this->Size = other.Size;
+        this->Data = other.Owned.empty() ? other.Data : this->Owned.data();
+        return *this;
+    }
+    AssetData(AssetData &&other) noexcept { *this = std::move(other); }
+    AssetData &operator=(AssetData &&other) noexcept
+    {
+        bool owned = !other.Owned.empty();
+        this->Owned = std::move(other.Owned);
+        this->Size = other.Size;
+        this->Data = owned ? this->Owned.data() : other.Data;
+        other.Data = nullptr;
+        other.Size = 0;
+        return *this;
+    }
+
+    bool IsValid() const { return this->Data != nullptr; }
+    const char *Chars() const { return reinterpret_cast<const char*>(this->Data); }
+    std::string String() const { return std::string(this->Chars(), this->Size); }
+
+    // reads a whole loose file into the owned buffer
+    static AssetData FromFile(const char *path)
+    {
+        AssetData asset;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return asset;
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        // keep one spare byte so empty files still yield a valid pointer
+        asset.Owned.resize(static_cast<size_t>(size) + 1, 0);
+        if (size > 0 && !file.read(reinterpret_cast<char*>(asset.Owned.data()), size))
+            return AssetData();
+        asset.Size = static_cast<size_t>(size);
+        asset.Data = asset.Owned.data();
+        return asset;
+    }
+};
+
+
+// AssetPack maps a pack file once and serves lookups from its hashed
+// index. Uncompressed entries are returned as views into the mapping;
+// compressed entries are inflated on first access and kept for the
+// lifetime of the pack so the returned pointers stay valid.
+class AssetPack
+{
+public:
+    AssetPack() { }
+
+    // maps the pack file and validates its header, returns false if there is no usable pack
+    bool Open(const char *path)
+    {
+        this->Close();
+        if (!this->file.Open(path))
+            return false;
+        const unsigned char *base = this->file.Data();
+        size_t size = this->file.Size();
+        if (size < sizeof(PackHeader))
+            return this->fail(path, "file too small");
+        std::memcpy(&this->header, base, sizeof(PackHeader));
+        if (std::memcmp(this->header.Magic, PACK_MAGIC, 4) != 0 || this->header.Version != PACK_VERSION)
+            return this->fail(path, "bad header");
+        uint64_t indexEnd = this->header.IndexOffset + uint64_t(this->header.EntryCount) * sizeof(PackEntry);
+        uint64_t namesEnd = this->header.NameTableOffset + this->header.NameTableSize;
+        if (indexEnd > size || namesEnd > size || this->header.IndexOffset % alignof(PackEntry) != 0)
+            return this->fail(path, "truncated index");
+        this->entries = reinterpret_cast<const PackEntry*>(base + this->header.IndexOffset);
+        this->names = reinterpret_cast<const char*>(base + this->header.NameTableOffset);
+        for (uint32_t i = 0; i < this->header.EntryCount; ++i)
+        {
+            const PackEntry &entry = this->entries[i];
+            if (entry.Offset + entry.Size > size || entry.NameOffset + uint64_t(entry.NameLength) > this->header.NameTableSize)
+                return this->fail(path, "entry out of range");
+        }
+        return true;
+    }
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->inflated.clear();
+        this->entries = nullptr;
+        this->names = nullptr;
+        std::memset(&this->header, 0, sizeof(PackHeader));
+        this->file.Close();
+    }
+    bool IsOpen() const { return this->entries != nullptr; }
+    unsigned int Count() const { return this->IsOpen() ? this->header.EntryCount : 0; }
+
+    // looks up an asset by name, returns an empty AssetData if the pack does not contain it
+    AssetData Find(const std::string &name)
+    {
+        AssetData asset;
+        const PackEntry *entry = this->findEntry(name);
+        if (!entry)
+            return asset;
+        if (!(entry->Flags & PACK_FLAG_LZ))
+        {
+            asset.Data = this->file.Data() + entry->Offset;
+            asset.Size = static_cast<size_t>(entry->Size);
+            return asset;
+        }
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::vector<unsigned char> &buffer = this->inflated[entry - this->entries];
+        if (buffer.empty())
+        {
+            buffer.resize(static_cast<size_t>(entry->RawSize) + 1, 0);
+            if (!LZDecompress(this->file.Data() + entry->Offset, static_cast<size_t>(entry->Size), buffer.data(), static_cast<size_t>(entry->RawSize)))
+            {
+                std::cout << "ERROR::ASSETPACK: Corrupt entry " << name << std::endl;
+                buffer.clear();
+                return asset;
+            }
+        }
+        asset.Data = buffer.data();
+        asset.Size = static_cast<size_t>(entry->RawSize);
+        return asset;
+    }
+
+private:
+    MappedFile file;
+    PackHeader header = {};
+    const PackEntry *entries = nullptr;
+    const char *names = nullptr;
+    // inflated copies of compressed entries, keyed by entry index
+    std::map<size_t, std::vector<unsigned char>> inflated;
+    std::mutex mutex;
+
+    // binary search on the sorted hash index, names are compared to rule out collisions
+    const PackEntry *findEntry(const std::string &name) const
+    {
+        if (!this->IsOpen())
+            return nullptr;
+        uint64_t hash = HashName(name);
+        size_t lo = 0, hi = this->header.EntryCount;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (this->entries[mid].NameHash < hash)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        for (size_t i = lo; i < this->header.EntryCount && this->entries[i].NameHash == hash; ++i)
+        {
+            const PackEntry &entry = this->entries[i];
+            if (entry.NameLength == name.size() && std::memcmp(this->names + entry.NameOffset, name.data(), name.size()) == 0)
+                return &entry;
+        }
+        return nullptr;
+    }
+    bool fail(const char *path, const char *reason)
+    {
+        std::cout << "ERROR::ASSETPACK: Failed to open " << path << " (" << reason << ")" << std::endl;
+        this->Close();
+        return false;
+    }
+};
+
+#endif
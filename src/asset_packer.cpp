@@ -0,0 +1,158 @@
+// asset_packer - builds resources/assets.pak from the loose asset folders.
+//
+//   asset_packer [-o output.pak] [--no-compress] [folder ...]
+//
+// Run from the repository root so entry names match the paths the game
+// loads (e.g. "resources/textures/ball.png"). Without folders the default
+// game folders are packed.
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+
+namespace fs = std::filesystem;
+
+struct PackInput {
+    std::string Name;
+    std::vector<unsigned char> Blob;
+    PackEntry Entry;
+};
+
+// formats that are already compressed gain nothing from LZ, and ready-to-upload
+// textures and streamed music would lose zero-copy access
+static bool isCompressedFormat(const fs::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (path.parent_path().filename() == "streamed")
+        return true;
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".mp3" || ext == ".ogg" || ext == ".bbtx";
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output = "resources/assets.pak";
+    bool compress = true;
+    std::vector<std::string> folders;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "--no-compress")
+            compress = false;
+        else
+            folders.push_back(arg);
+    }
+    if (folders.empty())
+        folders = { "resources/textures", "resources/audio", "resources/fonts", "resources/gamelevels", "src/shader" };
+
+    // collect files
+    std::vector<PackInput> inputs;
+    for (const std::string &folder : folders)
+    {
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(folder, ec), end; it != end && !ec; it.increment(ec))
+        {
+            if (!it->is_regular_file())
+                continue;
+            PackInput input;
+            input.Name = it->path().generic_string();
+            AssetData data = AssetData::FromFile(input.Name.c_str());
+            if (!data.IsValid())
+            {
+                std::cout << "ERROR::ASSETPACKER: Could not read " << input.Name << std::endl;
+                return 1;
+            }
+            input.Entry = PackEntry();
+            input.Entry.NameHash = HashName(input.Name);
+            input.Entry.RawSize = data.Size;
+            input.Blob.assign(data.Data, data.Data + data.Size);
+            // keep compression only when it saves at least 10%
+            if (compress && !isCompressedFormat(it->path()) && data.Size > 0)
+            {
+                std::vector<unsigned char> packed;
+                LZCompress(data.Data, data.Size, packed);
+                if (packed.size() * 10 < data.Size * 9)
+                {
+                    input.Blob.swap(packed);
+                    input.Entry.Flags |= PACK_FLAG_LZ;
+                }
+            }
+            input.Entry.Size = input.Blob.size();
+            inputs.push_back(std::move(input));
+        }
+        if (ec)
+        {
+            std::cout << "ERROR::ASSETPACKER: Could not scan " << folder << ": " << ec.message() << std::endl;
+            return 1;
+        }
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const PackInput &a, const PackInput &b) {
+        return a.Entry.NameHash != b.Entry.NameHash ? a.Entry.NameHash < b.Entry.NameHash : a.Name < b.Name;
+    });
+
+    // lay out header, index, names and 64-byte aligned blobs
+    auto align = [](uint64_t offset) { return (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT; };
+    PackHeader header = {};
+    std::memcpy(header.Magic, PACK_MAGIC, 4);
+    header.Version = PACK_VERSION;
+    header.EntryCount = static_cast<uint32_t>(inputs.size());
+    header.IndexOffset = align(sizeof(PackHeader));
+    header.NameTableOffset = header.IndexOffset + inputs.size() * sizeof(PackEntry);
+    std::string names;
+    for (PackInput &input : inputs)
+    {
+        input.Entry.NameOffset = static_cast<uint32_t>(names.size());
+        input.Entry.NameLength = static_cast<uint16_t>(input.Name.size());
+        names += input.Name;
+    }
+    header.NameTableSize = static_cast<uint32_t>(names.size());
+    uint64_t offset = align(header.NameTableOffset + names.size());
+    for (PackInput &input : inputs)
+    {
+        input.Entry.Offset = offset;
+        offset = align(offset + input.Blob.size());
+    }
+
+    // write
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cout << "ERROR::ASSETPACKER: Could not create " << output << std::endl;
+        return 1;
+    }
+    auto padTo = [&](uint64_t target) {
+        static const char zeros[PACK_ALIGNMENT] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        if (target > position)
+            out.write(zeros, static_cast<std::streamsize>(target - position));
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(PackHeader));
+    padTo(header.IndexOffset);
+    for (const PackInput &input : inputs)
+        out.write(reinterpret_cast<const char*>(&input.Entry), sizeof(PackEntry));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+    uint64_t rawTotal = 0;
+    for (const PackInput &input : inputs)
+    {
+        padTo(input.Entry.Offset);
+        out.write(reinterpret_cast<const char*>(input.Blob.data()), static_cast<std::streamsize>(input.Blob.size()));
+        rawTotal += input.Entry.RawSize;
+        std::cout << (input.Entry.Flags & PACK_FLAG_LZ ? "  [lz] " : "       ") << input.Name
+                  << " " << input.Entry.RawSize << " -> " << input.Entry.Size << std::endl;
+    }
+    padTo(offset);
+    if (!out)
+    {
+        std::cout << "ERROR::ASSETPACKER: Failed writing " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Packed " << inputs.size() << " assets (" << rawTotal << " bytes) into " << output
+              << " (" << offset << " bytes)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,134 @@
+#ifndef AUDIO_IRRKLANG_H
+#define AUDIO_IRRKLANG_H
+
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <irrKlang.h>
+
+#include "audio_mixer.h"
+
+
+// irrKlang is only used as a decoder (mp3/ogg) and as a device output for
+// the mixer; everything audible is mixed by AudioMixer.
+
+// decodes a compressed sound (mp3, ogg, ...) through an irrKlang engine without device (ESOD_NULL)
+inline bool DecodeWithIrrKlang(const unsigned char *data, size_t size, const char *name, AudioBuffer &out)
+{
+    static irrklang::ISoundEngine *decoder = irrklang::createIrrKlangDevice(irrklang::ESOD_NULL, 0);
+    if (!decoder)
+        return false;
+    irrklang::ISoundSource *source = decoder->addSoundSourceFromMemory(const_cast<unsigned char*>(data), static_cast<irrklang::ik_s32>(size), name, false);
+    if (!source)
+        return false;
+    // decode everything at once, irrKlang would otherwise stream files over ~1 MB
+    source->setForcedStreamingThreshold(0);
+    source->setStreamMode(irrklang::ESM_NO_STREAMING);
+    const unsigned char *pcm = static_cast<const unsigned char*>(source->getSampleData());
+    irrklang::SAudioStreamFormat format = source->getAudioFormat();
+    bool ok = pcm && format.FrameCount > 0 && format.ChannelCount >= 1 && format.ChannelCount <= 2;
+    if (ok)
+        ConvertPCM(pcm, format.FrameCount, format.ChannelCount, format.SampleFormat == irrklang::ESF_U8 ? 8 : 16, false,
+                   format.SampleRate, AudioMixer::SAMPLE_RATE, out);
+    decoder->removeSoundSource(source);
+    return ok;
+}
+
+// Plays the mixer through an irrKlang device: irrKlang streams an endless
+// IAudioStream whose frames are pulled from AudioMixer on irrKlang's thread.
+class IrrKlangAudioOutput : public AudioOutput
+{
+public:
+    ~IrrKlangAudioOutput() override { this->Stop(); }
+    bool Start(AudioMixer &mixer) override
+    {
+        this->Stop();
+        this->engine = irrklang::createIrrKlangDevice();
+        if (!this->engine)
+            return false;
+        // a loader for a made-up extension hands irrKlang our stream when it opens "mixer.bbmix"
+        StreamLoader *loader = new StreamLoader(mixer);
+        this->engine->registerAudioStreamLoader(loader);
+        loader->drop();
+        static const char placeholder[] = "BBMX";
+        irrklang::ISoundSource *source = this->engine->addSoundSourceFromMemory(const_cast<char*>(placeholder), sizeof(placeholder), "mixer.bbmix", true);
+        if (source)
+        {
+            source->setStreamMode(irrklang::ESM_STREAMING);
+            this->sound = this->engine->play2D(source, false, false, true);
+        }
+        if (!this->sound)
+        {
+            std::cout << "ERROR::AUDIO: irrKlang could not play the mixer stream" << std::endl;
+            this->Stop();
+            return false;
+        }
+        return true;
+    }
+    void Stop() override
+    {
+        if (this->sound)
+        {
+            this->sound->stop();
+            this->sound->drop();
+            this->sound = nullptr;
+        }
+        if (this->engine)
+        {
+            this->engine->drop();
+            this->engine = nullptr;
+        }
+    }
+    const char *Name() const override { return "irrklang"; }
+
+private:
+    class MixerStream : public irrklang::IAudioStream
+    {
+    public:
+        explicit MixerStream(AudioMixer &mixer) : mixer(mixer) { }
+        irrklang::SAudioStreamFormat getFormat() override
+        {
+            irrklang::SAudioStreamFormat format;
+            format.ChannelCount = 2;
+            format.FrameCount = -1; // endless
+            format.SampleRate = AudioMixer::SAMPLE_RATE;
+            format.SampleFormat = irrklang::ESF_S16;
+            return format;
+        }
+        bool setPosition(irrklang::ik_s32 pos) override { (void)pos; return true; }
+        bool getIsSeekingSupported() override { return false; }
+        irrklang::ik_s32 readFrames(void *target, irrklang::ik_s32 frameCountToRead) override
+        {
+            Tracer::NameThread("audio");
+            TRACE_SCOPE("mix");
+            this->mixer.MixInt16(static_cast<int16_t*>(target), static_cast<size_t>(frameCountToRead));
+            return frameCountToRead;
+        }
+
+    private:
+        AudioMixer &mixer;
+    };
+    class StreamLoader : public irrklang::IAudioStreamLoader
+    {
+    public:
+        explicit StreamLoader(AudioMixer &mixer) : mixer(mixer) { }
+        bool isALoadableFileExtension(const irrklang::ik_c8 *fileName) override
+        {
+            size_t length = std::strlen(fileName);
+            return length >= 6 && std::strcmp(fileName + length - 6, ".bbmix") == 0;
+        }
+        irrklang::IAudioStream *createAudioStream(irrklang::IFileReader *file) override
+        {
+            (void)file;
+            return new MixerStream(this->mixer);
+        }
+
+    private:
+        AudioMixer &mixer;
+    };
+
+    irrklang::ISoundEngine *engine = nullptr;
+    irrklang::ISound *sound = nullptr;
+};
+
+#endif
@@ -0,0 +1,620 @@
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "tracer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MIXER_SSE2 1
+#endif
+
+
+// Decoded PCM clip, 16-bit stereo interleaved at the mixer rate. Buffers are
+// immutable once handed to the mixer and must outlive every voice playing them.
+struct AudioBuffer {
+    std::vector<int16_t> Samples; // left, right, left, right, ...
+
+    size_t Frames() const { return this->Samples.size() / 2; }
+    bool IsValid() const { return !this->Samples.empty(); }
+};
+
+// converts interleaved integer or float PCM (1 or 2 channels, any rate) into a stereo AudioBuffer at targetRate
+inline void ConvertPCM(const unsigned char *data, size_t frames, int channels, int bitsPerSample, bool isFloat,
+                       int sourceRate, int targetRate, AudioBuffer &out)
+{
+    auto sample = [&](size_t frame, int channel) -> float {
+        const unsigned char *p = data + (frame * channels + std::min(channel, channels - 1)) * (bitsPerSample / 8);
+        switch (bitsPerSample)
+        {
+        case 8:  return (p[0] - 128) / 128.0f;
+        case 16: return int16_t(p[0] | (p[1] << 8)) / 32768.0f;
+        case 24: return int32_t(uint32_t(p[0] << 8 | p[1] << 16 | p[2] << 24)) / 2147483648.0f;
+        default:
+            if (isFloat)
+            {
+                float value;
+                std::memcpy(&value, p, 4);
+                return value;
+            }
+            return int32_t(uint32_t(p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24)) / 2147483648.0f;
+        }
+    };
+    // linear interpolation is enough for effects recorded at 22-48 kHz
+    double step = double(sourceRate) / targetRate;
+    size_t outFrames = frames == 0 ? 0 : size_t(std::floor((frames - 1) / step)) + 1;
+    out.Samples.resize(outFrames * 2);
+    for (size_t i = 0; i < outFrames; ++i)
+    {
+        double position = i * step;
+        size_t index = size_t(position);
+        float t = float(position - index);
+        size_t next = std::min(index + 1, frames - 1);
+        for (int c = 0; c < 2; ++c)
+        {
+            float value = sample(index, c) * (1.0f - t) + sample(next, c) * t;
+            out.Samples[i * 2 + c] = int16_t(std::max(-32768.0f, std::min(32767.0f, value * 32768.0f)));
+        }
+    }
+}
+
+// decodes a RIFF WAVE file (PCM 8/16/24/32 bit or 32-bit float) into out, false for other formats
+inline bool DecodeWav(const unsigned char *data, size_t size, int targetRate, AudioBuffer &out)
+{
+    auto u16 = [&](size_t at) { return uint32_t(data[at] | data[at + 1] << 8); };
+    auto u32 = [&](size_t at) { return uint32_t(data[at] | data[at + 1] << 8 | data[at + 2] << 16 | uint32_t(data[at + 3]) << 24); };
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+    int format = 0, channels = 0, rate = 0, bits = 0;
+    for (size_t at = 12; at + 8 <= size; )
+    {
+        uint32_t chunk = u32(at + 4);
+        size_t body = at + 8;
+        if (std::memcmp(data + at, "fmt ", 4) == 0 && chunk >= 16 && body + 16 <= size)
+        {
+            format = u16(body);
+            channels = u16(body + 2);
+            rate = u32(body + 4);
+            bits = u16(body + 14);
+            if (format == 0xFFFE && chunk >= 26) // WAVE_FORMAT_EXTENSIBLE, the sub format starts with the real tag
+                format = u16(body + 24);
+        }
+        else if (std::memcmp(data + at, "data", 4) == 0)
+        {
+            bool isFloat = format == 3;
+            if ((format != 1 && !isFloat) || channels < 1 || channels > 2 || rate <= 0 ||
+                (bits != 8 && bits != 16 && bits != 24 && bits != 32) || (isFloat && bits != 32))
+                return false;
+            size_t bytes = std::min<size_t>(chunk, size - body);
+            ConvertPCM(data + body, bytes / (channels * bits / 8), channels, bits, isFloat, rate, targetRate, out);
+            return true;
+        }
+        at = body + chunk + (chunk & 1);
+    }
+    return false;
+}
+
+// writes 16-bit stereo samples as a WAV file
+inline bool WriteWav(const char *path, const int16_t *samples, size_t frames, int sampleRate)
+{
+    std::FILE *file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+    auto put32 = [&](uint32_t value) { unsigned char b[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) }; std::fwrite(b, 1, 4, file); };
+    auto put16 = [&](uint16_t value) { unsigned char b[2] = { uint8_t(value), uint8_t(value >> 8) }; std::fwrite(b, 1, 2, file); };
+    uint32_t bytes = uint32_t(frames * 4);
+    std::fwrite("RIFF", 1, 4, file); put32(36 + bytes); std::fwrite("WAVEfmt ", 1, 8, file);
+    put32(16); put16(1); put16(2); put32(sampleRate); put32(sampleRate * 4); put16(4); put16(16);
+    std::fwrite("data", 1, 4, file); put32(bytes);
+    // samples are stored little endian like the host on every platform we build for
+    bool ok = std::fwrite(samples, 4, frames, file) == frames;
+    return std::fclose(file) == 0 && ok;
+}
+
+// Single-producer single-consumer ring buffer, Capacity must be a power of two.
+// Push runs on the game thread, Pop on the mixer thread, neither blocks.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+public:
+    bool Push(const T &item)
+    {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - this->head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        this->items[tail & (Capacity - 1)] = item;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    bool Pop(T &item)
+    {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == this->tail.load(std::memory_order_acquire))
+            return false;
+        item = this->items[head & (Capacity - 1)];
+        this->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    T items[Capacity];
+    std::atomic<size_t> head{ 0 }, tail{ 0 };
+};
+
+typedef uint32_t VoiceId; // 0 = no voice
+
+// Audio produced while playing (streamed music), pulled by the mixer on the
+// output thread. Read must not block: it returns fewer frames than asked
+// when nothing more is ready yet.
+class AudioStream
+{
+public:
+    virtual ~AudioStream() { }
+    // output thread: writes up to frames of 16-bit stereo at the mixer rate, returns how many
+    virtual size_t Read(int16_t *out, size_t frames) = 0;
+    // true once Read will never return anything again
+    virtual bool Finished() const = 0;
+};
+
+// AudioMixer plays AudioBuffers and AudioStreams on a fixed set of voices and mixes them into
+// 16-bit stereo. The game thread only enqueues commands (Play, Stop, SetVolume),
+// the output thread drains them at the start of each Mix call, so the two never
+// share a lock. Volume and pan changes are ramped over a few milliseconds to
+// avoid clicks. The inner loops use SSE2 when available.
+class AudioMixer
+{
+public:
+    static constexpr int SAMPLE_RATE = 44100;
+    static constexpr unsigned int MAX_VOICES = 32;
+
+    AudioMixer()
+    {
+        for (std::atomic<VoiceId> &id : this->playing)
+            id.store(0, std::memory_order_relaxed);
+    }
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer &operator=(const AudioMixer&) = delete;
+
+    // game thread: starts buffer, pan in [-1, 1], fading in over fadeIn seconds
+    VoiceId Play(const AudioBuffer *buffer, float volume = 1.0f, float pan = 0.0f, bool loop = false, float fadeIn = 0.0f)
+    {
+        if (!buffer || !buffer->IsValid())
+            return 0;
+        VoiceId id = ++this->nextId;
+        if (id == 0)
+            id = ++this->nextId;
+        Command command = { Command::PLAY, id, buffer, nullptr, volume, pan, rampFrames(fadeIn), loop };
+        return this->commands.Push(command) ? id : 0;
+    }
+    // game thread: starts stream, which must outlive the voice (until IsPlaying returns false);
+    // stream voices are never stolen for new sounds
+    VoiceId PlayStream(AudioStream *stream, float volume = 1.0f, float pan = 0.0f, float fadeIn = 0.0f)
+    {
+        if (!stream)
+            return 0;
+        VoiceId id = ++this->nextId;
+        if (id == 0)
+            id = ++this->nextId;
+        Command command = { Command::PLAY, id, nullptr, stream, volume, pan, rampFrames(fadeIn), false };
+        return this->commands.Push(command) ? id : 0;
+    }
+    // game thread: fades a voice out over fadeOut seconds and releases it
+    void Stop(VoiceId voice, float fadeOut = 0.005f)
+    {
+        Command command = { Command::STOP, voice, nullptr, nullptr, 0.0f, 0.0f, rampFrames(fadeOut), false };
+        this->commands.Push(command);
+    }
+    // game thread: ramps the volume and pan of a voice over seconds
+    void SetVolume(VoiceId voice, float volume, float pan = 0.0f, float seconds = 0.005f)
+    {
+        Command command = { Command::SET_GAIN, voice, nullptr, nullptr, volume, pan, rampFrames(seconds), false };
+        this->commands.Push(command);
+    }
+    // game thread: fades out every voice
+    void StopAll(float fadeOut = 0.005f)
+    {
+        Command command = { Command::STOP_ALL, 0, nullptr, nullptr, 0.0f, 0.0f, rampFrames(fadeOut), false };
+        this->commands.Push(command);
+    }
+    // any thread: whether the voice is still audible (as of the last mixed block);
+    // a voice whose Play was not picked up by the mixer yet counts as playing
+    bool IsPlaying(VoiceId voice) const
+    {
+        if (voice > this->applied.load(std::memory_order_acquire))
+            return true;
+        for (const std::atomic<VoiceId> &id : this->playing)
+            if (voice != 0 && id.load(std::memory_order_relaxed) == voice)
+                return true;
+        return false;
+    }
+    unsigned int ActiveVoices() const
+    {
+        unsigned int count = 0;
+        for (const std::atomic<VoiceId> &id : this->playing)
+            count += id.load(std::memory_order_relaxed) != 0;
+        return count;
+    }
+    // frames mixed since construction
+    uint64_t MixedFrames() const { return this->mixedFrames.load(std::memory_order_relaxed); }
+    // blocks in which a stream could not deliver all frames in time
+    uint64_t Underruns() const { return this->underruns.load(std::memory_order_relaxed); }
+
+    // output thread: mixes frames of stereo float into out (overwritten)
+    void Mix(float *out, size_t frames)
+    {
+        this->applyCommands();
+        std::fill(out, out + frames * 2, 0.0f);
+        for (unsigned int i = 0; i < MAX_VOICES; ++i)
+        {
+            Voice &voice = this->voices[i];
+            if (voice.Stream)
+            {
+                if (this->streamed.size() < frames * 2)
+                    this->streamed.resize(frames * 2);
+                size_t count = voice.Stream->Read(this->streamed.data(), frames);
+                bool finished = count < frames && voice.Stream->Finished();
+                if (count < frames && !finished)
+                    this->underruns.fetch_add(1, std::memory_order_relaxed);
+                this->mixFrames(i, this->streamed.data(), out, count);
+                if (finished && voice.Stream)
+                    this->release(i);
+                continue;
+            }
+            size_t done = 0;
+            while (done < frames && voice.Buffer)
+            {
+                size_t count = std::min(frames - done, voice.Buffer->Frames() - voice.Position);
+                this->mixFrames(i, voice.Buffer->Samples.data() + voice.Position * 2, out + done * 2, count);
+                if (!voice.Buffer)
+                    break;
+                done += count;
+                voice.Position += count;
+                if (voice.Position >= voice.Buffer->Frames())
+                {
+                    if (voice.Loop)
+                        voice.Position = 0;
+                    else
+                        this->release(i);
+                }
+            }
+        }
+        this->mixedFrames.fetch_add(frames, std::memory_order_relaxed);
+    }
+    // output thread: mixes frames of 16-bit stereo into out, scratch is reused between calls
+    void MixInt16(int16_t *out, size_t frames)
+    {
+        if (this->scratch.size() < frames * 2)
+            this->scratch.resize(frames * 2);
+        this->Mix(this->scratch.data(), frames);
+        FloatToInt16(this->scratch.data(), out, frames * 2);
+    }
+    // clamps and converts samples in [-1, 1] to 16 bit
+    static void FloatToInt16(const float *in, int16_t *out, size_t count)
+    {
+        size_t i = 0;
+#ifdef AUDIO_MIXER_SSE2
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        const __m128 low = _mm_set1_ps(-1.0f), high = _mm_set1_ps(1.0f);
+        for (size_t end = count & ~size_t(7); i < end; i += 8)
+        {
+            // clamp like the scalar path, cvtps rounds to nearest
+            __m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high), scale));
+            __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), low), high), scale));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+        }
+#endif
+        for (; i < count; ++i)
+            out[i] = int16_t(std::lrint(std::max(-1.0f, std::min(1.0f, in[i])) * 32767.0f));
+    }
+
+private:
+    struct Command {
+        enum Type { PLAY, STOP, SET_GAIN, STOP_ALL } Kind;
+        VoiceId Id;
+        const AudioBuffer *Buffer;
+        AudioStream *Stream;
+        float Volume, Pan;
+        uint32_t RampFrames;
+        bool Loop;
+    };
+    struct Voice {
+        const AudioBuffer *Buffer = nullptr;
+        AudioStream *Stream = nullptr; // set instead of Buffer for streamed voices
+        size_t Position = 0;
+        bool Loop = false, Stopping = false;
+        float GainL = 0.0f, GainR = 0.0f;     // current gains
+        float TargetL = 0.0f, TargetR = 0.0f; // gains at the end of the ramp
+        float StepL = 0.0f, StepR = 0.0f;     // per-frame gain change while ramping
+        uint32_t RampLeft = 0;
+    };
+
+    SpscQueue<Command, 256> commands;
+    Voice voices[MAX_VOICES];
+    std::atomic<VoiceId> playing[MAX_VOICES]; // ids of the voices, published for IsPlaying
+    VoiceId nextId = 0;
+    std::atomic<VoiceId> applied{ 0 }; // id of the last Play the mixer has processed
+    std::atomic<uint64_t> mixedFrames{ 0 };
+    std::atomic<uint64_t> underruns{ 0 };
+    std::vector<float> scratch;
+    std::vector<int16_t> streamed; // frames read from a stream voice
+
+    static uint32_t rampFrames(float seconds)
+    {
+        // never switch gains instantly, a 64 frame ramp (1.5 ms) removes the click
+        return std::max<uint32_t>(64, uint32_t(std::max(0.0f, seconds) * SAMPLE_RATE));
+    }
+    static void panGains(float volume, float pan, float &left, float &right)
+    {
+        // constant power pan law
+        float angle = (std::max(-1.0f, std::min(1.0f, pan)) + 1.0f) * 0.25f * 3.14159265f;
+        left = volume * std::cos(angle) * 1.41421356f;
+        right = volume * std::sin(angle) * 1.41421356f;
+        left = std::min(left, volume);
+        right = std::min(right, volume);
+    }
+    int find(VoiceId id) const
+    {
+        for (unsigned int i = 0; i < MAX_VOICES; ++i)
+            if ((this->voices[i].Buffer || this->voices[i].Stream) && this->playing[i].load(std::memory_order_relaxed) == id)
+                return int(i);
+        return -1;
+    }
+    void ramp(Voice &voice, float left, float right, uint32_t frames)
+    {
+        voice.TargetL = left;
+        voice.TargetR = right;
+        voice.RampLeft = frames;
+        voice.StepL = (left - voice.GainL) / frames;
+        voice.StepR = (right - voice.GainR) / frames;
+    }
+    void release(unsigned int index)
+    {
+        this->voices[index] = Voice();
+        this->playing[index].store(0, std::memory_order_relaxed);
+    }
+    void applyCommands()
+    {
+        Command command;
+        while (this->commands.Pop(command))
+        {
+            if (command.Kind == Command::PLAY)
+            {
+                // take a free voice, or steal the quietest buffer voice when all are busy
+                int slot = -1;
+                float quietest = 1e9f;
+                for (unsigned int i = 0; i < MAX_VOICES && slot < 0; ++i)
+                    if (!this->voices[i].Buffer && !this->voices[i].Stream)
+                        slot = int(i);
+                for (unsigned int i = 0; i < MAX_VOICES && slot < 0; ++i)
+                    if (!this->voices[i].Stream)
+                        quietest = std::min(quietest, this->voices[i].TargetL + this->voices[i].TargetR);
+                for (unsigned int i = 0; i < MAX_VOICES && slot < 0; ++i)
+                    if (!this->voices[i].Stream && this->voices[i].TargetL + this->voices[i].TargetR == quietest)
+                        slot = int(i);
+                // a dropped play (every voice streaming) is processed too, IsPlaying must not wait for it
+                if (slot < 0)
+                {
+                    this->applied.store(command.Id, std::memory_order_release);
+                    continue;
+                }
+                Voice &voice = this->voices[slot];
+                voice = Voice();
+                voice.Buffer = command.Buffer;
+                voice.Stream = command.Stream;
+                voice.Loop = command.Loop;
+                float left, right;
+                panGains(command.Volume, command.Pan, left, right);
+                this->ramp(voice, left, right, command.RampFrames);
+                this->playing[slot].store(command.Id, std::memory_order_relaxed);
+                this->applied.store(command.Id, std::memory_order_release);
+            }
+            else if (command.Kind == Command::STOP_ALL)
+            {
+                for (Voice &voice : this->voices)
+                    if (voice.Buffer || voice.Stream)
+                    {
+                        voice.Stopping = true;
+                        this->ramp(voice, 0.0f, 0.0f, command.RampFrames);
+                    }
+            }
+            else
+            {
+                int slot = this->find(command.Id);
+                if (slot < 0)
+                    continue;
+                Voice &voice = this->voices[slot];
+                if (command.Kind == Command::STOP)
+                {
+                    voice.Stopping = true;
+                    this->ramp(voice, 0.0f, 0.0f, command.RampFrames);
+                }
+                else
+                {
+                    float left, right;
+                    panGains(command.Volume, command.Pan, left, right);
+                    this->ramp(voice, left, right, command.RampFrames);
+                }
+            }
+        }
+    }
+    // mixes count frames of in through voice index, splitting at the end of a ramp;
+    // a voice that finished fading out is released on the way
+    void mixFrames(unsigned int index, const int16_t *in, float *out, size_t count)
+    {
+        Voice &voice = this->voices[index];
+        size_t done = 0;
+        while (done < count)
+        {
+            size_t part = count - done;
+            if (voice.RampLeft > 0)
+                part = std::min<size_t>(part, voice.RampLeft);
+            mixVoice(voice, in + done * 2, out + done * 2, part);
+            done += part;
+            if (voice.RampLeft > 0 && (voice.RampLeft -= uint32_t(part)) == 0)
+            {
+                voice.GainL = voice.TargetL;
+                voice.GainR = voice.TargetR;
+                if (voice.Stopping)
+                {
+                    this->release(index);
+                    return;
+                }
+            }
+        }
+    }
+    // adds count frames of in into out with the gains of voice, ramping them when RampLeft > 0
+    static void mixVoice(Voice &voice, const int16_t *in, float *out, size_t count)
+    {
+        float stepL = voice.RampLeft > 0 ? voice.StepL : 0.0f;
+        float stepR = voice.RampLeft > 0 ? voice.StepR : 0.0f;
+        size_t i = 0;
+#ifdef AUDIO_MIXER_SSE2
+        // two stereo frames per iteration: gains (L0, R0, L1, R1), advanced by two frames of ramp
+        const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+        __m128 gain = _mm_setr_ps(voice.GainL, voice.GainR, voice.GainL + stepL, voice.GainR + stepR);
+        const __m128 step = _mm_setr_ps(2.0f * stepL, 2.0f * stepR, 2.0f * stepL, 2.0f * stepR);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+            // sign-extend the 8 int16 samples into two vectors of 4 floats
+            __m128 low = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)), scale);
+            __m128 high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16)), scale);
+            _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(low, gain)));
+            gain = _mm_add_ps(gain, step);
+            _mm_storeu_ps(out + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(out + i * 2 + 4), _mm_mul_ps(high, gain)));
+            gain = _mm_add_ps(gain, step);
+        }
+        float gains[4];
+        _mm_storeu_ps(gains, gain);
+        voice.GainL = gains[0];
+        voice.GainR = gains[1];
+#endif
+        for (; i < count; ++i)
+        {
+            out[i * 2] += in[i * 2] * (1.0f / 32768.0f) * voice.GainL;
+            out[i * 2 + 1] += in[i * 2 + 1] * (1.0f / 32768.0f) * voice.GainR;
+            voice.GainL += stepL;
+            voice.GainR += stepR;
+        }
+    }
+};
+
+// Where mixed audio goes. An output pulls blocks from the mixer on its own
+// thread (or, for offline outputs, when asked to) until stopped.
+class AudioOutput
+{
+public:
+    virtual ~AudioOutput() { }
+    virtual bool Start(AudioMixer &mixer) = 0;
+    virtual void Stop() = 0;
+    virtual const char *Name() const = 0;
+};
+
+// Mixes in real time and discards the result: keeps voices progressing on
+// machines without a sound device (headless runs, CI).
+class NullAudioOutput : public AudioOutput
+{
+public:
+    ~NullAudioOutput() override { this->Stop(); }
+    bool Start(AudioMixer &mixer) override
+    {
+        this->Stop();
+        this->running = true;
+        this->thread = std::thread([this, &mixer]() {
+            Tracer::NameThread("audio");
+            this->run(mixer);
+        });
+        return true;
+    }
+    void Stop() override
+    {
+        this->running = false;
+        if (this->thread.joinable())
+            this->thread.join();
+    }
+    const char *Name() const override { return "null"; }
+
+protected:
+    static constexpr size_t BLOCK_FRAMES = 512;
+    std::atomic<bool> running{ false };
+    std::thread thread;
+
+    virtual void consume(const int16_t *samples, size_t frames) { (void)samples; (void)frames; }
+    void run(AudioMixer &mixer)
+    {
+        std::vector<int16_t> block(BLOCK_FRAMES * 2);
+        auto next = std::chrono::steady_clock::now();
+        const auto period = std::chrono::microseconds(BLOCK_FRAMES * 1000000 / AudioMixer::SAMPLE_RATE);
+        while (this->running)
+        {
+            {
+                TRACE_SCOPE("mix");
+                mixer.MixInt16(block.data(), BLOCK_FRAMES);
+            }
+            this->consume(block.data(), BLOCK_FRAMES);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+};
+
+// Records everything the mixer produces into a WAV file: in real time like
+// the null output, or offline through Render when constructed with realtime = false.
+class WavFileAudioOutput : public NullAudioOutput
+{
+public:
+    WavFileAudioOutput(const std::string &path, bool realtime = true) : path(path), realtime(realtime) { }
+    ~WavFileAudioOutput() override { this->Stop(); }
+    bool Start(AudioMixer &mixer) override
+    {
+        this->mixer = &mixer;
+        this->recorded.clear();
+        return this->realtime ? NullAudioOutput::Start(mixer) : true;
+    }
+    // offline mode: mixes frames right away
+    void Render(size_t frames)
+    {
+        if (!this->mixer)
+            return;
+        size_t offset = this->recorded.size();
+        this->recorded.resize(offset + frames * 2);
+        this->mixer->MixInt16(this->recorded.data() + offset, frames);
+    }
+    // stops recording and writes the file
+    void Stop() override
+    {
+        NullAudioOutput::Stop();
+        if (!this->mixer)
+            return;
+        if (!WriteWav(this->path.c_str(), this->recorded.data(), this->recorded.size() / 2, AudioMixer::SAMPLE_RATE))
+            std::cout << "ERROR::AUDIO: Failed to write " << this->path << std::endl;
+        this->mixer = nullptr;
+    }
+    const char *Name() const override { return "wav"; }
+    const std::vector<int16_t> &Recorded() const { return this->recorded; }
+
+private:
+    std::string path;
+    bool realtime;
+    AudioMixer *mixer = nullptr;
+    std::vector<int16_t> recorded;
+
+    void consume(const int16_t *samples, size_t frames) override
+    {
+        this->recorded.insert(this->recorded.end(), samples, samples + frames * 2);
+    }
+};
+
+#endif
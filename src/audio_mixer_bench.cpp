@@ -0,0 +1,353 @@
+// audio_mixer_bench - measures and checks the software mixer without a sound device.
+//
+//   audio_mixer_bench [--voices <n>] [--seconds <s>] [--wav <file>] [--check]
+//
+// Plays n looping synthesized tones (default 32, the mixer's voice limit)
+// and mixes s seconds of audio (default 10) as fast as possible, then prints
+// the cost per voice and frame and how many times faster than real time the
+// mix ran. With --wav the mix is also rendered offline into a WAV file.
+// --check runs the self-checks instead (gain and pan law, ramps, stop and
+// voice stealing, WAV round trip, sample conversion, ADPCM quality, gapless
+// music loops and crossfades) and fails on any mismatch, so it can run on
+// CPU-only machines. Needs only the standard library.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio_mixer.h"
+#include "music_stream.h"
+
+// a stereo sine of the given length, left and right a fifth apart
+static AudioBuffer makeTone(float frequency, float seconds, float amplitude)
+{
+    AudioBuffer buffer;
+    size_t frames = size_t(seconds * AudioMixer::SAMPLE_RATE);
+    buffer.Samples.resize(frames * 2);
+    for (size_t i = 0; i < frames; ++i)
+    {
+        float t = float(i) / AudioMixer::SAMPLE_RATE;
+        buffer.Samples[i * 2] = int16_t(std::lrint(std::sin(6.2831853f * frequency * t) * amplitude * 32767.0f));
+        buffer.Samples[i * 2 + 1] = int16_t(std::lrint(std::sin(6.2831853f * frequency * 1.5f * t) * amplitude * 32767.0f));
+    }
+    return buffer;
+}
+
+static int failures = 0;
+
+// music opener for the checks: streams loose WAV files
+static std::unique_ptr<MusicDecoder> openWav(const std::string &file)
+{
+    std::unique_ptr<WavStreamDecoder> decoder(new WavStreamDecoder());
+    if (!decoder->Mapping.Open(file.c_str()) || !decoder->Open(decoder->Mapping.Data(), decoder->Mapping.Size()))
+        return nullptr;
+    return decoder;
+}
+
+// lets the music thread buffer the requested tracks and starts them
+static void startMusic(MusicPlayer &player)
+{
+    for (int i = 0; i < 50; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        player.Update();
+    }
+}
+
+static void expect(bool condition, const char *what)
+{
+    std::cout << (condition ? "  ok    " : "  FAIL  ") << what << std::endl;
+    if (!condition)
+        ++failures;
+}
+
+static int runChecks()
+{
+    const size_t block = 1024;
+    std::vector<float> out(block * 2);
+
+    // a centred voice at volume 0.5 scales both channels by 0.5 once the start ramp is over
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.1f, 0.8f);
+        mixer.Play(&tone, 0.5f);
+        mixer.Mix(out.data(), block);
+        float error = 0.0f;
+        for (size_t i = 64; i < block; ++i)
+            for (int c = 0; c < 2; ++c)
+                error = std::max(error, std::fabs(out[i * 2 + c] - tone.Samples[i * 2 + c] / 32768.0f * 0.5f));
+        expect(error < 1e-4f, "centred voice at volume 0.5 halves both channels");
+        expect(std::fabs(out[0]) < 1e-6f, "start ramp begins at silence");
+        expect(mixer.ActiveVoices() == 1, "voice counted as active");
+    }
+    // hard left pan keeps the full level on the left and silences the right
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.1f, 0.8f);
+        mixer.Play(&tone, 1.0f, -1.0f);
+        mixer.Mix(out.data(), block);
+        float left = 0.0f, right = 0.0f;
+        for (size_t i = 64; i < block; ++i)
+        {
+            left = std::max(left, std::fabs(out[i * 2] - tone.Samples[i * 2] / 32768.0f));
+            right = std::max(right, std::fabs(out[i * 2 + 1]));
+        }
+        expect(left < 1e-4f && right < 1e-4f, "hard left pan");
+    }
+    // a stopped voice fades out over the requested time and is released
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 1.0f, 0.8f);
+        VoiceId voice = mixer.Play(&tone, 1.0f, 0.0f, true);
+        mixer.Mix(out.data(), block);
+        mixer.Stop(voice, 0.01f); // 441 frames
+        mixer.Mix(out.data(), block);
+        float tail = 0.0f;
+        for (size_t i = 441; i < block; ++i)
+            tail = std::max(tail, std::fabs(out[i * 2]) + std::fabs(out[i * 2 + 1]));
+        expect(tail == 0.0f && !mixer.IsPlaying(voice), "stop fades out and releases the voice");
+    }
+    // a one-shot voice ends by itself, a looping one wraps around
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.01f, 0.8f);
+        VoiceId once = mixer.Play(&tone);
+        VoiceId looped = mixer.Play(&tone, 1.0f, 0.0f, true);
+        mixer.Mix(out.data(), block);
+        expect(!mixer.IsPlaying(once) && mixer.IsPlaying(looped), "one-shot ends, loop continues");
+    }
+    // playing beyond the voice limit steals the quietest voice
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.5f, 0.8f);
+        VoiceId quiet = mixer.Play(&tone, 0.1f);
+        for (unsigned int i = 1; i < AudioMixer::MAX_VOICES; ++i)
+            mixer.Play(&tone, 0.5f);
+        mixer.Mix(out.data(), block);
+        VoiceId extra = mixer.Play(&tone, 0.5f);
+        mixer.Mix(out.data(), block);
+        expect(!mixer.IsPlaying(quiet) && mixer.IsPlaying(extra) &&
+               mixer.ActiveVoices() == AudioMixer::MAX_VOICES, "voice limit steals the quietest voice");
+    }
+    // stream voices are never stolen: a play with every voice streaming is dropped and not reported as playing
+    {
+        struct Silence : AudioStream {
+            size_t Read(int16_t *samples, size_t frames) override { std::fill(samples, samples + frames * 2, int16_t(0)); return frames; }
+            bool Finished() const override { return false; }
+        } silence;
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.5f, 0.8f);
+        for (unsigned int i = 0; i < AudioMixer::MAX_VOICES; ++i)
+            mixer.PlayStream(&silence);
+        mixer.Mix(out.data(), block);
+        VoiceId dropped = mixer.Play(&tone);
+        mixer.Mix(out.data(), block);
+        expect(!mixer.IsPlaying(dropped) && mixer.ActiveVoices() == AudioMixer::MAX_VOICES, "play with every voice streaming is dropped");
+        mixer.StopAll();
+    }
+    // volume changes ramp instead of jumping
+    {
+        AudioMixer mixer;
+        AudioBuffer dc;
+        dc.Samples.assign(AudioMixer::SAMPLE_RATE * 2, 16384);
+        VoiceId voice = mixer.Play(&dc, 1.0f);
+        mixer.Mix(out.data(), block);
+        mixer.SetVolume(voice, 0.0f, 0.0f, 0.01f);
+        mixer.Mix(out.data(), block);
+        float jump = 0.0f;
+        for (size_t i = 1; i < block; ++i)
+            jump = std::max(jump, std::fabs(out[i * 2] - out[i * 2 - 2]));
+        expect(jump < 0.5f / 400.0f && out[(block - 1) * 2] == 0.0f, "volume change ramps without a step");
+    }
+    // float to 16 bit conversion rounds and saturates the same on the SIMD and scalar paths
+    {
+        float in[16] = { 0.0f, 0.5f, -0.5f, 1.0f, -1.0f, 2.0f, -2.0f, 1e-6f,
+                         0.25f, -0.25f, 0.999f, -0.999f, 3.0f, -3.0f, 0.1f, -0.1f };
+        int16_t converted[16];
+        AudioMixer::FloatToInt16(in, converted, 16);
+        bool same = true;
+        for (int i = 0; i < 16; ++i)
+            same = same && converted[i] == int16_t(std::lrint(std::max(-1.0f, std::min(1.0f, in[i])) * 32767.0f));
+        expect(same, "float to int16 conversion");
+    }
+    // WAV written by the output decodes back to the same samples
+    {
+        AudioMixer mixer;
+        AudioBuffer tone = makeTone(440.0f, 0.25f, 0.8f);
+        const char *path = "audio_mixer_check.wav";
+        {
+            WavFileAudioOutput output(path, false);
+            output.Start(mixer);
+            mixer.Play(&tone);
+            output.Render(tone.Frames() + 512);
+            output.Stop();
+        }
+        std::vector<unsigned char> bytes;
+        if (FILE *file = std::fopen(path, "rb"))
+        {
+            unsigned char chunk[4096];
+            size_t read;
+            while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0)
+                bytes.insert(bytes.end(), chunk, chunk + read);
+            std::fclose(file);
+        }
+        std::remove(path);
+        AudioBuffer decoded;
+        bool ok = DecodeWav(bytes.data(), bytes.size(), AudioMixer::SAMPLE_RATE, decoded) &&
+                  decoded.Frames() == tone.Frames() + 512;
+        for (size_t i = 64 * 2; ok && i < tone.Samples.size(); ++i)
+            ok = std::abs(decoded.Samples[i] - tone.Samples[i]) <= 1;
+        expect(ok, "offline WAV output round trip");
+    }
+    // 8-bit mono at 22050 Hz converts to stereo at the mixer rate
+    {
+        std::vector<unsigned char> mono(2205);
+        for (size_t i = 0; i < mono.size(); ++i)
+            mono[i] = (i / 50) % 2 ? 192 : 64;
+        AudioBuffer converted;
+        ConvertPCM(mono.data(), mono.size(), 1, 8, false, 22050, AudioMixer::SAMPLE_RATE, converted);
+        expect(converted.Frames() == 4409 && converted.Samples[0] == converted.Samples[1] &&
+               converted.Samples[0] < -16000, "8-bit mono resampled to 16-bit stereo");
+    }
+
+    // ADPCM keeps music recognisable at a quarter of the size
+    {
+        AudioBuffer tone = makeTone(440.0f, 1.0f, 0.5f);
+        const char *path = "audio_mixer_check_adpcm.wav";
+        bool written = WriteAdpcmWav(path, tone.Samples.data(), tone.Frames(), AudioMixer::SAMPLE_RATE);
+        std::unique_ptr<MusicDecoder> decoder = openWav(path);
+        double signal = 0.0, noise = 0.0;
+        size_t frames = 0;
+        std::vector<int16_t> chunk(1000 * 2);
+        for (size_t count; decoder && (count = decoder->Read(chunk.data(), 1000)) > 0; frames += count)
+            for (size_t i = 0; i < count * 2; ++i)
+            {
+                double expected = tone.Samples[frames * 2 + i];
+                signal += expected * expected;
+                noise += (chunk[i] - expected) * (chunk[i] - expected);
+            }
+        decoder.reset();
+        std::remove(path);
+        double snr = noise > 0.0 ? 10.0 * std::log10(signal / noise) : 99.0;
+        std::printf("  (ADPCM SNR %.1f dB)\n", snr);
+        expect(written && frames == tone.Frames() && snr > 25.0, "ADPCM round trip");
+    }
+    // a looping track streams across its end without a gap
+    {
+        AudioBuffer tone = makeTone(330.0f, 0.3f, 0.8f);
+        const char *path = "audio_mixer_check_loop.wav";
+        WriteWav(path, tone.Samples.data(), tone.Frames(), AudioMixer::SAMPLE_RATE);
+        AudioMixer mixer;
+        {
+            MusicPlayer player;
+            player.Start(mixer, openWav);
+            player.Play(path, 1.0f, 0.0f);
+            startMusic(player);
+            // two and a half loops, in output sized blocks while the music thread refills
+            size_t total = tone.Frames() * 5 / 2;
+            std::vector<float> mixed(total * 2);
+            for (size_t done = 0; done < total; done += 512)
+            {
+                mixer.Mix(mixed.data() + done * 2, std::min<size_t>(512, total - done));
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            float error = 0.0f;
+            for (size_t i = 64; i < total; ++i)
+                for (int c = 0; c < 2; ++c)
+                    error = std::max(error, std::fabs(mixed[i * 2 + c] - tone.Samples[(i % tone.Frames()) * 2 + c] / 32768.0f));
+            expect(error < 1e-4f && mixer.Underruns() == 0, "gapless music loop");
+            mixer.StopAll();
+            mixer.Mix(mixed.data(), 512);
+        }
+        std::remove(path);
+    }
+    // changing tracks fades one into the other and then frees the old one
+    {
+        AudioBuffer first, second;
+        first.Samples.assign(AudioMixer::SAMPLE_RATE * 2, 8192);
+        second.Samples.assign(AudioMixer::SAMPLE_RATE * 2, -8192);
+        WriteWav("audio_mixer_check_a.wav", first.Samples.data(), first.Frames(), AudioMixer::SAMPLE_RATE);
+        WriteWav("audio_mixer_check_b.wav", second.Samples.data(), second.Frames(), AudioMixer::SAMPLE_RATE);
+        AudioMixer mixer;
+        {
+            MusicPlayer player;
+            player.Start(mixer, openWav);
+            player.Play("audio_mixer_check_a.wav", 1.0f, 0.0f);
+            startMusic(player);
+            mixer.Mix(out.data(), block);
+            bool steady = std::fabs(out[(block - 1) * 2] - 0.25f) < 1e-4f;
+            player.Play("audio_mixer_check_b.wav", 1.0f, 0.02f); // 882 frames
+            player.Play("audio_mixer_check_b.wav", 1.0f, 0.02f); // same track again changes nothing
+            startMusic(player);
+            bool both = player.Tracks() == 2 && player.Current() == "audio_mixer_check_b.wav";
+            mixer.Mix(out.data(), block);
+            // the sum of the two ramps moves straight from +0.25 to -0.25
+            bool smooth = true;
+            for (size_t i = 1; i < block; ++i)
+                smooth = smooth && out[i * 2] <= out[i * 2 - 2] + 1e-6f && out[i * 2] - out[i * 2 - 2] > -0.001f;
+            bool reached = std::fabs(out[(block - 1) * 2] + 0.25f) < 1e-4f;
+            player.Update();
+            expect(steady && both && smooth && reached && player.Tracks() == 1, "music crossfade");
+            mixer.StopAll();
+            mixer.Mix(out.data(), block);
+        }
+        std::remove("audio_mixer_check_a.wav");
+        std::remove("audio_mixer_check_b.wav");
+    }
+
+    std::cout << (failures ? "FAILED" : "all checks passed") << std::endl;
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int voiceCount = AudioMixer::MAX_VOICES;
+    double seconds = 10.0;
+    std::string wavPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--check")
+            return runChecks();
+        else if (arg == "--voices" && i + 1 < argc)
+            voiceCount = std::min<unsigned int>(AudioMixer::MAX_VOICES, std::atoi(argv[++i]));
+        else if (arg == "--seconds" && i + 1 < argc)
+            seconds = std::atof(argv[++i]);
+        else if (arg == "--wav" && i + 1 < argc)
+            wavPath = argv[++i];
+    }
+
+    std::vector<AudioBuffer> tones;
+    for (unsigned int i = 0; i < voiceCount; ++i)
+        tones.push_back(makeTone(220.0f + 35.0f * i, 1.0f + 0.1f * i, 0.9f));
+    AudioMixer mixer;
+    for (unsigned int i = 0; i < voiceCount; ++i)
+        mixer.Play(&tones[i], 1.0f / voiceCount, -1.0f + 2.0f * i / std::max(1u, voiceCount - 1), true);
+
+    // the block size of the real-time outputs
+    const size_t block = 512;
+    size_t frames = size_t(seconds * AudioMixer::SAMPLE_RATE);
+    std::vector<int16_t> out(block * 2);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t done = 0; done < frames; done += block)
+        mixer.MixInt16(out.data(), block);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%u voices, %.1f s of audio in %.2f ms\n", voiceCount, seconds, elapsed * 1000.0);
+    std::printf("%.2f ns per voice-frame, %.0fx real time\n",
+                elapsed * 1e9 / (double(frames) * std::max(1u, voiceCount)), seconds / elapsed);
+
+    if (!wavPath.empty())
+    {
+        WavFileAudioOutput output(wavPath, false);
+        output.Start(mixer);
+        output.Render(size_t(std::min(seconds, 10.0) * AudioMixer::SAMPLE_RATE));
+        output.Stop();
+        std::cout << "Wrote " << wavPath << std::endl;
+    }
+    return 0;
+}
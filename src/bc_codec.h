@@ -0,0 +1,319 @@
+#ifndef BC_CODEC_H
+#define BC_CODEC_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+// Block compression (BC1 / BC3, also known as DXT1 / DXT5) for the asset
+// build, plus a decoder used as the runtime fallback on drivers without
+// S3TC and to measure encoder quality.
+//   BC1: 8 bytes per 4x4 block, two RGB565 endpoints + 2-bit indices (opaque)
+//   BC3: 16 bytes per 4x4 block, an 8-byte alpha block followed by a BC1 color block
+// Blocks that hang over the image edge are padded by clamping.
+enum BCFormat {
+    BC_NONE = 0,
+    BC1 = 1,
+    BC3 = 2
+};
+
+inline unsigned int BCBlockBytes(BCFormat format) { return format == BC1 ? 8 : 16; }
+inline size_t BCImageBytes(BCFormat format, int width, int height)
+{
+    return size_t((width + 3) / 4) * ((height + 3) / 4) * BCBlockBytes(format);
+}
+
+// 565 helpers
+inline uint16_t BCPack565(const float *color)
+{
+    int r = std::min(31, std::max(0, static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f)));
+    int g = std::min(63, std::max(0, static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f)));
+    int b = std::min(31, std::max(0, static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f)));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+inline void BCUnpack565(uint16_t packed, int *color)
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+// the four colors of a 4-color BC1 block
+inline void BCPalette(uint16_t c0, uint16_t c1, int palette[4][3], bool forceFourColor)
+{
+    BCUnpack565(c0, palette[0]);
+    BCUnpack565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c)
+    {
+        if (c0 > c1 || forceFourColor)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// picks the nearest palette entry for every texel, returns the summed squared error
+inline int BCChooseIndices(const unsigned char block[16][4], uint16_t c0, uint16_t c1, uint32_t &indices)
+{
+    int palette[4][3];
+    BCPalette(c0, c1, palette, true);
+    int error = 0;
+    indices = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int best = 0, bestDistance = 1 << 30;
+        for (int p = 0; p < 4; ++p)
+        {
+            int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance)
+            {
+                bestDistance = distance;
+                best = p;
+            }
+        }
+        indices |= uint32_t(best) << (2 * i);
+        error += bestDistance;
+    }
+    return error;
+}
+
+// encodes the color part of a block: endpoints along the principal axis,
+// then one least squares refinement of the endpoints for the chosen indices
+inline void BCEncodeColorBlock(const unsigned char block[16][4], unsigned char *out)
+{
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += block[i][c] / 16.0f;
+    float cov[6] = { 0 }; // rr rg rb gg gb bb
+    for (int i = 0; i < 16; ++i)
+    {
+        float r = block[i][0] - mean[0], g = block[i][1] - mean[1], b = block[i][2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    // power iteration for the principal axis
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 6; ++iteration)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float length = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+    float minT = 1e30f, maxT = -1e30f;
+    for (int i = 0; i < 16; ++i)
+    {
+        float t = (block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] + (block[i][2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float lengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        end0[c] = mean[c] + axis[c] * maxT / std::max(lengthSq, 1e-6f);
+        end1[c] = mean[c] + axis[c] * minT / std::max(lengthSq, 1e-6f);
+    }
+    uint16_t c0 = BCPack565(end0), c1 = BCPack565(end1);
+    uint32_t indices;
+    int error = BCChooseIndices(block, c0, c1, indices);
+
+    // least squares endpoints for the current assignment (weights of endpoint 0 per index)
+    static const float weight[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float aa = 0, bb = 0, ab = 0, ax[3] = { 0 }, bx[3] = { 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        float a = weight[(indices >> (2 * i)) & 3], b = 1.0f - a;
+        aa += a * a; bb += b * b; ab += a * b;
+        for (int c = 0; c < 3; ++c)
+        {
+            ax[c] += a * block[i][c];
+            bx[c] += b * block[i][c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) > 1e-6f)
+    {
+        float refined0[3], refined1[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            refined0[c] = (ax[c] * bb - bx[c] * ab) / det;
+            refined1[c] = (bx[c] * aa - ax[c] * ab) / det;
+        }
+        uint16_t r0 = BCPack565(refined0), r1 = BCPack565(refined1);
+        uint32_t refinedIndices;
+        int refinedError = BCChooseIndices(block, r0, r1, refinedIndices);
+        if (refinedError < error)
+        {
+            c0 = r0; c1 = r1; indices = refinedIndices; error = refinedError;
+        }
+    }
+    // 4-color mode needs c0 > c1: swap endpoints and remap 0<->1, 2<->3
+    if (c0 < c1)
+    {
+        std::swap(c0, c1);
+        indices ^= 0x55555555u;
+    }
+    else if (c0 == c1)
+        indices = 0;
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+// encodes the BC3 alpha block in 8-value mode (a0 = max > a1 = min)
+inline void BCEncodeAlphaBlock(const unsigned char block[16][4], unsigned char *out)
+{
+    int minA = 255, maxA = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        minA = std::min(minA, int(block[i][3]));
+        maxA = std::max(maxA, int(block[i][3]));
+    }
+    out[0] = static_cast<unsigned char>(maxA);
+    out[1] = static_cast<unsigned char>(minA);
+    uint64_t bits = 0;
+    if (maxA > minA)
+    {
+        int values[8] = { maxA, minA };
+        for (int v = 2; v < 8; ++v)
+            values[v] = ((8 - v) * maxA + (v - 1) * minA) / 7;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0, bestDistance = 1 << 30;
+            for (int v = 0; v < 8; ++v)
+            {
+                int distance = std::abs(block[i][3] - values[v]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = v;
+                }
+            }
+            bits |= uint64_t(best) << (3 * i);
+        }
+    }
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+// gathers the 4x4 block at (bx, by) as RGBA, clamping at the image edge
+inline void BCFetchBlock(const unsigned char *pixels, int width, int height, int channels, int bx, int by, unsigned char block[16][4])
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x)
+        {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const unsigned char *p = pixels + (size_t(sy) * width + sx) * channels;
+            block[y * 4 + x][0] = p[0];
+            block[y * 4 + x][1] = p[1];
+            block[y * 4 + x][2] = p[2];
+            block[y * 4 + x][3] = channels == 4 ? p[3] : 255;
+        }
+    }
+}
+
+// compresses one row of blocks; rows are independent so callers can spread them over threads
+inline void BCEncodeBlockRow(const unsigned char *pixels, int width, int height, int channels, BCFormat format, int blockRow, unsigned char *out)
+{
+    int blocksX = (width + 3) / 4;
+    unsigned char *dst = out + size_t(blockRow) * blocksX * BCBlockBytes(format);
+    unsigned char block[16][4];
+    for (int bx = 0; bx < blocksX; ++bx)
+    {
+        BCFetchBlock(pixels, width, height, channels, bx, blockRow, block);
+        if (format == BC3)
+        {
+            BCEncodeAlphaBlock(block, dst);
+            dst += 8;
+        }
+        BCEncodeColorBlock(block, dst);
+        dst += 8;
+    }
+}
+
+// decodes a BC1/BC3 image into tightly packed pixels with the given channel count (3 or 4)
+inline void BCDecodeImage(const unsigned char *data, int width, int height, BCFormat format, int channels, unsigned char *pixels)
+{
+    int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    for (int by = 0; by < blocksY; ++by)
+    {
+        for (int bx = 0; bx < blocksX; ++bx)
+        {
+            const unsigned char *block = data + (size_t(by) * blocksX + bx) * BCBlockBytes(format);
+            int alpha[8] = { 255, 255, 255, 255, 255, 255, 255, 255 };
+            uint64_t alphaBits = 0;
+            if (format == BC3)
+            {
+                alpha[0] = block[0];
+                alpha[1] = block[1];
+                for (int v = 2; v < 8; ++v)
+                {
+                    if (alpha[0] > alpha[1])
+                        alpha[v] = ((8 - v) * alpha[0] + (v - 1) * alpha[1]) / 7;
+                    else
+                        alpha[v] = v < 6 ? ((6 - v) * alpha[0] + (v - 1) * alpha[1]) / 5 : (v == 6 ? 0 : 255);
+                }
+                for (int i = 0; i < 6; ++i)
+                    alphaBits |= uint64_t(block[2 + i]) << (8 * i);
+                block += 8;
+            }
+            uint16_t c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+            uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (uint32_t(block[7]) << 24);
+            int palette[4][3];
+            BCPalette(c0, c1, palette, format == BC3);
+            for (int i = 0; i < 16; ++i)
+            {
+                int x = bx * 4 + (i & 3), y = by * 4 + (i >> 2);
+                if (x >= width || y >= height)
+                    continue;
+                int index = (indices >> (2 * i)) & 3;
+                unsigned char *p = pixels + (size_t(y) * width + x) * channels;
+                p[0] = palette[index][0];
+                p[1] = palette[index][1];
+                p[2] = palette[index][2];
+                if (channels == 4)
+                {
+                    int a = format == BC3 ? alpha[(alphaBits >> (3 * i)) & 7] : 255;
+                    // BC1 3-color mode marks index 3 as transparent
+                    if (format == BC1 && c0 <= c1 && index == 3)
+                        a = 0;
+                    p[3] = static_cast<unsigned char>(a);
+                }
+            }
+        }
+    }
+}
+
+// peak signal to noise ratio in dB between two images of the same layout
+inline double ImagePSNR(const unsigned char *a, const unsigned char *b, size_t bytes)
+{
+    double squared = 0.0;
+    for (size_t i = 0; i < bytes; ++i)
+    {
+        double d = double(a[i]) - double(b[i]);
+        squared += d * d;
+    }
+    if (squared == 0.0)
+        return 99.0;
+    return 10.0 * std::log10(255.0 * 255.0 / (squared / bytes));
+}
+
+#endif
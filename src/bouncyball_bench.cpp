@@ -0,0 +1,325 @@
+// bouncyball_bench - microbenchmarks of the game's CPU paths, no window or GPU needed.
+//
+//   bouncyball_bench [--samples <n>] [--filter <text>] [--json <file>]
+//
+// Runs every benchmark for a fixed number of iterations per sample and
+// prints the mean time per operation, its standard deviation over the
+// samples (default 15, after one warm-up sample), the fastest sample and
+// the throughput. --filter runs only the benchmarks whose name contains
+// text, --json also writes the results so runs can be compared.
+// Covered: CheckCollision, CheckBoxCollision and VectorDirection on a fixed
+// set of overlapping and separate pairs, GameLevel::Load of every shipped
+// level, ParticleGenerator::Update at 500, 10k and 100k particles and the
+// glyph layout of TextRenderer::RenderText, and one tick of InputRecorder::Record
+// and InputPlayback::Next (keys changing every 30 ticks, the recording goes
+// to the temp directory), and of ghost runs (ghost_path.h): GhostRecorder::Sample
+// and GhostPlayback::Position per tick and GhostRecorder::Encode of a
+// minute of a bouncing ball, with the size of the file against the raw
+// samples and the largest distance between played back and recorded
+// positions. GL calls go to the no-op stubs
+// of gl_stub.h, so link glad.c but no GL library. Run from the repository
+// root (levels and shaders are read from resources/ and src/shader).
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gl_stub.h"
+#include "collision.h"
+#include "game_level.h"
+#include "particle_generator.h"
+#include "text_renderer.h"
+#include "input_recorder.h"
+#include "ghost_path.h"
+
+struct BenchResult {
+    std::string Name;
+    uint64_t Iterations = 0;  // per sample
+    unsigned int Samples = 0;
+    double Mean = 0.0, StdDev = 0.0, Min = 0.0; // nanoseconds per operation
+    double ItemsPerOp = 1.0;  // particles, characters, ... handled by one operation
+};
+
+static unsigned int sampleCount = 15;
+static std::string filter;
+static std::vector<BenchResult> results;
+
+// keeps results alive so the optimizer cannot drop the measured work
+static volatile float sink;
+
+// times iterations calls of op (given the iteration index) per sample
+static void bench(const std::string &name, uint64_t iterations, double itemsPerOp, const std::function<void(uint64_t)> &op)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+    std::vector<double> samples;
+    for (unsigned int sample = 0; sample <= sampleCount; ++sample)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            op(i);
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (sample > 0) // the first one warms caches and the branch predictor
+            samples.push_back(elapsed / iterations);
+    }
+    BenchResult result;
+    result.Name = name;
+    result.Iterations = iterations;
+    result.Samples = sampleCount;
+    result.ItemsPerOp = itemsPerOp;
+    result.Min = samples[0];
+    for (double ns : samples)
+    {
+        result.Mean += ns;
+        result.Min = std::min(result.Min, ns);
+    }
+    result.Mean /= samples.size();
+    double variance = 0.0;
+    for (double ns : samples)
+        variance += (ns - result.Mean) * (ns - result.Mean);
+    result.StdDev = samples.size() > 1 ? std::sqrt(variance / (samples.size() - 1)) : 0.0;
+    std::printf("%-36s %12.1f ns/op  +- %5.1f%%  min %12.1f  %14.0f op/s", name.c_str(), result.Mean,
+                result.Mean > 0.0 ? 100.0 * result.StdDev / result.Mean : 0.0, result.Min, 1e9 / result.Mean);
+    if (itemsPerOp != 1.0)
+        std::printf("  %14.0f items/s", 1e9 * itemsPerOp / result.Mean);
+    std::printf("\n");
+    results.push_back(result);
+}
+
+static bool writeJson(const std::string &path)
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    std::fprintf(file, "{\n  \"samples\": %u,\n  \"benchmarks\": [\n", sampleCount);
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult &r = results[i];
+        std::fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, "
+                           "\"ops_per_sec\": %.1f, \"items_per_op\": %.1f, \"items_per_sec\": %.1f}%s\n",
+                     r.Name.c_str(), static_cast<unsigned long long>(r.Iterations), r.Mean, r.StdDev, r.Min,
+                     1e9 / r.Mean, r.ItemsPerOp, 1e9 * r.ItemsPerOp / r.Mean, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+// deterministic pseudo random numbers in [0, 1), the same every run
+static float random01(uint32_t &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+static void benchCollisions()
+{
+    // ball/block pairs around a 50x50 tile, about half of them touching
+    const size_t PAIRS = 1024;
+    const float radius = 7.0f;
+    std::vector<GameObject> balls(PAIRS), boxes(PAIRS);
+    std::vector<glm::vec2> directions(PAIRS);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < PAIRS; ++i)
+    {
+        boxes[i].Position = glm::vec2(400.0f, 300.0f);
+        boxes[i].Size = glm::vec2(50.0f, 50.0f);
+        balls[i].Position = glm::vec2(370.0f + random01(seed) * 90.0f, 270.0f + random01(seed) * 90.0f);
+        balls[i].Size = glm::vec2(radius * 2.0f);
+        directions[i] = glm::vec2(random01(seed) - 0.5f, random01(seed) - 0.5f);
+    }
+    bench("CheckCollision", 2000000, 1.0, [&](uint64_t i) {
+        Collision collision = CheckCollision(balls[i % PAIRS], boxes[i % PAIRS], radius);
+        sink = std::get<0>(collision) ? std::get<2>(collision).x : 0.0f;
+    });
+    bench("CheckBoxCollision", 2000000, 1.0, [&](uint64_t i) {
+        Collision collision = CheckBoxCollision(balls[i % PAIRS], boxes[i % PAIRS]);
+        sink = std::get<0>(collision) ? std::get<2>(collision).y : 0.0f;
+    });
+    bench("VectorDirection", 2000000, 1.0, [&](uint64_t i) {
+        sink = float(VectorDirection(directions[i % PAIRS]));
+    });
+}
+
+static void benchLevels()
+{
+    for (unsigned int level = 1; level <= 10; ++level)
+    {
+        std::string file = "resources/gamelevels/" + std::to_string(level) + ".txt";
+        GameLevel probe;
+        probe.Load(file.c_str(), 800, 600);
+        if (probe.Blocks.empty())
+        {
+            std::cout << "ERROR::BENCH: Could not load " << file << " (run from the repository root)" << std::endl;
+            continue;
+        }
+        GameLevel loaded;
+        bench("GameLevel::Load " + std::to_string(level) + ".txt", 500, double(probe.Blocks.size()), [&](uint64_t) {
+            loaded.Load(file.c_str(), 800, 600);
+            sink = float(loaded.Blocks.size());
+        });
+    }
+}
+
+static void benchParticles()
+{
+    GameObject ball(glm::vec2(400.0f, 300.0f), glm::vec2(14.0f), TextureHandle(), glm::vec3(1.0f), glm::vec2(50.0f, -120.0f));
+    const unsigned int counts[] = { 500, 10000, 100000 };
+    for (unsigned int count : counts)
+    {
+        ParticleGenerator particles(ShaderHandle(), TextureHandle(), count);
+        // the game spawns 2 particles per frame at 60 fps
+        bench("ParticleGenerator::Update " + std::to_string(count), std::max(200u, 5000000u / count), double(count), [&](uint64_t i) {
+            ball.Position.x = 400.0f + float(i % 64);
+            particles.Update(1.0f / 60.0f, ball, 2, glm::vec2(7.0f / 2.65f));
+        });
+    }
+}
+
+static void benchText()
+{
+    TextRenderer text(800, 600);
+    // glyph metrics of a 72 px font, the layout does not depend on the pixels
+    std::vector<GlyphBitmap> glyphs;
+    for (unsigned int c = 32; c < 128; ++c)
+    {
+        GlyphBitmap glyph;
+        glyph.Code = char(c);
+        glyph.Size = glm::ivec2(c == ' ' ? 0 : 30 + c % 17, c == ' ' ? 0 : 40 + c % 23);
+        glyph.Bearing = glm::ivec2(2, 52 - int(c % 7));
+        glyph.Advance = (glyph.Size.x + 6) << 6;
+        glyph.Pixels.resize(size_t(glyph.Size.x) * glyph.Size.y);
+        glyphs.push_back(std::move(glyph));
+    }
+    text.Upload(glyphs);
+    const char *hud = "Level : 10";
+    const char *help = "Left : A, left // Right : D, right // Reset : R // Quit : ESC";
+    bench("RenderText layout (hud)", 200000, double(std::strlen(hud)), [&](uint64_t) {
+        text.RenderText(hud, 5.0f, 5.0f, 0.33f, glm::vec3(0.0f));
+    });
+    bench("RenderText layout (help line)", 50000, double(std::strlen(help)), [&](uint64_t) {
+        text.RenderText(help, 180.0f, 330.0f, 0.25f, glm::vec3(0.0f));
+    });
+}
+
+static void benchInput()
+{
+    std::string path = (std::filesystem::temp_directory_path() / "bouncyball_bench_input.bbin").string();
+    bool keys[1024] = {}, keysProcessed[1024] = {};
+    InputRecorder recorder;
+    if (!recorder.Open(path))
+    {
+        std::cout << "ERROR::BENCH: Could not create " << path << std::endl;
+        return;
+    }
+    bench("InputRecorder::Record", 2000000, 1.0, [&](uint64_t i) {
+        keys[GLFW_KEY_D] = (i / 30) % 2 != 0;
+        recorder.Record(keys);
+    });
+    recorder.Close();
+    InputPlayback playback;
+    if (!playback.Open(path))
+        return;
+    bench("InputPlayback::Next", 2000000, 1.0, [&](uint64_t) {
+        if (!playback.Next(keys, keysProcessed))
+            playback.Seek(0);
+    });
+    std::filesystem::remove(path);
+}
+
+static void benchGhost()
+{
+    // a minute of the ball bouncing on blocks (gravity, a bounce every 48 ticks) and steered
+    // left and right every few seconds, like a clear of a level
+    const uint32_t TICKS = 60 * 60;
+    std::vector<glm::vec2> path(TICKS + 1);
+    glm::vec2 position(100.0f, 400.0f), speed(0.0f, -400.0f);
+    uint32_t seed = 777;
+    float steer = 1.0f;
+    for (uint32_t tick = 0; tick <= TICKS; ++tick)
+    {
+        path[tick] = position;
+        if (tick % 150 == 0)
+            steer = random01(seed) < 0.5f ? -1.0f : 1.0f;
+        speed.x = std::max(-200.0f, std::min(200.0f, speed.x + steer * 600.0f / 60.0f));
+        speed.y += 1000.0f / 60.0f;
+        if (tick % 48 == 47)
+            speed.y = -400.0f;
+        position += speed / 60.0f;
+    }
+    // the recording the playback and the summary use, whichever benchmarks --filter picks
+    GhostRecorder recorder;
+    recorder.Begin(path[0]);
+    for (uint32_t tick = 1; tick <= TICKS; ++tick)
+        recorder.Sample(tick / GHOST_RATE, path[tick]);
+    std::vector<unsigned char> data;
+    recorder.Encode(data);
+    size_t benchmarks = results.size();
+    bench("GhostRecorder::Sample", 360, double(TICKS), [&](uint64_t) {
+        recorder.Begin(path[0]);
+        for (uint32_t tick = 1; tick <= TICKS; ++tick)
+            recorder.Sample(tick / GHOST_RATE, path[tick]);
+    });
+    bench("GhostRecorder::Encode (1 minute)", 50, double(TICKS), [&](uint64_t) {
+        recorder.Encode(data);
+        sink = float(data.size());
+    });
+
+    std::string file = (std::filesystem::temp_directory_path() / "bouncyball_bench.ghost").string();
+    GhostPlayback playback;
+    if (!recorder.Write(file) || !playback.Open(file))
+    {
+        std::cout << "ERROR::BENCH: Could not write " << file << std::endl;
+        return;
+    }
+    float worst = 0.0f;
+    glm::vec2 played;
+    for (uint32_t tick = 0; tick <= TICKS; ++tick)
+        if (playback.Position(tick / GHOST_RATE, played))
+            worst = std::max(worst, glm::length(played - path[tick]));
+    bench("GhostPlayback::Position", 360, double(TICKS), [&](uint64_t) {
+        playback.Restart();
+        for (uint32_t tick = 0; tick <= TICKS; ++tick)
+            if (playback.Position(tick / GHOST_RATE, played))
+                sink = played.x;
+    });
+    if (results.size() > benchmarks)
+        std::printf("ghost: %u ticks in %zu bytes (raw samples %zu bytes, %.1fx), largest error %.3f px\n", TICKS, data.size(),
+                    size_t(TICKS + 1) * sizeof(glm::vec2), double(TICKS + 1) * sizeof(glm::vec2) / data.size(), worst);
+    playback.Close();
+    std::filesystem::remove(file);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string jsonPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--samples" && i + 1 < argc)
+            sampleCount = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--json" && i + 1 < argc)
+            jsonPath = argv[++i];
+    }
+    StubGL();
+
+    benchCollisions();
+    benchLevels();
+    benchParticles();
+    benchText();
+    benchInput();
+    benchGhost();
+
+    if (!jsonPath.empty() && !writeJson(jsonPath))
+    {
+        std::cout << "ERROR::BENCH: Could not write " << jsonPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
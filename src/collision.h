@@ -0,0 +1,151 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <tuple>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "game_object.h"
+#include "fixed.h"
+
+//방향
+enum Direction {
+	UP,
+	RIGHT,
+	DOWN,
+	LEFT
+};
+
+//충돌데이터 튜플
+typedef std::tuple<bool, Direction, glm::vec2> Collision;
+//충돌 방향 벡터 구하기
+inline Direction VectorDirection(glm::vec2 target)
+{
+    glm::vec2 compass[] = {
+        glm::vec2(0.0f, 1.0f),	// up
+        glm::vec2(-1.0f, 0.0f),	// right
+        glm::vec2(0.0f, -1.0f),	// down
+        glm::vec2(1.0f, 0.0f)	// left
+    };
+    float max = 0.0f;
+    unsigned int best_match = -1;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        float dot_product = glm::dot(glm::normalize(target), compass[i]);
+        if (dot_product > max)
+        {
+            max = dot_product;
+            best_match = i;
+        }
+    }
+    return (Direction)best_match;
+} 
+//충돌 함수 - 박스 박스
+inline Collision CheckBoxCollision(const GameObject &one, const GameObject &two) //AABB-AABB
+{
+    //x축
+    bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
+        two.Position.x + two.Size.x >= one.Position.x;
+    //y축
+    bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
+        two.Position.y + two.Size.y >= one.Position.y;
+    
+    //one의 중심
+    glm::vec2 one_half_extents(one.Size.x / 2.0f, one.Size.y / 2.0f);
+    glm::vec2 one_center(
+        one.Position.x + one_half_extents.x, 
+        one.Position.y + one_half_extents.y
+    );
+    //two의 중심
+    glm::vec2 two_half_extents(two.Size.x / 2.0f, two.Size.y / 2.0f);
+    glm::vec2 two_center(
+        two.Position.x + two_half_extents.x, 
+        two.Position.y + two_half_extents.y
+    );
+    //얼마나 깊이 들어갔는가 측정
+    glm::vec2 difference = one_center - two_center;
+    glm::vec2 clamped = glm::clamp(difference, -two_half_extents, two_half_extents);
+    glm::vec2 closest = two_center + clamped;
+    difference = closest - one_center;
+    //x, y둘다 감지되면 충돌
+    return std::make_tuple(collisionX && collisionY, VectorDirection(difference), difference);
+
+} 
+//충돌 함수 - 원 박스
+inline Collision CheckCollision(const GameObject &one, const GameObject &two, float radius) // AABB-Circle
+{
+    // get center point circle first 
+    glm::vec2 center(one.Position + radius);
+    // calculate AABB info (center, half-extents)
+    glm::vec2 aabb_half_extents(two.Size.x / 2.0f, two.Size.y / 2.0f);
+    glm::vec2 aabb_center(
+        two.Position.x + aabb_half_extents.x, 
+        two.Position.y + aabb_half_extents.y
+    );
+    // get difference vector between both centers
+    glm::vec2 difference = center - aabb_center;
+    glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
+    // add clamped value to AABB_center and we get the value of box closest to circle
+    glm::vec2 closest = aabb_center + clamped;
+    // retrieve vector between center circle and closest point AABB and check if length <= radius
+    difference = closest - center;
+    if (glm::length(difference) < radius)
+        return std::make_tuple(true, VectorDirection(difference), difference);
+    else
+        return std::make_tuple(false, UP, glm::vec2(0.0f, 0.0f));
+}
+
+//고정소수점 충돌 - 위와 같은 판정을 정수 연산으로 (--fixed-physics, 기기에 상관없이 같은 결과)
+typedef std::tuple<bool, Direction, FixedVec2> FixedCollision;
+//정규화하지 않아도 나침반 방향과의 내적 중 가장 큰 것은 같음 (길이로 나누는 것은 순서를 바꾸지 않음)
+inline Direction VectorDirection(FixedVec2 target)
+{
+    const Fixed dots[] = { target.y, -target.x, -target.y, target.x }; // up, right, down, left
+    Fixed max;
+    unsigned int best_match = -1;
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (dots[i] > max)
+        {
+            max = dots[i];
+            best_match = i;
+        }
+    }
+    return (Direction)best_match;
+}
+//충돌 함수 - 박스 박스
+inline FixedCollision CheckBoxCollision(FixedVec2 onePosition, FixedVec2 oneSize, FixedVec2 twoPosition, FixedVec2 twoSize)
+{
+    bool collisionX = onePosition.x + oneSize.x >= twoPosition.x && twoPosition.x + twoSize.x >= onePosition.x;
+    bool collisionY = onePosition.y + oneSize.y >= twoPosition.y && twoPosition.y + twoSize.y >= onePosition.y;
+    const Fixed half(0.5);
+    FixedVec2 one_half_extents(oneSize.x * half, oneSize.y * half);
+    FixedVec2 one_center = onePosition + one_half_extents;
+    FixedVec2 two_half_extents(twoSize.x * half, twoSize.y * half);
+    FixedVec2 two_center = twoPosition + two_half_extents;
+    FixedVec2 difference = one_center - two_center;
+    FixedVec2 clamped(std::min(std::max(difference.x, -two_half_extents.x), two_half_extents.x),
+                      std::min(std::max(difference.y, -two_half_extents.y), two_half_extents.y));
+    difference = two_center + clamped - one_center;
+    return std::make_tuple(collisionX && collisionY, VectorDirection(difference), difference);
+}
+//충돌 함수 - 원 박스 (거리 비교는 제곱으로, 64비트)
+inline FixedCollision CheckCollision(FixedVec2 ballPosition, FixedVec2 boxPosition, FixedVec2 boxSize, Fixed radius)
+{
+    const Fixed half(0.5);
+    FixedVec2 center = ballPosition + FixedVec2(radius, radius);
+    FixedVec2 aabb_half_extents(boxSize.x * half, boxSize.y * half);
+    FixedVec2 aabb_center = boxPosition + aabb_half_extents;
+    FixedVec2 difference = center - aabb_center;
+    FixedVec2 clamped(std::min(std::max(difference.x, -aabb_half_extents.x), aabb_half_extents.x),
+                      std::min(std::max(difference.y, -aabb_half_extents.y), aabb_half_extents.y));
+    difference = aabb_center + clamped - center;
+    int64_t distance = int64_t(difference.x.Raw) * difference.x.Raw + int64_t(difference.y.Raw) * difference.y.Raw;
+    if (distance < int64_t(radius.Raw) * radius.Raw)
+        return std::make_tuple(true, VectorDirection(difference), difference);
+    else
+        return std::make_tuple(false, UP, FixedVec2());
+}
+
+#endif
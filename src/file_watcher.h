@@ -0,0 +1,132 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include <filesystem>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+
+// FileWatcher reports files that were written in a set of watched folders
+// (not recursive). On Linux it reads inotify events from a non-blocking
+// descriptor, elsewhere it compares modification times a few times per
+// second. Poll never blocks so it can run once per frame.
+class FileWatcher
+{
+public:
+    FileWatcher() { }
+    ~FileWatcher()
+    {
+#ifdef __linux__
+        if (this->fd >= 0)
+            close(this->fd);
+#endif
+    }
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher &operator=(const FileWatcher&) = delete;
+
+    // starts watching folder, reported paths are folder + "/" + file name
+    bool Watch(const std::string &folder)
+    {
+#ifdef __linux__
+        if (this->fd < 0)
+            this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->fd < 0)
+        {
+            std::cout << "ERROR::WATCHER: inotify is not available" << std::endl;
+            return false;
+        }
+        // close-after-write covers in-place saves, moved-to covers editors that save through a rename
+        int watch = inotify_add_watch(this->fd, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (watch < 0)
+        {
+            std::cout << "ERROR::WATCHER: Could not watch " << folder << std::endl;
+            return false;
+        }
+        this->folders[watch] = folder;
+        return true;
+#else
+        std::error_code ec;
+        if (!std::filesystem::is_directory(folder, ec))
+        {
+            std::cout << "ERROR::WATCHER: Could not watch " << folder << std::endl;
+            return false;
+        }
+        this->folders[static_cast<int>(this->folders.size())] = folder;
+        this->scan(folder, nullptr);
+        return true;
+#endif
+    }
+    // appends the files changed since the last call (each at most once) to changed
+    void Poll(std::vector<std::string> &changed)
+    {
+        std::set<std::string> unique;
+#ifdef __linux__
+        if (this->fd < 0)
+            return;
+        alignas(inotify_event) char buffer[4096];
+        for (;;)
+        {
+            ssize_t length = read(this->fd, buffer, sizeof(buffer));
+            if (length <= 0)
+                break;
+            for (char *p = buffer; p < buffer + length; )
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event*>(p);
+                auto folder = this->folders.find(event->wd);
+                if (event->len > 0 && folder != this->folders.end())
+                    unique.insert(folder->second + "/" + event->name);
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+#else
+        auto now = std::chrono::steady_clock::now();
+        if (now - this->lastScan < std::chrono::milliseconds(250))
+            return;
+        this->lastScan = now;
+        for (const auto &folder : this->folders)
+            this->scan(folder.second, &unique);
+#endif
+        changed.insert(changed.end(), unique.begin(), unique.end());
+    }
+
+private:
+    std::map<int, std::string> folders;
+#ifdef __linux__
+    int fd = -1;
+#else
+    std::map<std::string, std::filesystem::file_time_type> times;
+    std::chrono::steady_clock::time_point lastScan;
+
+    // records modification times, reporting files whose time changed when changed is given
+    void scan(const std::string &folder, std::set<std::string> *changed)
+    {
+        std::error_code ec;
+        for (const auto &entry : std::filesystem::directory_iterator(folder, ec))
+        {
+            if (!entry.is_regular_file(ec))
+                continue;
+            std::string path = folder + "/" + entry.path().filename().string();
+            std::filesystem::file_time_type time = entry.last_write_time(ec);
+            auto known = this->times.find(path);
+            if (known == this->times.end() || known->second != time)
+            {
+                if (changed && known != this->times.end())
+                    changed->insert(path);
+                this->times[path] = time;
+            }
+        }
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+
+// Fixed is a 16.16 fixed-point number (range +-32768, steps of 1/65536).
+// Everything after construction is integer arithmetic: sums wrap like
+// int32, products and quotients go through 64 bits, so the results are
+// bit-identical with every compiler, flag and CPU, unlike float where
+// contraction into FMA, x87 precision or library sqrt can differ.
+// Conversion from double rounds to the nearest step; it is exact for
+// literals and for floats that are exactly representable (the level grid).
+struct Fixed
+{
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr int32_t ONE = 1 << FRACTION_BITS;
+
+    int32_t Raw = 0;
+
+    constexpr Fixed() { }
+    constexpr explicit Fixed(double value) : Raw(int32_t(value * ONE + (value < 0.0 ? -0.5 : 0.5))) { }
+    static constexpr Fixed FromRaw(int32_t raw)
+    {
+        Fixed value;
+        value.Raw = raw;
+        return value;
+    }
+    float ToFloat() const { return float(this->Raw) / float(ONE); }
+
+    // products round to the nearest step (ties up), quotients truncate toward zero
+    friend Fixed operator*(Fixed a, Fixed b) { return FromRaw(int32_t((int64_t(a.Raw) * b.Raw + (ONE >> 1)) >> FRACTION_BITS)); }
+    friend Fixed operator/(Fixed a, Fixed b) { return FromRaw(int32_t(int64_t(uint64_t(int64_t(a.Raw)) << FRACTION_BITS) / b.Raw)); }
+    friend Fixed operator*(Fixed a, int b) { return FromRaw(int32_t(uint32_t(a.Raw) * uint32_t(b))); }
+    friend Fixed operator*(int a, Fixed b) { return b * a; }
+    friend Fixed operator+(Fixed a, Fixed b) { return FromRaw(int32_t(uint32_t(a.Raw) + uint32_t(b.Raw))); }
+    friend Fixed operator-(Fixed a, Fixed b) { return FromRaw(int32_t(uint32_t(a.Raw) - uint32_t(b.Raw))); }
+    Fixed operator-() const { return FromRaw(int32_t(0u - uint32_t(this->Raw))); }
+    Fixed &operator+=(Fixed b) { return *this = *this + b; }
+    Fixed &operator-=(Fixed b) { return *this = *this - b; }
+    Fixed &operator*=(Fixed b) { return *this = *this * b; }
+    Fixed &operator/=(Fixed b) { return *this = *this / b; }
+
+    friend bool operator==(Fixed a, Fixed b) { return a.Raw == b.Raw; }
+    friend bool operator!=(Fixed a, Fixed b) { return a.Raw != b.Raw; }
+    friend bool operator<(Fixed a, Fixed b) { return a.Raw < b.Raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.Raw > b.Raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.Raw <= b.Raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.Raw >= b.Raw; }
+};
+
+inline Fixed Abs(Fixed value) { return value.Raw < 0 ? -value : value; }
+// so code written for both number types can call Abs
+inline float Abs(float value) { return std::abs(value); }
+
+struct FixedVec2
+{
+    Fixed x, y;
+
+    constexpr FixedVec2() { }
+    constexpr FixedVec2(Fixed x, Fixed y) : x(x), y(y) { }
+    explicit FixedVec2(glm::vec2 value) : x(double(value.x)), y(double(value.y)) { }
+    glm::vec2 ToFloat() const { return glm::vec2(this->x.ToFloat(), this->y.ToFloat()); }
+
+    friend FixedVec2 operator+(FixedVec2 a, FixedVec2 b) { return FixedVec2(a.x + b.x, a.y + b.y); }
+    friend FixedVec2 operator-(FixedVec2 a, FixedVec2 b) { return FixedVec2(a.x - b.x, a.y - b.y); }
+    friend FixedVec2 operator-(FixedVec2 a) { return FixedVec2(-a.x, -a.y); }
+    friend bool operator==(FixedVec2 a, FixedVec2 b) { return a.x == b.x && a.y == b.y; }
+    friend bool operator!=(FixedVec2 a, FixedVec2 b) { return !(a == b); }
+};
+
+#endif
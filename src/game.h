@@ -3,39 +3,47 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-#include <irrKlang.h>
 #include <vector>
 #include <string>
 #include <tuple>
 #include <algorithm>
 #include <math.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <chrono>
+#include <memory>
+#include <filesystem>
 
 #include "shader.h"
 #include "texture.h"
 #include "resource_manager.h"
 #include "sprite_renderer.h"
 #include "game_level.h"
+#include "level_streamer.h"
+#include "job_graph.h"
+#include "hot_reload.h"
+#include "sound_bank.h"
+#include "music_stream.h"
 #include "text_renderer.h"
 #include "particle_generator.h"
-
-//namespace
-using namespace irrklang;
+#include "profiler.h"
+#include "gl_stats.h"
+#include "startup_report.h"
+#include "collision.h"
+#include "rewind_buffer.h"
+#include "input_recorder.h"
+#include "rollback.h"
+#include "ghost_path.h"
 
 //게임 state
 enum GameState{
     GAME_ACTIVE, // 게임중
+    GAME_LOADING, // 에셋 로딩 화면
     GAME_MENU,   // 게임 매뉴
     GAME_WIN     // 게임 승리
 };
-//방향
-enum Direction {
-	UP,
-	RIGHT,
-	DOWN,
-	LEFT
-};
-
 //플레이어 공 설정
 const float PLAYER_X_SPEED_MAX(200.0f);
 const float PLAYER_Y_SPEED_MAX(400.0f);
@@ -44,96 +52,106 @@ float PLAYER_SPEED_X;
 float PLAYER_SPEED_Y;
 float PLAYER_ACC_X;
 float PLAYER_ACC_Y;
+//고정소수점 물리 모드(--fixed-physics)의 공 속도, 틱 길이
+Fixed FIXED_SPEED_X;
+Fixed FIXED_SPEED_Y;
+const float FIXED_TICK_SECONDS(1.0f / 60.0f);
+const Fixed FIXED_TICK(1.0 / 60.0);
 
-//충돌데이터 튜플
-typedef std::tuple<bool, Direction, glm::vec2> Collision;
-//충돌 방향 벡터 구하기
-Direction VectorDirection(glm::vec2 target)
+//물리 계산 타입별 상태 - float는 화면에 그리는 값(Position, PLAYER_SPEED_X/Y)을 그대로 쓰고,
+//Fixed는 GameObject의 고정소수점 사본을 씀 (게임 규칙 코드는 하나로 두 타입을 모두 처리)
+template <typename Real> struct Physics;
+template <> struct Physics<float>
 {
-    glm::vec2 compass[] = {
-        glm::vec2(0.0f, 1.0f),	// up
-        glm::vec2(-1.0f, 0.0f),	// right
-        glm::vec2(0.0f, -1.0f),	// down
-        glm::vec2(1.0f, 0.0f)	// left
-    };
-    float max = 0.0f;
-    unsigned int best_match = -1;
-    for (unsigned int i = 0; i < 4; i++)
-    {
-        float dot_product = glm::dot(glm::normalize(target), compass[i]);
-        if (dot_product > max)
-        {
-            max = dot_product;
-            best_match = i;
-        }
-    }
-    return (Direction)best_match;
-} 
-//충돌 함수 - 박스 박스
-Collision CheckBoxCollision(GameObject &one, GameObject &two) //AABB-AABB
+    typedef glm::vec2 Vec2;
+    static glm::vec2 &Position(GameObject &object) { return object.Position; }
+    static const glm::vec2 &Size(const GameObject &object) { return object.Size; }
+    static float &SpeedX() { return PLAYER_SPEED_X; }
+    static float &SpeedY() { return PLAYER_SPEED_Y; }
+    static Collision Check(const GameObject &ball, const GameObject &box) { return CheckCollision(ball, box, PLAYER_RADIUS); }
+    static Collision CheckBoxes(const GameObject &one, const GameObject &two) { return CheckBoxCollision(one, two); }
+    //움돌 이동 (double로 계산하던 그대로)
+    static void MoveBlock(float &coordinate, int dir, float dt) { coordinate += (dir * (PLAYER_X_SPEED_MAX * 0.75 * dt)); }
+};
+template <> struct Physics<Fixed>
 {
-    //x축
-    bool collisionX = one.Position.x + one.Size.x >= two.Position.x &&
-        two.Position.x + two.Size.x >= one.Position.x;
-    //y축
-    bool collisionY = one.Position.y + one.Size.y >= two.Position.y &&
-        two.Position.y + two.Size.y >= one.Position.y;
-    
-    //one의 중심
-    glm::vec2 one_half_extents(one.Size.x / 2.0f, one.Size.y / 2.0f);
-    glm::vec2 one_center(
-        one.Position.x + one_half_extents.x, 
-        one.Position.y + one_half_extents.y
-    );
-    //two의 중심
-    glm::vec2 two_half_extents(two.Size.x / 2.0f, two.Size.y / 2.0f);
-    glm::vec2 two_center(
-        two.Position.x + two_half_extents.x, 
-        two.Position.y + two_half_extents.y
-    );
-    //얼마나 깊이 들어갔는가 측정
-    glm::vec2 difference = one_center - two_center;
-    glm::vec2 clamped = glm::clamp(difference, -two_half_extents, two_half_extents);
-    glm::vec2 closest = two_center + clamped;
-    difference = closest - one_center;
-    //x, y둘다 감지되면 충돌
-    return std::make_tuple(collisionX && collisionY, VectorDirection(difference), difference);
-
-} 
-//충돌 함수 - 원 박스
-Collision CheckCollision(GameObject &one, GameObject &two) // AABB-Circle
+    typedef FixedVec2 Vec2;
+    static FixedVec2 &Position(GameObject &object) { return object.FixedPosition; }
+    static const FixedVec2 &Size(const GameObject &object) { return object.FixedSize; }
+    static Fixed &SpeedX() { return FIXED_SPEED_X; }
+    static Fixed &SpeedY() { return FIXED_SPEED_Y; }
+    static FixedCollision Check(const GameObject &ball, const GameObject &box)
+    {
+        return CheckCollision(ball.FixedPosition, box.FixedPosition, box.FixedSize, Fixed(PLAYER_RADIUS));
+    }
+    static FixedCollision CheckBoxes(const GameObject &one, const GameObject &two)
+    {
+        return CheckBoxCollision(one.FixedPosition, one.FixedSize, two.FixedPosition, two.FixedSize);
+    }
+    static void MoveBlock(Fixed &coordinate, int dir, Fixed dt) { coordinate += dir * (Fixed(PLAYER_X_SPEED_MAX * 0.75) * dt); }
+};
+
+//배경음 - 곡이 하나뿐이라 모든 레벨에서 이어서 재생 (MusicPlayer::Play에 다른 곡을 주면 크로스페이드)
+const char *const GAME_MUSIC = "resources/audio/bensound-tenderness.mp3";
+//되감기 - 프레임 속도와 상관없이 120Hz 틱마다 기록, 60초 + 키프레임 묶음 둘 (가득 차서 하나를 버려도 60초 이상, 4MB), 120틱마다 키프레임
+//상태는 16KB까지 미리 할당 (800x600 레벨의 블록이 모두 움돌이어도 들어감)
+const float REWIND_TICK_SECONDS(1.0f / 120.0f);
+const unsigned int REWIND_KEYFRAME(120);
+const size_t REWIND_BUDGET(4 << 20);
+const size_t REWIND_TICKS(60 * 120 + 2 * REWIND_KEYFRAME);
+const size_t REWIND_STATE_BYTES(16 << 10);
+//대전 모드 - 두 공이 같은 레벨을 각자 달림 (공끼리는 부딪히지 않음), 한 사람 몫의 상태
+struct RacePlayer
 {
-    // get center point circle first 
-    glm::vec2 center(one.Position + PLAYER_RADIUS);
-    // calculate AABB info (center, half-extents)
-    glm::vec2 aabb_half_extents(two.Size.x / 2.0f, two.Size.y / 2.0f);
-    glm::vec2 aabb_center(
-        two.Position.x + aabb_half_extents.x, 
-        two.Position.y + aabb_half_extents.y
-    );
-    // get difference vector between both centers
-    glm::vec2 difference = center - aabb_center;
-    glm::vec2 clamped = glm::clamp(difference, -aabb_half_extents, aabb_half_extents);
-    // add clamped value to AABB_center and we get the value of box closest to circle
-    glm::vec2 closest = aabb_center + clamped;
-    // retrieve vector between center circle and closest point AABB and check if length <= radius
-    difference = closest - center;
-    if (glm::length(difference) < PLAYER_RADIUS)
-        return std::make_tuple(true, VectorDirection(difference), difference);
-    else
-        return std::make_tuple(false, UP, glm::vec2(0.0f, 0.0f));
-}
+    GameLevel Level;
+    Fixed SpeedX, SpeedY;
+    unsigned int Deaths = 0;
+    int FinishTick = -1; // 도착한 틱, 달리는 중이면 -1
+};
+const glm::vec3 RIVAL_COLOR(1.0f, 0.45f, 0.45f);
+const float GHOST_ALPHA(0.35f);
+const float MUSIC_VOLUME(0.3f);
+const float MUSIC_CROSSFADE(1.5f);
 
 class Game
 {
 private:
-    SpriteRenderer *Renderer;
-    GameObject *Player;
-    TextRenderer *Text;
-    ParticleGenerator *Particles;
-    ISoundEngine *SoundEngine = createIrrKlangDevice();
-    ISound *Bgm;
+    SpriteRenderer *Renderer = nullptr;
+    GameObject *Player = nullptr;
+    TextRenderer *Text = nullptr;
+    ParticleGenerator *Particles = nullptr;
+    TextureHandle Background;
+    TextureHandle LoadingBar;
+    AudioMixer Mixer; // 효과음, 배경음을 섞는 자체 믹서
+    AudioOutput *Output = nullptr; // 믹서 출력 (irrklang, null, wav)
+    std::string outputName = "irrklang";
+    SoundBank Sounds; // 효과음 (음성 수 제한, 재시작 쿨다운)
+    MusicPlayer Music; // 배경음 (스트리밍)
+    JobGraph Loading; // 시작 시 비동기 에셋 로딩
+    HotReload *Reloader = nullptr; // --hot-reload 일 때만
+    bool showProfiler = false; // F3 - 프로파일러 오버레이
+    std::vector<std::string> profilerLines; // 오버레이 내용, 0.5초마다 갱신
+    double profilerRefresh = 0.0;
+    FrameArena Transient{ 4096 }; // 프레임 동안만 쓰는 데이터 (텍스트 등), Update 시작 시 비움
+    std::chrono::steady_clock::time_point loadStart;
     bool hidden;
+    bool fixedPhysics = false; // --fixed-physics - 고정소수점 물리, 60Hz 고정 틱
+    float fixedAccumulator = 0.0f;
+    RewindBuffer History{ REWIND_BUDGET, REWIND_TICKS, REWIND_KEYFRAME, REWIND_STATE_BYTES }; // BACKSPACE - 틱마다의 상태 (현재 레벨만)
+    std::vector<unsigned char> rewindState; // SaveState/LoadState 버퍼, 생성자에서 REWIND_STATE_BYTES만큼 할당
+    float rewindAccumulator = 0.0f; // 120Hz 되감기 틱 (기록, 되감기 모두)
+    bool rewinding = false;
+    RacePlayer racePlayers[2]; // 대전 모드 (--versus) - 틱 사이에는 여기에, 틱 동안만 CurrentLevel/FIXED_SPEED로 옮겨옴
+    std::unique_ptr<RollbackSession> Versus;
+    int raceLocal = 0;
+    std::vector<unsigned char> raceState; // SaveRaceState/LoadRaceState의 한 사람 몫
+    bool silent = false; // 효과음, 파티클 없이 (상대 공, 롤백으로 다시 계산하는 틱)
+    std::string ghostFolder; // 고스트 (레벨별 최고 기록의 공 경로) 저장 폴더, 비어있으면 끔
+    GhostRecorder ghostRecorder; // 이번 시도의 공 경로
+    GhostPlayback ghostPlayback; // 최고 기록 - 파일에서 조금씩 읽으며 재생
+    float attemptTime = 0.0f; // 이번 시도를 시작한 뒤 흐른 시간 (ACTIVE일 때만)
+    glm::vec2 ghostPosition = glm::vec2(0.0f);
+    bool ghostVisible = false;
 
 public:
     GameState State;
@@ -141,74 +159,125 @@ public:
     bool Keys[1024];
     bool KeysProcessed[1024];
 
-    std::vector<GameLevel> Levels;
+    GameLevel CurrentLevel; // 플레이 중인 레벨 (원본은 LevelLoader가 보관)
+    LevelStreamer LevelLoader;
     unsigned int Level;
+    int pendingLevel = -1; // NextLevel이 예약한 레벨
     unsigned int maxLevel = 9;
     unsigned int deathCount;
+    unsigned int levelLoads = 0; // 레벨 교체/리셋 횟수 - --alloc-check가 그 프레임은 제외
     unsigned int fontSize;
 
     // 생성자 파괴자
     Game(unsigned int width, unsigned int height)
     : State(GAME_MENU), Keys(), Width(width), Height(height)
     {
-
+        this->rewindState.reserve(REWIND_STATE_BYTES);
     }
     ~Game()
     {
+        this->Shutdown();
+        // 출력 스레드가 버퍼를 읽지 않도록 먼저 정지
+        delete Output;
+    }
+    // GL 오브젝트를 가진 멤버 정리 - 전역 Game은 glfwTerminate 뒤에 파괴되므로 main이 그 전에 부름 (두 번 불러도 됨)
+    void Shutdown()
+    {
+        Loading.Wait();
+        delete Reloader;
         delete Renderer;
-        delete Player;
         delete Text;
         delete Particles;
-        SoundEngine->drop();
-        Bgm->drop();
+        Reloader = nullptr;
+        Renderer = nullptr;
+        Text = nullptr;
+        Particles = nullptr;
     }
 
-    // 게임 초기설정, 초기화
+    // 게임 초기설정, 초기화 - 로딩 화면에 필요한 것만 바로 만들고 나머지는 작업 그래프로 비동기 로드
     void Init()
     {
-        // 쉐이더 로드
-        ResourceManager::LoadShader("src/shader/sprite.vs", "src/shader/sprite.fs", nullptr, "sprite");
-        ResourceManager::LoadShader("src/shader/particle.vs", "src/shader/particle.fs", nullptr, "particle");
+        // 에셋 팩 (없으면 개별 파일에서 로드)
+        {
+            STARTUP_PHASE("asset pack");
+            ResourceManager::OpenPack("resources/assets.pak");
+        }
         // 쉐이더 데이터 전달
         glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(this->Width),
             static_cast<float>(this->Height), 0.0f, -1.0f, 1.0f);
+        // 로딩 화면용 - sprite 쉐이더와 1x1 흰색 texture (진행 막대)
+        ResourceManager::LoadShader("src/shader/sprite.vs", "src/shader/sprite.fs", nullptr, "sprite");
         ResourceManager::GetShader("sprite").Use().SetInteger("image", 0);
         ResourceManager::GetShader("sprite").Use().SetMatrix4("projection", projection);
-        ResourceManager::GetShader("particle").Use().SetInteger("sprite", 0);
-        ResourceManager::GetShader("particle").Use().SetMatrix4("projection", projection); 
-        // texture 불러오기
-        ResourceManager::LoadTexture("resources/textures/ball.png", true, "ball");
-        ResourceManager::LoadTexture("resources/textures/block_normal.png", true, "block_normal");
-        ResourceManager::LoadTexture("resources/textures/block_breakable.png", true, "block_breakable");
-        ResourceManager::LoadTexture("resources/textures/block_goal.png", true, "block_goal");
-        ResourceManager::LoadTexture("resources/textures/block_lrmove.png", true, "block_lrmove");
-        ResourceManager::LoadTexture("resources/textures/block_udmove.png", true, "block_udmove");
-        ResourceManager::LoadTexture("resources/textures/block_movewall.png", true, "block_movewall");
-        ResourceManager::LoadTexture("resources/textures/block_rightdir.png", true, "block_rightdir");
-        ResourceManager::LoadTexture("resources/textures/block_leftdir.png", true, "block_leftdir");
-        ResourceManager::LoadTexture("resources/textures/background.jpg", false, "background");
-        ResourceManager::LoadTexture("resources/textures/particle.png", true, "particle");
-        // private 변수에 쉐이더 전달
-        Shader spriteshader = ResourceManager::GetShader("sprite");
-        Renderer = new SpriteRenderer(spriteshader);
-        Shader particleshader = ResourceManager::GetShader("particle");
-        Particles = new ParticleGenerator(particleshader, ResourceManager::GetTexture("particle"), 500);
-        // text renderer, 글꼴 불러오기
-        Text = new TextRenderer(this->Width, this->Height);
-        fontSize = 72;
-        Text->Load("resources/fonts/MaplestoryFont_TTF/Maplestory Bold.ttf", fontSize);
-        // 사운드
-        Bgm = SoundEngine->play2D("resources/audio/bensound-tenderness.mp3", true, false, true);
-        if(Bgm)
-            Bgm->setVolume(0.3f);
-        // 레벨 로드
-        for(int i = 1 ; i <= maxLevel + 1 ; i++)
-        {
-            GameLevel gamelevel;
-            std::string path = "resources/gamelevels/"+std::to_string(i)+".txt";
-            gamelevel.Load(path.c_str(), this->Width, this->Height);
-            this->Levels.push_back(gamelevel);
+        static const unsigned char white[4] = { 255, 255, 255, 255 };
+        TextureImage whiteImage;
+        whiteImage.Width = whiteImage.Height = 1;
+        whiteImage.Channels = 4;
+        whiteImage.Pixels = white;
+        LoadingBar = ResourceManager::UploadTexture(whiteImage, "white", true, "white");
+        Renderer = new SpriteRenderer(ResourceManager::ShaderId("sprite"));
+        Background = ResourceManager::TextureId("background");
+        this->startAudio();
+        this->State = GAME_LOADING;
+        this->loadStart = std::chrono::steady_clock::now();
+
+        // 작업 그래프 - Work는 워커 스레드, Finish(GL)는 Update에서 메인 스레드가 실행
+        JobGraph::Job particleShader = Loading.Add("particle shader", nullptr, [projection]() {
+            ResourceManager::LoadShader("src/shader/particle.vs", "src/shader/particle.fs", nullptr, "particle");
+            ResourceManager::GetShader("particle").Use().SetInteger("sprite", 0);
+            ResourceManager::GetShader("particle").Use().SetMatrix4("projection", projection); 
+        });
+        // texture - 디코딩은 워커에서, 업로드는 메인 스레드에서 (큰 파일 먼저)
+        const TextureRequest textures[] = {
+            { "resources/textures/background.jpg", false, "background" },
+            { "resources/textures/ball.png", true, "ball" },
+            { "resources/textures/block_normal.png", true, "block_normal" },
+            { "resources/textures/block_breakable.png", true, "block_breakable" },
+            { "resources/textures/block_goal.png", true, "block_goal" },
+            { "resources/textures/block_lrmove.png", true, "block_lrmove" },
+            { "resources/textures/block_udmove.png", true, "block_udmove" },
+            { "resources/textures/block_movewall.png", true, "block_movewall" },
+            { "resources/textures/block_rightdir.png", true, "block_rightdir" },
+            { "resources/textures/block_leftdir.png", true, "block_leftdir" },
+            { "resources/textures/particle.png", true, "particle" }
+        };
+        std::vector<JobGraph::Job> textureJobs;
+        JobGraph::Job particleTexture = 0;
+        for (const TextureRequest &request : textures)
+        {
+            std::shared_ptr<TextureImage> image = std::make_shared<TextureImage>();
+            JobGraph::Job job = Loading.Add(request.Name,
+                [image, request]() { *image = ResourceManager::DecodeTexture(request.File); },
+                [image, request]() { ResourceManager::UploadTexture(*image, request.File, request.Alpha, request.Name); });
+            textureJobs.push_back(job);
+            if (request.Name == "particle")
+                particleTexture = job;
         }
+        JobGraph::Job particles = Loading.Add("particles", nullptr, [this]() {
+            Particles = new ParticleGenerator(ResourceManager::ShaderId("particle"), ResourceManager::TextureId("particle"), 500);
+        }, { particleShader, particleTexture });
+        // text renderer, 글꼴 - 글리프 래스터화는 워커에서, 글리프 texture 업로드는 text 쉐이더가 준비된 뒤에
+        fontSize = 72;
+        std::shared_ptr<std::vector<GlyphBitmap>> glyphs = std::make_shared<std::vector<GlyphBitmap>>();
+        JobGraph::Job text = Loading.Add("text shader", nullptr, [this]() {
+            Text = new TextRenderer(this->Width, this->Height);
+        });
+        JobGraph::Job rasterize = Loading.Add("font glyphs", [this, glyphs]() {
+            *glyphs = TextRenderer::Rasterize("resources/fonts/MaplestoryFont_TTF/Maplestory Bold.ttf", fontSize);
+        }, nullptr);
+        Loading.Add("font", nullptr, [this, glyphs]() { Text->Upload(*glyphs); }, { text, rasterize });
+        // 사운드 - 효과음은 워커에서 PCM으로 디코딩, 배경음은 레벨에 들어갈 때 스트리밍 시작
+        Loading.Add("sounds", [this]() { Sounds.Decode(); }, [this]() { Sounds.Attach(Mixer); });
+        // 레벨 - 블록 texture와 파티클이 준비된 뒤 첫 레벨만 읽고 나머지는 플레이 중에 미리 읽어둠
+        std::vector<JobGraph::Job> levelDependencies = textureJobs;
+        levelDependencies.push_back(particles);
+        Loading.Add("level", nullptr, [this]() {
+            this->LevelLoader.Open("resources/gamelevels", maxLevel + 1, this->Width, this->Height);
+            Player = &this->CurrentLevel.Ball;
+            this->enterLevel(0);
+        }, levelDependencies);
+        Loading.Start();
+
         hidden = true;
         // 게임 데이터 초기화
         this->Level = 0;
@@ -220,74 +289,305 @@ public:
         PLAYER_ACC_Y = 1000.0f;
     }
 
-    // 키보드 입력
-    void ProcessInput(float dt)
+    // 플레이어 공 (레벨 로딩 전에는 nullptr) - 헤드리스 도구용
+    const GameObject *GetPlayer() const { return Player; }
+
+    // 고정소수점 물리 (--fixed-physics) - 정수 연산만 써서 x86-64, ARM64 어디서나 같은 입력이면 같은 상태
+    void EnableFixedPhysics() { this->fixedPhysics = true; }
+    bool FixedPhysics() const { return this->fixedPhysics; }
+    // 물리 상태 해시 (FNV-1a) - 공, 속도, 블록 위치/파괴 여부. 고정소수점 모드는 고정소수점 값으로
+    uint64_t StateHash() const
     {
-        // ACTIVE
-        if (this->State == GAME_ACTIVE)
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void *data, size_t size) {
+            const unsigned char *bytes = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+        };
+        auto mixObject = [&](const GameObject &object) {
+            if(this->fixedPhysics)
+                mix(&object.FixedPosition, sizeof(object.FixedPosition));
+            else
+                mix(&object.Position, sizeof(object.Position));
+            unsigned char flags[2] = { object.Destroyed, object.isDirectional };
+            mix(flags, sizeof(flags));
+            mix(&object.Dir, sizeof(object.Dir));
+        };
+        mixObject(this->CurrentLevel.Ball);
+        if(this->fixedPhysics)
+        {
+            mix(&FIXED_SPEED_X, sizeof(FIXED_SPEED_X));
+            mix(&FIXED_SPEED_Y, sizeof(FIXED_SPEED_Y));
+        }
+        else
+        {
+            mix(&PLAYER_SPEED_X, sizeof(PLAYER_SPEED_X));
+            mix(&PLAYER_SPEED_Y, sizeof(PLAYER_SPEED_Y));
+        }
+        for (const GameObject &box : this->CurrentLevel.Blocks)
+            mixObject(box);
+        return hash;
+    }
+    // 되감기용 상태 - 공, 속도, 움돌 위치/방향, 부서지는 블록의 파괴 여부 (나머지 블록은 변하지 않음,
+    // 파티클, 데스카운트는 제외), 크기는 레벨마다 일정
+    void SaveState(std::vector<unsigned char> &state) const
+    {
+        const size_t BALL = sizeof(glm::vec2) + sizeof(FixedVec2) + 2 + sizeof(float) * 2 + sizeof(Fixed) * 2;
+        const size_t MOVING = sizeof(glm::vec2) + sizeof(FixedVec2) + sizeof(int);
+        size_t size = BALL;
+        for (const GameObject &box : this->CurrentLevel.Blocks)
+            size += box.Type == LRMOVE || box.Type == UDMOVE ? MOVING : box.Type == BREAKABLE ? 1 : 0;
+        state.resize(size);
+        unsigned char *out = state.data();
+        auto put = [&out](const void *data, size_t size) {
+            std::memcpy(out, data, size);
+            out += size;
+        };
+        const GameObject &ball = this->CurrentLevel.Ball;
+        put(&ball.Position, sizeof(ball.Position));
+        put(&ball.FixedPosition, sizeof(ball.FixedPosition));
+        put(&ball.Destroyed, 1);
+        put(&ball.isDirectional, 1);
+        put(&PLAYER_SPEED_X, sizeof(PLAYER_SPEED_X));
+        put(&PLAYER_SPEED_Y, sizeof(PLAYER_SPEED_Y));
+        put(&FIXED_SPEED_X, sizeof(FIXED_SPEED_X));
+        put(&FIXED_SPEED_Y, sizeof(FIXED_SPEED_Y));
+        for (const GameObject &box : this->CurrentLevel.Blocks)
         {
-            float maxX = (PLAYER_X_SPEED_MAX);
-            float acc = (PLAYER_ACC_X * dt);
-            // move ball.x
-            if (this->Keys[GLFW_KEY_A] || this->Keys[GLFW_KEY_LEFT])
+            if(box.Type == LRMOVE || box.Type == UDMOVE)
             {
-                if(PLAYER_SPEED_X >= -maxX) // 현재 속도가 최고 속도보다 낮을때 
-                {
-                    PLAYER_SPEED_X -= acc;
-                }
-                else
-                {
-                    PLAYER_SPEED_X += (acc/3.0f); // 속도가 최고 속도보다 높을경우 관성처럼 속도가 조금씩 줄어듬
-                }
-                this->Player->Position.x += (PLAYER_SPEED_X * dt);
-                // 직진상태일 때, 누르면 직진성을 제거
-                if(Player->isDirectional)
-                {
-                    Player->isDirectional = false;
-                    SoundEngine->play2D("resources/audio/false_dir.mp3");
-                }
+                put(&box.Position, sizeof(box.Position));
+                put(&box.FixedPosition, sizeof(box.FixedPosition));
+                put(&box.Dir, sizeof(box.Dir));
             }
-            else if (this->Keys[GLFW_KEY_D] || this->Keys[GLFW_KEY_RIGHT])
+            else if(box.Type == BREAKABLE)
+                put(&box.Destroyed, 1);
+        }
+    }
+    void LoadState(const std::vector<unsigned char> &state)
+    {
+        size_t offset = 0;
+        auto get = [&state, &offset](void *data, size_t size) {
+            if (offset + size <= state.size())
+                std::memcpy(data, state.data() + offset, size);
+            offset += size;
+        };
+        GameObject &ball = this->CurrentLevel.Ball;
+        get(&ball.Position, sizeof(ball.Position));
+        get(&ball.FixedPosition, sizeof(ball.FixedPosition));
+        get(&ball.Destroyed, 1);
+        get(&ball.isDirectional, 1);
+        get(&PLAYER_SPEED_X, sizeof(PLAYER_SPEED_X));
+        get(&PLAYER_SPEED_Y, sizeof(PLAYER_SPEED_Y));
+        get(&FIXED_SPEED_X, sizeof(FIXED_SPEED_X));
+        get(&FIXED_SPEED_Y, sizeof(FIXED_SPEED_Y));
+        for (GameObject &box : this->CurrentLevel.Blocks)
+        {
+            if(box.Type == LRMOVE || box.Type == UDMOVE)
             {
-                if(PLAYER_SPEED_X <= maxX) // 현재 속도가 최고 속도보다 낮을때 
-                {
-                    PLAYER_SPEED_X += acc;
-                }
-                else
-                {
-                    PLAYER_SPEED_X -= (acc/3.0f); // 속도가 최고 속도보다 높을경우 관성처럼 속도가 조금씩 줄어듬
-                }
-                this->Player->Position.x += (PLAYER_SPEED_X * dt);
-                // 직진상태일 때, 누르면 직진성을 제거
-                if(Player->isDirectional)
-                {
-                    Player->isDirectional = false;
-                    SoundEngine->play2D("resources/audio/false_dir.mp3");
-                }
+                get(&box.Position, sizeof(box.Position));
+                get(&box.FixedPosition, sizeof(box.FixedPosition));
+                get(&box.Dir, sizeof(box.Dir));
             }
-            // 관성, 가속도가 남아있는데 점점 줄어드는 것
-            if(!this->Keys[GLFW_KEY_A] && !this->Keys[GLFW_KEY_D] &&
-                !this->Keys[GLFW_KEY_LEFT] && !this->Keys[GLFW_KEY_RIGHT] &&
-                !(Player->isDirectional) )
+            else if(box.Type == BREAKABLE)
+                get(&box.Destroyed, 1);
+        }
+        this->fixedAccumulator = 0.0f;
+    }
+    // 이번 프레임에 지난 되감기 틱 수 (fixedUpdate처럼 남는 시간은 다음 프레임으로, 긴 프레임은 15틱까지만)
+    unsigned int rewindTicks(float dt)
+    {
+        this->rewindAccumulator = std::min(this->rewindAccumulator + dt, REWIND_TICK_SECONDS * 15.0f);
+        unsigned int ticks = 0;
+        while(this->rewindAccumulator >= REWIND_TICK_SECONDS * 0.999f)
+        {
+            this->rewindAccumulator -= REWIND_TICK_SECONDS;
+            ++ticks;
+        }
+        return ticks;
+    }
+    // 되감기 가능한 틱 수, 사용 중인 바이트
+    size_t RewindTicks() const { return this->History.Ticks(); }
+    size_t RewindBytes() const { return this->History.Bytes(); }
+
+    // 대전 모드 시작 - level(0부터)을 두 사람이 동시에 출발, localPlayer(0 또는 1)가 이쪽 공
+    // transport는 경기 동안 살아있어야 함. 고정소수점 물리로 진행 (두 기기가 같은 입력이면 같은 상태)
+    void StartRace(unsigned int level, int localPlayer, Transport &transport)
+    {
+        this->fixedPhysics = true;
+        this->enterLevel(level);
+        for (RacePlayer &player : this->racePlayers)
+        {
+            player.Level = this->LevelLoader.Get(level);
+            player.SpeedX = player.SpeedY = Fixed();
+            player.Deaths = 0;
+            player.FinishTick = -1;
+        }
+        this->raceLocal = localPlayer;
+        this->Versus.reset(new RollbackSession(transport, localPlayer,
+            [this](std::vector<unsigned char> &state) { this->SaveRaceState(state); },
+            [this](const std::vector<unsigned char> &state) { this->LoadRaceState(state); },
+            [this](const unsigned char *inputs, uint32_t tick, bool resimulating) { this->raceStep(inputs, tick, resimulating); }));
+        this->fixedAccumulator = 0.0f;
+        this->State = GAME_ACTIVE;
+    }
+    bool Racing() const { return this->Versus != nullptr; }
+    RollbackSession *Race() { return this->Versus.get(); }
+    const RacePlayer &GetRacePlayer(int player) const { return this->racePlayers[player]; }
+    // 두 사람의 상태 (SaveState 형식 + 데스카운트, 도착 틱) - 롤백 스냅샷
+    void SaveRaceState(std::vector<unsigned char> &state)
+    {
+        state.clear();
+        for (int player = 0; player < 2; ++player)
+        {
+            this->swapRacePlayer(player);
+            this->SaveState(this->raceState);
+            this->swapRacePlayer(player);
+            uint32_t size = uint32_t(this->raceState.size());
+            const unsigned char *sizeBytes = reinterpret_cast<const unsigned char*>(&size);
+            state.insert(state.end(), sizeBytes, sizeBytes + sizeof(size));
+            state.insert(state.end(), this->raceState.begin(), this->raceState.end());
+            const unsigned char *deaths = reinterpret_cast<const unsigned char*>(&this->racePlayers[player].Deaths);
+            state.insert(state.end(), deaths, deaths + sizeof(unsigned int));
+            const unsigned char *finish = reinterpret_cast<const unsigned char*>(&this->racePlayers[player].FinishTick);
+            state.insert(state.end(), finish, finish + sizeof(int));
+        }
+    }
+    void LoadRaceState(const std::vector<unsigned char> &state)
+    {
+        size_t offset = 0;
+        float accumulator = this->fixedAccumulator; // LoadState가 비움
+        for (int player = 0; player < 2 && offset + sizeof(uint32_t) <= state.size(); ++player)
+        {
+            uint32_t size = 0;
+            std::memcpy(&size, state.data() + offset, sizeof(size));
+            offset += sizeof(size);
+            if (offset + size + sizeof(unsigned int) + sizeof(int) > state.size())
+                break;
+            this->raceState.assign(state.begin() + offset, state.begin() + offset + size);
+            offset += size;
+            this->swapRacePlayer(player);
+            this->LoadState(this->raceState);
+            this->swapRacePlayer(player);
+            std::memcpy(&this->racePlayers[player].Deaths, state.data() + offset, sizeof(unsigned int));
+            offset += sizeof(unsigned int);
+            std::memcpy(&this->racePlayers[player].FinishTick, state.data() + offset, sizeof(int));
+            offset += sizeof(int);
+        }
+        this->fixedAccumulator = accumulator;
+    }
+
+    // 핫 리로드 - 레벨, 쉐이더, texture 파일이 바뀌면 그것만 다시 읽음
+    void EnableHotReload()
+    {
+        Reloader = new HotReload();
+        Reloader->Watch("resources/gamelevels");
+        Reloader->Watch("resources/textures");
+        Reloader->Watch("src/shader");
+        std::cout << "Hot reload enabled" << std::endl;
+    }
+    void applyReloads()
+    {
+        std::vector<std::string> levels;
+        Reloader->Update(levels);
+        for (const std::string &file : levels)
+        {
+            // resources/gamelevels/<번호>.txt
+            std::string prefix = "resources/gamelevels/";
+            if (file.compare(0, prefix.size(), prefix) != 0 || file.size() < prefix.size() + 5 ||
+                file.compare(file.size() - 4, 4, ".txt") != 0)
+                continue;
+            int number = std::atoi(file.c_str() + prefix.size());
+            if (number < 1 || number > static_cast<int>(maxLevel) + 1)
+                continue;
+            auto start = std::chrono::steady_clock::now();
+            ResourceManager::PreferLooseFile(file);
+            this->LevelLoader.Invalidate(number - 1);
+            if (number - 1 == static_cast<int>(this->Level))
+                this->ResetLevel();
+            std::cout << "Reloaded level " << number << " in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+        }
+    }
+
+    // 오디오 출력 선택 - "irrklang" (기본), "null", "wav:<파일>", Init 전에 호출
+    void SetAudioOutput(const std::string &name)
+    {
+        outputName = name;
+    }
+    void startAudio()
+    {
+        STARTUP_PHASE("audio device", &outputName);
+        if (outputName.compare(0, 4, "wav:") == 0)
+            Output = new WavFileAudioOutput(outputName.substr(4));
+#ifndef BOUNCYBALL_NO_IRRKLANG
+        else if (outputName == "irrklang")
+            Output = new IrrKlangAudioOutput();
+#endif
+        else
+            Output = new NullAudioOutput();
+        // 사운드 장치가 없으면 null 출력으로 계속 진행
+        if (!Output->Start(Mixer))
+        {
+            delete Output;
+            Output = new NullAudioOutput();
+            Output->Start(Mixer);
+        }
+        std::cout << "Audio output: " << Output->Name() << std::endl;
+        Music.Start(Mixer, openMusic);
+    }
+    // 배경음 디코더 - music_encoder가 만든 스트리밍용 파일을 스트리밍 (곡 길이와 상관없이 일정한 메모리)
+    // 없으면 처음 한 번만 원본을 디코딩해서 그 파일을 만들고 (music_encoder와 같은 형식) 거기서 스트리밍
+    static std::unique_ptr<MusicDecoder> openMusic(const std::string &file)
+    {
+        std::string streamed = StreamedMusicFile(file);
+        std::unique_ptr<MusicDecoder> decoder = openStreamedMusic(streamed);
+        if (decoder)
+            return decoder;
+        std::cout << "WARNING::MUSIC: No streamed version of " << file << ", encoding " << streamed << " once (music_encoder does it ahead of time)" << std::endl;
+        {
+            // 디코딩한 PCM은 파일을 쓰는 동안만
+            AudioBuffer buffer;
+            if (!DecodeSound(file.c_str(), buffer))
+                return nullptr;
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::path(streamed).parent_path(), ec);
+            if (!WriteAdpcmWav(streamed.c_str(), buffer.Samples.data(), buffer.Frames(), AudioMixer::SAMPLE_RATE))
             {
-                if (PLAYER_SPEED_X > acc/2.0f)
-                {
-                    PLAYER_SPEED_X -= (acc/3.0f);
-                    this->Player->Position.x += (PLAYER_SPEED_X * dt);
-                }
-                else if(PLAYER_SPEED_X < -acc/2.0f)
-                {
-                    PLAYER_SPEED_X += (acc/3.0f);
-                    this->Player->Position.x += (PLAYER_SPEED_X * dt);
-                }
-                else
-                {
-                    PLAYER_SPEED_X = 0;
-                }
+                std::cout << "ERROR::MUSIC: Could not write " << streamed << ", playing " << file << " from memory" << std::endl;
+                return std::unique_ptr<MusicDecoder>(new BufferDecoder(std::move(buffer)));
             }
+        }
+        return openStreamedMusic(streamed);
+    }
+    static std::unique_ptr<MusicDecoder> openStreamedMusic(const std::string &streamed)
+    {
+        std::unique_ptr<WavStreamDecoder> wav(new WavStreamDecoder());
+        AssetData data = ResourceManager::MapAsset(streamed.c_str(), wav->Mapping);
+        if (data.IsValid() && wav->Open(data.Data, data.Size))
+            return wav;
+        return nullptr;
+    }
+
+    // 키보드 입력
+    void ProcessInput(float dt)
+    {
+        // 프로파일러 오버레이 토글
+        if (this->Keys[GLFW_KEY_F3] && !this->KeysProcessed[GLFW_KEY_F3])
+        {
+            this->KeysProcessed[GLFW_KEY_F3] = true;
+            showProfiler = !showProfiler;
+            profilerRefresh = 0.0;
+        }
+        // ACTIVE
+        if (this->State == GAME_ACTIVE)
+        {
+            // 고정소수점 모드는 좌우 이동도 고정 틱에서 (fixedUpdate), 되감는 중에는 움직이지 않음
+            if(!this->fixedPhysics && !this->rewinding)
+                this->BallMove(dt);
 
-            // 맵 리셋 버튼
-            if (this->Keys[GLFW_KEY_R] && !this->KeysProcessed[GLFW_KEY_R])
+            // 맵 리셋 버튼 (대전 모드에는 없음)
+            if (this->Keys[GLFW_KEY_R] && !this->KeysProcessed[GLFW_KEY_R] && !this->Racing())
             {
                 this->KeysProcessed[GLFW_KEY_R] = true;
                 playerDeath();
@@ -305,7 +605,7 @@ public:
                 this->Keys[GLFW_KEY_S] && this->Keys[GLFW_KEY_U] && hidden)
             {
                 hidden = false;
-                this->Level = 9;
+                this->enterLevel(9);
                 this->State = GAME_ACTIVE;
             }
         }
@@ -315,9 +615,8 @@ public:
             if(this->Keys[GLFW_KEY_SPACE] && !this->KeysProcessed[GLFW_KEY_SPACE])
             {
                 this->KeysProcessed[GLFW_KEY_SPACE] = true;
-                this->Level = 0;
+                this->enterLevel(0);
                 this->deathCount = 0;
-                this->ResetLevel();
                 this->State = GAME_MENU;
             }
         }
@@ -339,71 +638,156 @@ public:
     {
         Player->Destroyed = false;
         Player->isDirectional = false;
-        Particles->deleteParticle();
+        if(!this->silent)
+            Particles->deleteParticle();
         PLAYER_SPEED_X = 0.0f;
         PLAYER_SPEED_Y = 0.0f;
+        FIXED_SPEED_X = Fixed();
+        FIXED_SPEED_Y = Fixed();
+        this->fixedAccumulator = 0.0f;
     }
-    // 레벨 리셋
+    // 레벨 리셋 - 파일을 다시 읽지 않고 보관해둔 원본 상태로 복사
     void ResetLevel()
     {
-        std::string path = "resources/gamelevels/"+std::to_string(this->Level+1)+".txt";
-        this->Levels[this->Level].Load(path.c_str(), this->Width, this->Height);
+        PROFILE_SCOPE("reset level");
+        ++this->levelLoads;
+        this->CurrentLevel = this->LevelLoader.Get(this->Level);
         ResetPlayer();
+        this->startAttempt(false);
+        // 리셋은 GL 오브젝트를 새로 만들지 않아야 함 (--gl-stats 일 때 늘어나면 경고)
+        GLStats::Main().CheckLeaks("level reset");
     }
-    // 다음 레벨
+    // 다음 레벨 - 충돌 처리 도중에 불리므로 실제 교체는 Update 끝에서 (enterLevel)
     void NextLevel()
     {
         if(this->Level < maxLevel - 1)
         {
-            this->Level++;
+            this->pendingLevel = this->Level + 1;
         }
         else
         {
             //hidden이 true면 히든맵 도전
             if(hidden)
             {
-                this->Level = 9;
+                this->pendingLevel = 9;
                 hidden = false;
             }
             else
                 this->State = GAME_WIN;
         }
     }
+    // 레벨 진입 - 미리 읽어둔 레벨로 교체하고 그 다음 레벨을 백그라운드에서 읽기 시작
+    void enterLevel(unsigned int level)
+    {
+        PROFILE_SCOPE("enter level");
+        ++this->levelLoads;
+        this->Level = level;
+        // 히든맵에 들어왔으면 기회는 쓴 것 (곧장 들어와도 - 도착하면 승리)
+        if(level == maxLevel)
+            hidden = false;
+        this->CurrentLevel = this->LevelLoader.Get(level);
+        ResetPlayer();
+        this->History.Clear();
+        this->rewindAccumulator = 0.0f;
+        this->startAttempt(true);
+        Music.Play(GAME_MUSIC, MUSIC_VOLUME, MUSIC_CROSSFADE);
+        if(level < maxLevel - 1)
+            this->LevelLoader.Prefetch(level + 1);
+        else if(level == maxLevel - 1 && hidden)
+            this->LevelLoader.Prefetch(9);
+    }
+
+    // 고스트 켜기 - 레벨마다 가장 빨리 깬 시도의 공 경로를 folder/level<N>.ghost로 저장하고
+    // 다음 시도부터 반투명 공으로 같이 보여줌 (Init 전에 호출)
+    void EnableGhosts(const std::string &folder)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(folder, ec);
+        if(ec)
+        {
+            std::cout << "WARNING::GHOST: Could not create " << folder << ", ghosts are off" << std::endl;
+            return;
+        }
+        this->ghostFolder = folder;
+    }
+    std::string ghostFile(unsigned int level) const
+    {
+        return this->ghostFolder + "/level" + std::to_string(level + 1) + ".ghost";
+    }
+    // 새 시도 - 기록을 처음부터, 고스트도 처음부터 (newLevel이면 그 레벨의 고스트 파일을 엶)
+    void startAttempt(bool newLevel)
+    {
+        if(this->ghostFolder.empty())
+            return;
+        this->attemptTime = 0.0f;
+        this->ghostVisible = false;
+        this->ghostRecorder.Begin(Player->Position);
+        if(newLevel)
+            this->ghostPlayback.Open(this->ghostFile(this->Level));
+        else
+            this->ghostPlayback.Restart();
+    }
+    // 프레임마다 - 공 위치를 기록하고 같은 시간의 고스트 위치를 보간 (다시 시뮬레이션하지 않음)
+    void updateGhost(float dt)
+    {
+        PROFILE_SCOPE("ghost");
+        this->attemptTime += dt;
+        this->ghostRecorder.Sample(this->attemptTime, Player->Position);
+        this->ghostVisible = this->ghostPlayback.Position(this->attemptTime, this->ghostPosition);
+    }
+    // 레벨을 깼을 때 - 고스트보다 빠르면 (또는 고스트가 없으면) 이번 시도가 새 고스트
+    void finishGhost()
+    {
+        if(this->ghostFolder.empty() || !this->ghostRecorder.Complete())
+            return;
+        if(this->ghostPlayback.IsOpen() && this->ghostRecorder.Ticks() >= this->ghostPlayback.Ticks())
+            return;
+        this->ghostPlayback.Close();
+        this->ghostVisible = false;
+        std::string file = this->ghostFile(this->Level);
+        if(!this->ghostRecorder.Write(file))
+            std::cout << "ERROR::GHOST: Could not write " << file << std::endl;
+        else
+            std::printf("Level %u best time %.2f s, saved as a ghost\n", this->Level + 1, this->ghostRecorder.Ticks() / GHOST_RATE);
+    }
 
     //움돌 함수
-    void moveBlock(float dt)
+    template <typename Real>
+    void moveBlock(Real dt)
     {
-        for (GameObject &box : this->Levels[this->Level].Blocks)
+        for (GameObject &box : this->CurrentLevel.Blocks)
         {
             if(box.Type == LRMOVE)
             {
-                box.Position.x += (box.Dir * (PLAYER_X_SPEED_MAX * 0.75 * dt));
+                Physics<Real>::MoveBlock(Physics<Real>::Position(box).x, box.Dir, dt);
             }
             else if(box.Type == UDMOVE)
             {
-                box.Position.y += (box.Dir * (PLAYER_X_SPEED_MAX * 0.75 * dt));
+                Physics<Real>::MoveBlock(Physics<Real>::Position(box).y, box.Dir, dt);
             }
         }
     }
 
-    // 충돌 처리함수
-    void DoCollisions(float dt)
+    // 충돌 처리함수 (Real = float 또는 Fixed, dt의 타입으로 결정)
+    template <typename Real>
+    void DoCollisions(Real dt)
     {
-        for (GameObject &box : this->Levels[this->Level].Blocks)
+        typedef Physics<Real> P;
+        for (GameObject &box : this->CurrentLevel.Blocks)
         {
             if (!box.Destroyed)
             {
-                Collision collision = CheckCollision(*Player, box);
+                auto collision = P::Check(*Player, box);
                 // 공-블록 충돌
                 if (std::get<0>(collision))
                 {
                     Direction dir = std::get<1>(collision);
-                    glm::vec2 diff_vector = std::get<2>(collision);
+                    typename P::Vec2 diff_vector = std::get<2>(collision);
                     Player->isDirectional = false;
                     // 도착 9
                     if(box.Type == GOAL)
                     {
-                        SoundEngine->play2D("resources/audio/block_goal.mp3");
+                        this->playSound(SOUND_GOAL);
                         ResetPlayer();
                         NextLevel();
                     }
@@ -411,7 +795,7 @@ public:
                     else if(box.Type == TRAP)
                     {
                         Player->Destroyed = true;
-                        SoundEngine->play2D("resources/audio/block_trap.mp3");
+                        this->playSound(SOUND_TRAP);
                     }
                     // 나머지
                     else
@@ -419,234 +803,234 @@ public:
                         // 위에서 충돌
                         if(dir == UP)
                         {   
-                            float penetration = PLAYER_RADIUS - std::abs(diff_vector.y);
-                            Player->Position.y -= penetration;
+                            Real penetration = Real(PLAYER_RADIUS) - Abs(diff_vector.y);
+                            P::Position(*Player).y -= penetration;
                             //일반 블록 1
                             if (box.Type == NORMAL)
                             {
-                                PLAYER_SPEED_Y = -330.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = Real(-330.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //부서지는 불록 2
                             else if (box.Type == BREAKABLE)
                             {
                                 box.Destroyed = true;
-                                PLAYER_SPEED_Y = -330.0f;
-                                SoundEngine->play2D("resources/audio/block_breakable.mp3");
+                                P::SpeedY() = Real(-330.0f);
+                                this->playSound(SOUND_BREAKABLE);
                             }
                             //바운스 블록 4
                             else if (box.Type == BOUNCE)
                             {
-                                PLAYER_SPEED_Y = -533.0f;
-                                SoundEngine->play2D("resources/audio/block_bounce.mp3");
+                                P::SpeedY() = Real(-533.0f);
+                                this->playSound(SOUND_BOUNCE);
                             }
                             //좌우 움돌 5
                             else if (box.Type == LRMOVE)
                             {
-                                PLAYER_SPEED_Y = -330.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = Real(-330.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //상하 움돌 6
                             else if (box.Type == UDMOVE)
                             {
                                 Player->Destroyed = true;
-                                SoundEngine->play2D("resources/audio/block_trap.mp3");
+                                this->playSound(SOUND_TRAP);
                             }
                             //우직진블록 10
                             else if (box.Type == RIGHTDIR)
                             {
                                 Player->isDirectional = true;
-                                PLAYER_SPEED_X = PLAYER_Y_SPEED_MAX;
-                                Player->Position = glm::vec2( ( box.Position.x + box.Size.x + 0.01f ),
-                                                              ( box.Position.y + (box.Size.y/2.0f) - PLAYER_RADIUS ));
-                                SoundEngine->play2D("resources/audio/block_dir.mp3");
+                                P::SpeedX() = Real(PLAYER_Y_SPEED_MAX);
+                                P::Position(*Player) = typename P::Vec2( ( P::Position(box).x + P::Size(box).x + Real(0.01f) ),
+                                                              ( P::Position(box).y + (P::Size(box).y/Real(2.0f)) - Real(PLAYER_RADIUS) ));
+                                this->playSound(SOUND_DIR);
                             }
                             //좌직진블록 11
                             else if (box.Type == LEFTDIR)
                             {
                                 Player->isDirectional = true;
-                                PLAYER_SPEED_X = -PLAYER_Y_SPEED_MAX;
-                                Player->Position = glm::vec2( ( box.Position.x - (PLAYER_RADIUS*2.0f) - 0.01f ),
-                                                              ( box.Position.y + (box.Size.y/2.0f) - PLAYER_RADIUS ));
-                                SoundEngine->play2D("resources/audio/block_dir.mp3");
+                                P::SpeedX() = -Real(PLAYER_Y_SPEED_MAX);
+                                P::Position(*Player) = typename P::Vec2( ( P::Position(box).x - (Real(PLAYER_RADIUS)*Real(2.0f)) - Real(0.01f) ),
+                                                              ( P::Position(box).y + (P::Size(box).y/Real(2.0f)) - Real(PLAYER_RADIUS) ));
+                                this->playSound(SOUND_DIR);
                             }
                         }
                         // 아래에서 충돌
                         else if(dir == DOWN)
                         {      
-                            float penetration = PLAYER_RADIUS - std::abs(diff_vector.y);
-                            Player->Position.y += penetration;
+                            Real penetration = Real(PLAYER_RADIUS) - Abs(diff_vector.y);
+                            P::Position(*Player).y += penetration;
                             //일반 블록 1
                             if (box.Type == NORMAL)
                             {
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = -P::SpeedY();
+                                this->playSound(SOUND_NORMAL);
                             }
                             //부서지는 불록 2
                             else if (box.Type == BREAKABLE)
                             {
                                 box.Destroyed = true;
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y;
-                                SoundEngine->play2D("resources/audio/block_breakable.mp3");
+                                P::SpeedY() = -P::SpeedY();
+                                this->playSound(SOUND_BREAKABLE);
                             }
                             //바운스 블록 4
                             else if (box.Type == BOUNCE)
                             {
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y * 1.618f;
-                                SoundEngine->play2D("resources/audio/block_bounce.mp3");
+                                P::SpeedY() = -P::SpeedY() * Real(1.618f);
+                                this->playSound(SOUND_BOUNCE);
                             }
                             //좌우 움돌 5
                             else if (box.Type == LRMOVE)
                             {
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = -P::SpeedY();
+                                this->playSound(SOUND_NORMAL);
                             }
                             //상하 움돌 6
                             else if (box.Type == UDMOVE)
                             {
                                 Player->Destroyed = true;
-                                SoundEngine->play2D("resources/audio/block_trap.mp3");
+                                this->playSound(SOUND_TRAP);
                             }
                             //우직진블록 10
                             else if (box.Type == RIGHTDIR)
                             {
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = -P::SpeedY();
+                                this->playSound(SOUND_NORMAL);
                             }
                             //좌직진블록 11
                             else if (box.Type == LEFTDIR)
                             {
-                                PLAYER_SPEED_Y = -PLAYER_SPEED_Y;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                P::SpeedY() = -P::SpeedY();
+                                this->playSound(SOUND_NORMAL);
                             }
                         }
                         // 왼쪽에서 충돌
                         else if(dir == LEFT)
                         {   
-                            float penetration = PLAYER_RADIUS - std::abs(diff_vector.x);
-                            Player->Position.x -= penetration;
+                            Real penetration = Real(PLAYER_RADIUS) - Abs(diff_vector.x);
+                            P::Position(*Player).x -= penetration;
                             //일반 블록 1
                             if (box.Type == NORMAL)
                             {
-                                if(PLAYER_SPEED_X > 100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() > Real(100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = -100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(-100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //부서지는 불록 2
                             else if (box.Type == BREAKABLE)
                             {
                                 box.Destroyed = true;
-                                PLAYER_SPEED_X = -PLAYER_SPEED_X;
-                                SoundEngine->play2D("resources/audio/block_breakable.mp3");
+                                P::SpeedX() = -P::SpeedX();
+                                this->playSound(SOUND_BREAKABLE);
                             }
                             //바운스 블록 4
                             else if (box.Type == BOUNCE)
                             {
-                                PLAYER_SPEED_X = -533.0f;
-                                SoundEngine->play2D("resources/audio/block_bounce.mp3");
+                                P::SpeedX() = Real(-533.0f);
+                                this->playSound(SOUND_BOUNCE);
                             }
                             //좌우 움돌 5
                             else if (box.Type == LRMOVE)
                             {
                                 Player->Destroyed = true;                                
-                                SoundEngine->play2D("resources/audio/block_trap.mp3");
+                                this->playSound(SOUND_TRAP);
                             }
                             //상하 움돌 6
                             else if (box.Type == UDMOVE) 
                             {
-                                if(PLAYER_SPEED_X > 100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() > Real(100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = -100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(-100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //우직진블록 10
                             else if (box.Type == RIGHTDIR)
                             {
-                                if(PLAYER_SPEED_X > 100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() > Real(100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = -100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(-100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //좌직진블록 11
                             else if (box.Type == LEFTDIR)
                             {
-                                if(PLAYER_SPEED_X > 100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() > Real(100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = -100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(-100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                         }
                         // 오른쪽에서 충돌
                         else if(dir == RIGHT)
                         {
-                            float penetration = PLAYER_RADIUS - std::abs(diff_vector.x);
-                            Player->Position.x += penetration;
+                            Real penetration = Real(PLAYER_RADIUS) - Abs(diff_vector.x);
+                            P::Position(*Player).x += penetration;
                             //일반 블록 1
                             if (box.Type == NORMAL)
                             {
-                                if(PLAYER_SPEED_X < -100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() < Real(-100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = 100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //부서지는 불록 2
                             else if (box.Type == BREAKABLE)
                             {
                                 box.Destroyed = true;
-                                PLAYER_SPEED_X = -PLAYER_SPEED_X;
-                                SoundEngine->play2D("resources/audio/block_breakable.mp3");
+                                P::SpeedX() = -P::SpeedX();
+                                this->playSound(SOUND_BREAKABLE);
                             }
                             //바운스 블록 4
                             else if (box.Type == BOUNCE)
                             {
-                                PLAYER_SPEED_X = 533.0f;
-                                SoundEngine->play2D("resources/audio/block_bounce.mp3");
+                                P::SpeedX() = Real(533.0f);
+                                this->playSound(SOUND_BOUNCE);
                             }
                             //좌우 움돌 5
                             else if (box.Type == LRMOVE)
                             {
                                 Player->Destroyed = true;                                
-                                SoundEngine->play2D("resources/audio/block_trap.mp3");
+                                this->playSound(SOUND_TRAP);
                             }
                             //상하 움돌 6
                             else if (box.Type == UDMOVE) 
                             {
-                                if(PLAYER_SPEED_X < -100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() < Real(-100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = 100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //우직진블록 10
                             else if (box.Type == RIGHTDIR)
                             {
-                                if(PLAYER_SPEED_X < -100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() < Real(-100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = 100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                             //좌직진블록 11
                             else if (box.Type == LEFTDIR)
                             {
-                                if(PLAYER_SPEED_X < -100.0f)
-                                    PLAYER_SPEED_X = -PLAYER_SPEED_X;
+                                if(P::SpeedX() < Real(-100.0f))
+                                    P::SpeedX() = -P::SpeedX();
                                 else
-                                    PLAYER_SPEED_X = 100.0f;
-                                SoundEngine->play2D("resources/audio/block_normal.wav");
+                                    P::SpeedX() = Real(100.0f);
+                                this->playSound(SOUND_NORMAL);
                             }
                         }
                         // 공이 내부로 뚫고 들어간 경우 - 확인된 상황이 움돌에 끼는 경우, 파괴가 적당함
                         if(dir == -1)
                         {
                             Player->Destroyed = true;
-                            SoundEngine->play2D("resources/audio/block_trap.mp3");
+                            this->playSound(SOUND_TRAP);
                         }
                     }
                 }
@@ -654,33 +1038,33 @@ public:
             //움돌 충돌
             if (box.Type == LRMOVE || box.Type == UDMOVE)
             {
-                for (GameObject &box2 : this->Levels[this->Level].Blocks)
+                for (GameObject &box2 : this->CurrentLevel.Blocks)
                 {
-                    Collision collision = CheckBoxCollision(box, box2);
+                    auto collision = P::CheckBoxes(box, box2);
                     Direction dir = std::get<1>(collision);
-                    glm::vec2 diff_vector = std::get<2>(collision);
-                    if(std::get<0>(collision) && box.Position != box2.Position && !box2.Destroyed)
+                    typename P::Vec2 diff_vector = std::get<2>(collision);
+                    if(std::get<0>(collision) && P::Position(box) != P::Position(box2) && !box2.Destroyed)
                     {
                         box.Dir *= -1;
                         if(dir == UP)
                         {
-                            float penetration = box.Size.y/2.0f - std::abs(diff_vector.y) + 0.05f;
-                            box.Position.y -= penetration;
+                            Real penetration = P::Size(box).y/Real(2.0f) - Abs(diff_vector.y) + Real(0.05f);
+                            P::Position(box).y -= penetration;
                         }
                         else if(dir == DOWN)
                         {
-                            float penetration = box.Size.y/2.0f - std::abs(diff_vector.y) + 0.05f;
-                            box.Position.y += penetration;
+                            Real penetration = P::Size(box).y/Real(2.0f) - Abs(diff_vector.y) + Real(0.05f);
+                            P::Position(box).y += penetration;
                         }
                         else if(dir == LEFT)
                         {
-                            float penetration = box.Size.x/2.0f - std::abs(diff_vector.x) + 0.05f;
-                            box.Position.x -= penetration;
+                            Real penetration = P::Size(box).x/Real(2.0f) - Abs(diff_vector.x) + Real(0.05f);
+                            P::Position(box).x -= penetration;
                         }
                         else if(dir == RIGHT)
                         {
-                            float penetration = box.Size.x/2.0f - std::abs(diff_vector.x) + 0.05f;
-                            box.Position.x += penetration;
+                            Real penetration = P::Size(box).x/Real(2.0f) - Abs(diff_vector.x) + Real(0.05f);
+                            P::Position(box).x += penetration;
                         }
                     }
                 }
@@ -688,97 +1072,463 @@ public:
         }
     }
     // 공 낙하 가속함수
-    void BallAccelation(float dt)
+    template <typename Real>
+    void BallAccelation(Real dt)
     {
-        float maxY = (PLAYER_Y_SPEED_MAX);
-        float acc = (PLAYER_ACC_Y * dt);
-        if(PLAYER_SPEED_Y < maxY) // 현재 속도가 최고 속도보다 낮을때 
+        typedef Physics<Real> P;
+        Real maxY(PLAYER_Y_SPEED_MAX);
+        Real acc = (Real(PLAYER_ACC_Y) * dt);
+        if(P::SpeedY() < maxY) // 현재 속도가 최고 속도보다 낮을때 
         {
-            PLAYER_SPEED_Y += acc;
+            P::SpeedY() += acc;
         }
         else
         {
-            PLAYER_SPEED_Y = maxY; // 속도가 최고 속도보다 높을경우 최고 속도로 고정
+            P::SpeedY() = maxY; // 속도가 최고 속도보다 높을경우 최고 속도로 고정
         }
-        this->Player->Position.y += (PLAYER_SPEED_Y * dt);
+        P::Position(*this->Player).y += (P::SpeedY() * dt);
     }
     // 공 직진 함수
-    void BallDirectional(float dt)
+    template <typename Real>
+    void BallDirectional(Real dt)
+    {
+        typedef Physics<Real> P;
+        P::Position(*this->Player).x += P::SpeedX() * dt;
+        P::SpeedY() = Real(0.0f);
+    }
+    // 공 좌우 이동 (키 입력) - float 모드는 ProcessInput에서, 고정소수점 모드는 틱마다
+    template <typename Real>
+    void BallMove(Real dt)
+    {
+        typedef Physics<Real> P;
+        Real maxX(PLAYER_X_SPEED_MAX);
+        Real acc = (Real(PLAYER_ACC_X) * dt);
+        // move ball.x
+        if (this->Keys[GLFW_KEY_A] || this->Keys[GLFW_KEY_LEFT])
+        {
+            if(P::SpeedX() >= -maxX) // 현재 속도가 최고 속도보다 낮을때 
+            {
+                P::SpeedX() -= acc;
+            }
+            else
+            {
+                P::SpeedX() += (acc/Real(3.0f)); // 속도가 최고 속도보다 높을경우 관성처럼 속도가 조금씩 줄어듬
+            }
+            P::Position(*this->Player).x += (P::SpeedX() * dt);
+            // 직진상태일 때, 누르면 직진성을 제거
+            if(Player->isDirectional)
+            {
+                Player->isDirectional = false;
+                this->playSound(SOUND_FALSE_DIR);
+            }
+        }
+        else if (this->Keys[GLFW_KEY_D] || this->Keys[GLFW_KEY_RIGHT])
+        {
+            if(P::SpeedX() <= maxX) // 현재 속도가 최고 속도보다 낮을때 
+            {
+                P::SpeedX() += acc;
+            }
+            else
+            {
+                P::SpeedX() -= (acc/Real(3.0f)); // 속도가 최고 속도보다 높을경우 관성처럼 속도가 조금씩 줄어듬
+            }
+            P::Position(*this->Player).x += (P::SpeedX() * dt);
+            // 직진상태일 때, 누르면 직진성을 제거
+            if(Player->isDirectional)
+            {
+                Player->isDirectional = false;
+                this->playSound(SOUND_FALSE_DIR);
+            }
+        }
+        // 관성, 가속도가 남아있는데 점점 줄어드는 것
+        if(!this->Keys[GLFW_KEY_A] && !this->Keys[GLFW_KEY_D] &&
+            !this->Keys[GLFW_KEY_LEFT] && !this->Keys[GLFW_KEY_RIGHT] &&
+            !(Player->isDirectional) )
+        {
+            if (P::SpeedX() > acc/Real(2.0f))
+            {
+                P::SpeedX() -= (acc/Real(3.0f));
+                P::Position(*this->Player).x += (P::SpeedX() * dt);
+            }
+            else if(P::SpeedX() < -acc/Real(2.0f))
+            {
+                P::SpeedX() += (acc/Real(3.0f));
+                P::Position(*this->Player).x += (P::SpeedX() * dt);
+            }
+            else
+            {
+                P::SpeedX() = Real(0.0f);
+            }
+        }
+    }
+    // 고정소수점 물리 - 프레임 시간과 상관없이 60Hz 고정 틱으로 진행 (같은 입력이면 어느 기기에서나 같은 상태)
+    void fixedUpdate(float dt)
     {
-        this->Player->Position.x += PLAYER_SPEED_X * dt;
-        PLAYER_SPEED_Y = 0;
+        this->fixedAccumulator = std::min(this->fixedAccumulator + dt, FIXED_TICK_SECONDS * 15.0f);
+        while(this->fixedAccumulator >= FIXED_TICK_SECONDS * 0.999f)
+        {
+            this->fixedAccumulator -= FIXED_TICK_SECONDS;
+            // 메인 루프와 같은 순서 (Update 다음 ProcessInput)
+            if(!Player->isDirectional)
+                this->BallAccelation(FIXED_TICK);
+            else
+                this->BallDirectional(FIXED_TICK);
+            this->DoCollisions(FIXED_TICK);
+            this->moveBlock(FIXED_TICK);
+            this->BallMove(FIXED_TICK);
+            this->syncFixedState();
+            // 죽었거나 레벨이 끝났으면 남은 틱은 버림 (Update에서 처리)
+            if(Player->Destroyed || this->pendingLevel >= 0 || this->State != GAME_ACTIVE || this->outOfBounds())
+                break;
+        }
+    }
+    // 고정소수점 상태를 그리기용 float 값에 반영
+    void syncFixedState()
+    {
+        Player->Position = Player->FixedPosition.ToFloat();
+        for (GameObject &box : this->CurrentLevel.Blocks)
+        {
+            if(box.Type == LRMOVE || box.Type == UDMOVE)
+                box.Position = box.FixedPosition.ToFloat();
+        }
+        PLAYER_SPEED_X = FIXED_SPEED_X.ToFloat();
+        PLAYER_SPEED_Y = FIXED_SPEED_Y.ToFloat();
+    }
+    // 효과음 - 대전 모드의 상대 공, 롤백으로 다시 계산하는 틱은 소리 없이
+    void playSound(SoundEffect id)
+    {
+        if(!this->silent)
+            Sounds.Play(id);
+    }
+
+    // 대전 모드 - player의 상태를 CurrentLevel, FIXED_SPEED, deathCount와 맞바꿈 (두 번 부르면 원래대로)
+    void swapRacePlayer(int player)
+    {
+        RacePlayer &race = this->racePlayers[player];
+        std::swap(this->CurrentLevel, race.Level);
+        std::swap(FIXED_SPEED_X, race.SpeedX);
+        std::swap(FIXED_SPEED_Y, race.SpeedY);
+        std::swap(this->deathCount, race.Deaths);
+        PLAYER_SPEED_X = FIXED_SPEED_X.ToFloat();
+        PLAYER_SPEED_Y = FIXED_SPEED_Y.ToFloat();
+    }
+    // 대전 모드 한 틱 - 두 사람 모두 (RollbackSession이 부름, inputs는 PackInputKeys 형식)
+    void raceStep(const unsigned char *inputs, uint32_t tick, bool resimulating)
+    {
+        float accumulator = this->fixedAccumulator; // ResetPlayer가 비움, raceUpdate가 쓰는 중
+        for (int player = 0; player < 2; ++player)
+        {
+            this->silent = resimulating || player != this->raceLocal;
+            this->swapRacePlayer(player);
+            this->raceTick(player, inputs[player], tick);
+            this->swapRacePlayer(player);
+        }
+        this->silent = false;
+        this->fixedAccumulator = accumulator;
+    }
+    // 옮겨온 한 사람의 상태를 고정 틱 하나만큼 진행 (fixedUpdate와 같은 순서), 죽으면 레벨 리셋, 도착하면 멈춤
+    void raceTick(int player, unsigned char input, uint32_t tick)
+    {
+        RacePlayer &race = this->racePlayers[player];
+        if(race.FinishTick >= 0)
+            return;
+        bool keys[INPUT_KEY_COUNT];
+        for (unsigned int i = 0; i < INPUT_KEY_COUNT; ++i)
+        {
+            keys[i] = this->Keys[INPUT_KEYS[i]];
+            this->Keys[INPUT_KEYS[i]] = (input >> i) & 1;
+        }
+        bool wasHidden = this->hidden;
+        if(!Player->isDirectional)
+            this->BallAccelation(FIXED_TICK);
+        else
+            this->BallDirectional(FIXED_TICK);
+        this->DoCollisions(FIXED_TICK);
+        this->moveBlock(FIXED_TICK);
+        this->BallMove(FIXED_TICK);
+        this->syncFixedState();
+        for (unsigned int i = 0; i < INPUT_KEY_COUNT; ++i)
+            this->Keys[INPUT_KEYS[i]] = keys[i];
+        // 도착 - NextLevel이 예약한 레벨, 승리 화면은 취소
+        if(this->pendingLevel >= 0 || this->State != GAME_ACTIVE)
+        {
+            race.FinishTick = int(tick);
+            this->pendingLevel = -1;
+            this->State = GAME_ACTIVE;
+            this->hidden = wasHidden;
+        }
+        else if(Player->Destroyed || this->outOfBounds())
+        {
+            ++this->deathCount;
+            this->CurrentLevel = this->LevelLoader.Get(this->Level);
+            ResetPlayer();
+        }
+    }
+    // 대전 모드 업데이트 - 고정 틱마다 이쪽 입력으로 한 틱 (상대 입력이 너무 밀리면 기다림)
+    void raceUpdate(float dt)
+    {
+        this->fixedAccumulator = std::min(this->fixedAccumulator + dt, FIXED_TICK_SECONDS * 15.0f);
+        unsigned char input = PackInputKeys(this->Keys);
+        while(this->fixedAccumulator >= FIXED_TICK_SECONDS * 0.999f)
+        {
+            if(!this->Versus->Advance(input))
+                break;
+            this->fixedAccumulator -= FIXED_TICK_SECONDS;
+        }
+    }
+
+    bool outOfBounds() const
+    {
+        return Player->Position.y >= this->Height || Player->Position.x <= 0.0f ||
+               Player->Position.x >= (this->Width + Player->Size.x);
     }
 
     // 게임 업데이트
     void Update(float dt)
     {
-        if(State == GAME_ACTIVE)
+        Transient.Reset();
+        // 로딩 - 프레임마다 8ms 까지만 메인 스레드 작업(GL 업로드)을 처리해서 화면이 멈추지 않게
+        if(State == GAME_LOADING)
         {
-            if(!Player->isDirectional)
-                this->BallAccelation(dt);
+            if(Loading.Pump(8.0))
+            {
+                std::cout << "Assets loaded in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count()
+                          << " ms" << std::endl;
+                StartupReport::Main().Mark("assets loaded");
+                State = GAME_MENU;
+            }
+        }
+        else if(Reloader)
+            this->applyReloads();
+        Music.Update();
+        if(State == GAME_ACTIVE && this->Racing())
+        {
+            {
+                PROFILE_SCOPE("versus");
+                this->raceUpdate(dt);
+            }
+            PROFILE_SCOPE("particles update");
+            Particles->Update(dt, this->racePlayers[this->raceLocal].Level.Ball, 2, glm::vec2(PLAYER_RADIUS / 2.65f) );
+        }
+        else if(State == GAME_ACTIVE)
+        {
+            // 되감기 - BACKSPACE를 누르고 있는 동안 120Hz 틱마다 한 틱씩 뒤로, 실제 시간과 같은 속도 (기록이 끝나면 멈춤, 데스카운트는 그대로)
+            this->rewinding = this->Keys[GLFW_KEY_BACKSPACE];
+            if(this->rewinding)
+            {
+                PROFILE_SCOPE("rewind");
+                bool rewound = false;
+                for(unsigned int ticks = this->rewindTicks(dt); ticks > 0 && this->History.Rewind(this->rewindState); --ticks)
+                    rewound = true;
+                if(rewound)
+                    this->LoadState(this->rewindState);
+            }
+            else if(this->fixedPhysics)
+            {
+                PROFILE_SCOPE("fixed physics");
+                this->fixedUpdate(dt);
+            }
             else
-                BallDirectional(dt);
+            {
+                if(!Player->isDirectional)
+                    this->BallAccelation(dt);
+                else
+                    BallDirectional(dt);
 
-            this->DoCollisions(dt);
-            this->moveBlock(dt);
-            Particles->Update(dt, *Player, 2, glm::vec2(PLAYER_RADIUS / 2.65f) );
+                {
+                    PROFILE_SCOPE("collisions");
+                    this->DoCollisions(dt);
+                }
+                {
+                    PROFILE_SCOPE("move blocks");
+                    this->moveBlock(dt);
+                }
+            }
+            {
+                PROFILE_SCOPE("particles update");
+                Particles->Update(dt, *Player, 2, glm::vec2(PLAYER_RADIUS / 2.65f) );
+            }
+            // 고스트 - 되감는 동안에도 시간은 흐름
+            if(!this->ghostFolder.empty())
+                this->updateGhost(dt);
+            if(this->rewinding)
+                return;
+            // 도착 - 다음 레벨로 넘어가기 전에 기록 저장
+            if(this->pendingLevel >= 0 || this->State == GAME_WIN)
+                this->finishGhost();
             //스테이지 실패
-            if(Player->Position.y >= this->Height || Player->Position.x <= 0.0f ||
-                 Player->Position.x >= (this->Width + Player->Size.x) || Player->Destroyed)
+            if(this->outOfBounds() || Player->Destroyed)
             {
                 playerDeath();
             }
+            // 도착 지점에 닿았으면 미리 읽어둔 다음 레벨로 교체
+            if(this->pendingLevel >= 0)
+            {
+                this->enterLevel(this->pendingLevel);
+                this->pendingLevel = -1;
+            }
+            // 되감기 기록 - 지난 120Hz 틱마다 한 번 (같은 상태가 반복되면 몇 바이트), 레벨 시작 상태는 바로
+            {
+                PROFILE_SCOPE("rewind capture");
+                unsigned int ticks = this->rewindTicks(dt);
+                if(this->History.Empty())
+                    ticks = std::max(ticks, 1u);
+                if(ticks > 0)
+                    this->SaveState(this->rewindState);
+                for(; ticks > 0; --ticks)
+                    this->History.Capture(this->rewindState.data(), this->rewindState.size());
+            }
         }
     }
     // 게임화면 렌더링
     void Render()
     {   
+        if(this->State == GAME_LOADING)
+        {
+            // 진행 막대
+            glm::vec2 size(this->Width * 0.5f, 12.0f);
+            glm::vec2 pos((this->Width - size.x) * 0.5f, this->Height * 0.5f);
+            Renderer->DrawSprite(LoadingBar, pos - glm::vec2(2.0f), size + glm::vec2(4.0f), 0.0f, glm::vec3(0.25f));
+            Renderer->DrawSprite(LoadingBar, pos, glm::vec2(size.x * Loading.Progress(), size.y), 0.0f, glm::vec3(0.0f, 0.8f, 0.5f));
+        }
         if(this->State == GAME_MENU)
         {
             // draw background
-            Texture2D background = ResourceManager::GetTexture("background");
-            Renderer->DrawSprite(background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
+            Renderer->DrawSprite(Background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
             // draw text
-            std::stringstream ss1; ss1 << "BOUNCY BALL";
             float moveText = abs(sin(glfwGetTime() * 3.0f)) * 30.0f;
-            Text->RenderText(ss1.str(), 165.0f, (220.0f - moveText) , 1.0f, glm::vec3(0.0f, 0.8f, 0.5f));
-            std::stringstream ss2; ss2 << "Press 'SPACE' to Start!!";
-            Text->RenderText(ss2.str(), 255.0f, 280.0f, 0.333f, glm::vec3(0.0f));
-            std::stringstream ss3; ss3 << "Left : A, left // Right : D, right // Reset : R // Quit : ESC";
-            Text->RenderText(ss3.str(), 180.0f, 330.0f, 0.25f, glm::vec3(0.0f));
+            Text->RenderText("BOUNCY BALL", 165.0f, (220.0f - moveText) , 1.0f, glm::vec3(0.0f, 0.8f, 0.5f));
+            Text->RenderText("Press 'SPACE' to Start!!", 255.0f, 280.0f, 0.333f, glm::vec3(0.0f));
+            Text->RenderText("Left : A, left // Right : D, right // Reset : R // Quit : ESC", 180.0f, 330.0f, 0.25f, glm::vec3(0.0f));
         }
-        if(this->State == GAME_ACTIVE)
+        if(this->State == GAME_ACTIVE && this->Racing())
+            this->renderRace();
+        else if(this->State == GAME_ACTIVE)
         {
             // draw background
-            Texture2D background = ResourceManager::GetTexture("background");
-            Renderer->DrawSprite(background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
+            {
+                PROFILE_SCOPE("draw background");
+                Renderer->DrawSprite(Background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
+            }
             // draw particles
-            Particles->Draw();
+            {
+                PROFILE_SCOPE("draw particles");
+                Particles->Draw();
+            }
             // draw level
-            this->Levels[this->Level].Draw(*Renderer);
+            {
+                PROFILE_SCOPE("draw level");
+                this->CurrentLevel.Draw(*Renderer);
+            }
+            // draw ghost - 최고 기록의 공, 반투명
+            if(this->ghostVisible)
+                Renderer->DrawSprite(Player->Sprite, this->ghostPosition, Player->Size, 0.0f, Player->Color, GHOST_ALPHA);
             // draw player
-            Player = this->Levels[this->Level].Ball;
             Player->Draw(*Renderer);
             // draw text
-            std::stringstream lv; lv << this->Level + 1;
-            Text->RenderText("Level : " + lv.str(), 5.0f, 5.0f, 0.33f, glm::vec3(0.0f));
-            std::stringstream dc; dc << this->deathCount;
-            Text->RenderText("Death : " + dc.str(), 5.0f, 30.0f, 0.33f, glm::vec3(0.0f));
+            PROFILE_SCOPE("draw text");
+            // 문자열은 프레임 arena에 - 매 프레임 힙 할당 없음
+            Text->RenderText(Transient.Format("Level : %u", this->Level + 1), 5.0f, 5.0f, 0.33f, glm::vec3(0.0f));
+            Text->RenderText(Transient.Format("Death : %u", this->deathCount), 5.0f, 30.0f, 0.33f, glm::vec3(0.0f));
+            if(this->ghostPlayback.IsOpen())
+                Text->RenderText(Transient.Format("Best : %.2f s", this->ghostPlayback.Ticks() / GHOST_RATE), 5.0f, 55.0f, 0.33f, glm::vec3(0.0f));
         }
         if(this->State == GAME_WIN)
         {
             // draw background
-            Texture2D background = ResourceManager::GetTexture("background");
-            Renderer->DrawSprite(background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
+            Renderer->DrawSprite(Background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
             // draw text
-            std::stringstream ss1; ss1 << "Thanks for Playing!";
-            float moveText = abs(sin(glfwGetTime() * 3.0f)) * 30.0f;
-            Text->RenderText(ss1.str(), 70.0f, (220.0f) , 1.0f, glm::vec3(0.0f, 0.8f, 0.5f));
-            std::stringstream ss2; ss2 << "Your Death Count! : " << deathCount;
-            Text->RenderText(ss2.str(), 270.0f, 290.0f, 0.333f, glm::vec3(0.0f));
-            std::stringstream ss3; ss3 << "Press 'SPACE' to Menu!!";
-            Text->RenderText(ss3.str(), 290.0f, 330.0f, 0.25f, glm::vec3(0.0f));
+            Text->RenderText("Thanks for Playing!", 70.0f, (220.0f) , 1.0f, glm::vec3(0.0f, 0.8f, 0.5f));
+            Text->RenderText(Transient.Format("Your Death Count! : %u", deathCount), 270.0f, 290.0f, 0.333f, glm::vec3(0.0f));
+            Text->RenderText("Press 'SPACE' to Menu!!", 290.0f, 330.0f, 0.25f, glm::vec3(0.0f));
+        }
+        if(showProfiler && Text)
+            this->renderProfiler();
+    }
+
+    // 대전 모드 화면 - 이쪽 레벨과 공, 상대 공은 붉게 (상대 레벨은 부서진 블록만 다를 수 있어서 그리지 않음)
+    void renderRace()
+    {
+        RacePlayer &local = this->racePlayers[this->raceLocal];
+        RacePlayer &rival = this->racePlayers[1 - this->raceLocal];
+        Renderer->DrawSprite(Background, glm::vec2(0.0f, 0.0f), glm::vec2(this->Width, this->Height), 0.0f);
+        Particles->Draw();
+        local.Level.Draw(*Renderer);
+        glm::vec3 color = rival.Level.Ball.Color;
+        rival.Level.Ball.Color = RIVAL_COLOR;
+        rival.Level.Ball.Draw(*Renderer);
+        rival.Level.Ball.Color = color;
+        local.Level.Ball.Draw(*Renderer);
+        Text->RenderText(Transient.Format("Level : %u", this->Level + 1), 5.0f, 5.0f, 0.33f, glm::vec3(0.0f));
+        Text->RenderText(Transient.Format("Death : %u", local.Deaths), 5.0f, 30.0f, 0.33f, glm::vec3(0.0f));
+        Text->RenderText(Transient.Format("Rival Death : %u", rival.Deaths), 5.0f, 55.0f, 0.33f, RIVAL_COLOR * 0.6f);
+        // 결과는 확정된 틱 안에서 도착한 것만 (그 뒤는 예측한 상대 입력으로 계산한 것일 수 있음)
+        // 한 사람만 확정이면 다른 사람은 그보다 늦게 도착
+        uint32_t confirmed = this->Versus->ConfirmedTick();
+        bool localDone = local.FinishTick >= 0 && uint32_t(local.FinishTick) < confirmed;
+        bool rivalDone = rival.FinishTick >= 0 && uint32_t(rival.FinishTick) < confirmed;
+        const char *result = nullptr;
+        if(localDone && rivalDone)
+            result = local.FinishTick < rival.FinishTick ? "You Win!" : local.FinishTick > rival.FinishTick ? "You Lose..." : "Draw";
+        else if(localDone)
+            result = "You Win!";
+        else if(rivalDone)
+            result = "You Lose...";
+        if(result)
+            Text->RenderText(result, 290.0f, 260.0f, 0.5f, glm::vec3(0.0f, 0.8f, 0.5f));
+        if(localDone)
+            Text->RenderText(Transient.Format("Time : %.2f s", local.FinishTick * FIXED_TICK_SECONDS), 330.0f, 310.0f, 0.33f, glm::vec3(0.0f));
+        if(this->Versus->Waiting())
+            Text->RenderText("Waiting for rival...", 5.0f, 80.0f, 0.25f, glm::vec3(0.0f));
+    }
+
+    // 프로파일러 오버레이 - 구간별 평균, 프레임 p50/p99/max (ms)
+    void renderProfiler()
+    {
+        ALLOC_SCOPE("profiler overlay"); // 갱신할 때 할당 (--alloc-check는 오버레이 없이)
+        double now = glfwGetTime();
+        if(now - profilerRefresh > 0.5)
+        {
+            profilerRefresh = now;
+            profilerLines.clear();
+            char line[128];
+            for (const Profiler::ScopeStats &scope : Profiler::Main().Summary())
+            {
+                std::snprintf(line, sizeof(line), "%-16s avg %6.2f  p50 %6.2f  p99 %6.2f  max %6.2f",
+                              scope.Name.c_str(), scope.Average, scope.P50, scope.P99, scope.Max);
+                profilerLines.push_back(line);
+            }
+            if(profilerLines.empty())
+                profilerLines.push_back("profiler: no frames recorded");
+            // --gl-stats: 지난 프레임의 GL 호출 수 (구간별), 살아있는 GL 오브젝트 수
+            const GLStats &gl = GLStats::Main();
+            if(gl.Installed())
+            {
+                std::snprintf(line, sizeof(line), "gl %5llu draws %5llu binds %5llu uniforms %5llu lookups %4llu uploads",
+                              (unsigned long long)gl.Last(GLStats::DRAWS), (unsigned long long)gl.Last(GLStats::BINDS),
+                              (unsigned long long)gl.Last(GLStats::UNIFORMS), (unsigned long long)gl.Last(GLStats::UNIFORM_LOOKUPS),
+                              (unsigned long long)(gl.Last(GLStats::BUFFER_UPLOADS) + gl.Last(GLStats::TEXTURE_UPLOADS)));
+                profilerLines.push_back(line);
+                for (unsigned int scope = 1; scope < Profiler::Main().ScopeCount(); ++scope)
+                    if(gl.Last(scope, GLStats::DRAWS) > 0 || gl.Last(scope, GLStats::BUFFER_UPLOADS) > 0)
+                    {
+                        std::snprintf(line, sizeof(line), "  %-16s %5llu draws %5llu uniforms %5llu lookups %4llu uploads",
+                                      Profiler::Main().ScopeName(scope), (unsigned long long)gl.Last(scope, GLStats::DRAWS),
+                                      (unsigned long long)gl.Last(scope, GLStats::UNIFORMS), (unsigned long long)gl.Last(scope, GLStats::UNIFORM_LOOKUPS),
+                                      (unsigned long long)gl.Last(scope, GLStats::BUFFER_UPLOADS));
+                        profilerLines.push_back(line);
+                    }
+                std::snprintf(line, sizeof(line), "gl alive: %lld textures, %lld buffers, %lld vertex arrays, %lld programs",
+                              (long long)gl.Live(GLStats::TEXTURES), (long long)gl.Live(GLStats::BUFFERS),
+                              (long long)gl.Live(GLStats::VERTEX_ARRAYS), (long long)gl.Live(GLStats::PROGRAMS));
+                profilerLines.push_back(line);
+            }
         }
+        float lineHeight = 15.0f;
+        Renderer->DrawSprite(LoadingBar, glm::vec2(this->Width - 395.0f, 5.0f), glm::vec2(390.0f, lineHeight * profilerLines.size() + 10.0f),
+                             0.0f, glm::vec3(0.1f));
+        for (size_t i = 0; i < profilerLines.size(); ++i)
+            Text->RenderText(profilerLines[i], this->Width - 390.0f, 10.0f + lineHeight * i, 0.17f, glm::vec3(0.9f));
     }
 
 };
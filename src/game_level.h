@@ -15,37 +15,49 @@
 class GameLevel
 {
 public:
-    // player
-    GameObject *Ball;
+    // player (start position of the level)
+    GameObject Ball;
     float radius = 7.0f;
     // level state
     std::vector<GameObject> Blocks;
     // constructor
     GameLevel() { }
-    // loads level from file
+    // loads level from file (safe to call from a worker thread, the level owns no GL objects)
     void Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
     {
         // clear old data
         this->Blocks.clear();
-        // load from file
-        unsigned int tileCode;
-        GameLevel level;
-        std::string line;
-        std::ifstream fstream(file);
+        // load from the asset pack or file
+        AssetData asset = ResourceManager::ReadAsset(file);
+        if (asset.IsValid())
+            this->Parse(asset.Chars(), asset.Size, levelWidth, levelHeight);
+    }
+    // builds the level from the text of a level file (rows of space separated tile codes)
+    void Parse(const char *text, size_t size, unsigned int levelWidth, unsigned int levelHeight)
+    {
+        this->Blocks.clear();
         std::vector<std::vector<unsigned int>> tileData;
-        if (fstream)
+        std::vector<unsigned int> row;
+        const char *end = text + size;
+        for (const char *c = text; c < end; )
         {
-            while (std::getline(fstream, line)) // read each line from level file
+            if (*c >= '0' && *c <= '9') // read each number separated by spaces
+            {
+                unsigned int tileCode = 0;
+                while (c < end && *c >= '0' && *c <= '9')
+                    tileCode = tileCode * 10 + (*c++ - '0');
+                row.push_back(tileCode);
+            }
+            else if (*c++ == '\n') // each line is a row of tiles
             {
-                std::istringstream sstream(line);
-                std::vector<unsigned int> row;
-                while (sstream >> tileCode) // read each word separated by spaces
-                    row.push_back(tileCode);
                 tileData.push_back(row);
+                row.clear();
             }
-            if (tileData.size() > 0)
-                this->init(tileData, levelWidth, levelHeight);
         }
+        if (!row.empty())
+            tileData.push_back(row);
+        if (tileData.size() > 0)
+            this->init(tileData, levelWidth, levelHeight);
     }
     // render level
     void Draw(SpriteRenderer &renderer)
@@ -70,6 +82,15 @@ private:
     unsigned int height = tileData.size();
     unsigned int width = tileData[0].size(); // note we can index vector at [0] since this function is only called if height > 0
     float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height; 
+        // resolve the tile sprites once instead of looking each name up per tile
+        TextureHandle blockNormalSprite = ResourceManager::TextureId("block_normal");
+        TextureHandle blockBreakableSprite = ResourceManager::TextureId("block_breakable");
+        TextureHandle blockLrmoveSprite = ResourceManager::TextureId("block_lrmove");
+        TextureHandle blockUdmoveSprite = ResourceManager::TextureId("block_udmove");
+        TextureHandle ballSprite = ResourceManager::TextureId("ball");
+        TextureHandle blockGoalSprite = ResourceManager::TextureId("block_goal");
+        TextureHandle blockRightdirSprite = ResourceManager::TextureId("block_rightdir");
+        TextureHandle blockLeftdirSprite = ResourceManager::TextureId("block_leftdir");
         // initialize level tiles based on tileData		
         for (unsigned int y = 0; y < height; ++y)
         {
@@ -81,7 +102,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_normal"), glm::vec3(1.0f));
+                    GameObject obj(pos, size, blockNormalSprite, glm::vec3(1.0f));
                     obj.Type = NORMAL;
                     this->Blocks.push_back(obj);
                 }
@@ -89,7 +110,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_breakable"), glm::vec3(1.0f));
+                    GameObject obj(pos, size, blockBreakableSprite, glm::vec3(1.0f));
                     obj.Type = BREAKABLE;
                     this->Blocks.push_back(obj);
                 }
@@ -97,7 +118,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_normal"), glm::vec3(0.8f, 0.3f, 0.3f));
+                    GameObject obj(pos, size, blockNormalSprite, glm::vec3(0.8f, 0.3f, 0.3f));
                     obj.Type = TRAP;
                     this->Blocks.push_back(obj);
                 }
@@ -105,7 +126,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_normal"), glm::vec3(0.8f, 0.3f, 0.8f));
+                    GameObject obj(pos, size, blockNormalSprite, glm::vec3(0.8f, 0.3f, 0.8f));
                     obj.Type = BOUNCE;
                     this->Blocks.push_back(obj);
                 }
@@ -113,7 +134,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x + 0.1f, unit_height * y + 0.1f);
                     glm::vec2 size(unit_width - 0.2f, unit_height - 0.2f);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_lrmove"), glm::vec3(1.0f));
+                    GameObject obj(pos, size, blockLrmoveSprite, glm::vec3(1.0f));
                     obj.Type = LRMOVE;
                     this->Blocks.push_back(obj);
                 }
@@ -121,7 +142,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x + 0.1f, unit_height * y + 0.1f);
                     glm::vec2 size(unit_width - 0.2f, unit_height - 0.2f);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_udmove"), glm::vec3(1.0f));
+                    GameObject obj(pos, size, blockUdmoveSprite, glm::vec3(1.0f));
                     obj.Type = UDMOVE;
                     this->Blocks.push_back(obj);
                 }
@@ -129,13 +150,13 @@ private:
                 {
                     glm::vec2 pos(unit_width * x + 14.0f, unit_height * y + 14.0f);
                     glm::vec2 size(radius * 2.0f, radius * 2.0f);
-                    Ball = new GameObject(pos, size, ResourceManager::GetTexture("ball"), glm::vec3(1.0f));
+                    Ball = GameObject(pos, size, ballSprite, glm::vec3(1.0f));
                 }
                 else if (tileData[y][x] == 9)	// GOAL
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_goal"), glm::vec3(1.0f));
+                    GameObject obj(pos, size, blockGoalSprite, glm::vec3(1.0f));
                     obj.Type = GOAL;
                     this->Blocks.push_back(obj);
                 }
@@ -143,7 +164,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_rightdir"), glm::vec3(1.0f, 1.0f, 0.3f));
+                    GameObject obj(pos, size, blockRightdirSprite, glm::vec3(1.0f, 1.0f, 0.3f));
                     obj.Type = RIGHTDIR;
                     this->Blocks.push_back(obj);
                 }
@@ -151,7 +172,7 @@ private:
                 {
                     glm::vec2 pos(unit_width * x, unit_height * y);
                     glm::vec2 size(unit_width, unit_height);
-                    GameObject obj(pos, size, ResourceManager::GetTexture("block_leftdir"), glm::vec3(1.0f, 1.0f, 0.3f));
+                    GameObject obj(pos, size, blockLeftdirSprite, glm::vec3(1.0f, 1.0f, 0.3f));
                     obj.Type = LEFTDIR;
                     this->Blocks.push_back(obj);
                 }
@@ -4,6 +4,8 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "texture.h"
+#include "resource_handle.h"
+#include "fixed.h"
 #include "sprite_renderer.h"
 
 enum BlockType{
@@ -35,16 +37,20 @@ public:
     bool        Destroyed;
     bool        isDirectional;
     int         Dir;
+    // the same position and size in 16.16 fixed point, the state of the fixed-point physics mode
+    FixedVec2   FixedPosition, FixedSize;
 
     // render state
-    Texture2D   Sprite;	
+    TextureHandle Sprite;	
     // constructor(s)
     GameObject()
             : Position(0.0f, 0.0f), Size(1.0f, 1.0f), Velocity(0.0f),
-            Color(1.0f), Rotation(0.0f), Sprite(), Type(NORMAL), Destroyed(false), isDirectional(false), Dir(1) { }
-    GameObject(glm::vec2 pos, glm::vec2 size, Texture2D sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
+            Color(1.0f), Rotation(0.0f), Sprite(), Type(NORMAL), Destroyed(false), isDirectional(false), Dir(1),
+            FixedPosition(Position), FixedSize(Size) { }
+    GameObject(glm::vec2 pos, glm::vec2 size, TextureHandle sprite, glm::vec3 color = glm::vec3(1.0f), glm::vec2 velocity = glm::vec2(0.0f, 0.0f))
             : Position(pos), Size(size), Velocity(velocity),
-            Color(color), Rotation(0.0f), Sprite(sprite), Type(NORMAL), Destroyed(false), isDirectional(false), Dir(1) { }
+            Color(color), Rotation(0.0f), Sprite(sprite), Type(NORMAL), Destroyed(false), isDirectional(false), Dir(1),
+            FixedPosition(pos), FixedSize(size) { }
     // draw sprite
     virtual void Draw(SpriteRenderer &renderer)
     {
@@ -0,0 +1,362 @@
+#ifndef GL_STATS_H
+#define GL_STATS_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+#include "profiler.h"
+
+
+// GLStats counts the GL calls the game makes, per frame and per profiled
+// scope (see PROFILE_SCOPE): draw calls, state binds, uniform updates and
+// location lookups, buffer and texture uploads, and GL objects created and
+// deleted. Install() swaps the GLAD function pointers of those calls for
+// counting wrappers, so nothing is counted (or paid) unless it was
+// installed. Live objects are tracked per type; CheckLeaks compares them
+// between two occurrences of the same event (a level reset) and reports the
+// types that grew, which must not happen when nothing new is loaded.
+// All GL calls are made on the main thread, so the counters are plain.
+class GLStats
+{
+public:
+    enum Counter {
+        DRAWS,
+        BINDS,           // textures, buffers, vertex arrays, programs, blend state
+        UNIFORMS,
+        UNIFORM_LOOKUPS, // glGetUniformLocation
+        BUFFER_UPLOADS,
+        TEXTURE_UPLOADS,
+        UPLOAD_BYTES,
+        CREATED,
+        DELETED,
+        COUNTER_COUNT
+    };
+    enum Object {
+        TEXTURES,
+        BUFFERS,
+        VERTEX_ARRAYS,
+        PROGRAMS,
+        SHADERS,
+        OBJECT_COUNT
+    };
+
+    static GLStats &Main()
+    {
+        static GLStats stats;
+        return stats;
+    }
+    static const char *CounterName(unsigned int counter)
+    {
+        static const char *const names[COUNTER_COUNT] = {
+            "draws", "binds", "uniforms", "lookups", "buffer uploads", "texture uploads", "upload bytes", "created", "deleted"
+        };
+        return counter < COUNTER_COUNT ? names[counter] : "";
+    }
+    static const char *ObjectName(unsigned int object)
+    {
+        static const char *const names[OBJECT_COUNT] = { "textures", "buffers", "vertex arrays", "programs", "shaders" };
+        return object < OBJECT_COUNT ? names[object] : "";
+    }
+
+    // wraps the GLAD pointers, call once after gladLoadGLLoader
+    void Install()
+    {
+        if (this->installed)
+            return;
+        this->installed = true;
+        hook(glad_glDrawArrays, real().DrawArrays, drawArrays);
+        hook(glad_glDrawElements, real().DrawElements, drawElements);
+        hook(glad_glBindTexture, real().BindTexture, bindTexture);
+        hook(glad_glBindBuffer, real().BindBuffer, bindBuffer);
+        hook(glad_glBindVertexArray, real().BindVertexArray, bindVertexArray);
+        hook(glad_glUseProgram, real().UseProgram, useProgram);
+        hook(glad_glActiveTexture, real().ActiveTexture, activeTexture);
+        hook(glad_glBlendFunc, real().BlendFunc, blendFunc);
+        hook(glad_glUniform1i, real().Uniform1i, uniform1i);
+        hook(glad_glUniform1f, real().Uniform1f, uniform1f);
+        hook(glad_glUniform2f, real().Uniform2f, uniform2f);
+        hook(glad_glUniform3f, real().Uniform3f, uniform3f);
+        hook(glad_glUniform4f, real().Uniform4f, uniform4f);
+        hook(glad_glUniform1fv, real().Uniform1fv, uniform1fv);
+        hook(glad_glUniform2fv, real().Uniform2fv, uniform2fv);
+        hook(glad_glUniform3fv, real().Uniform3fv, uniform3fv);
+        hook(glad_glUniform4fv, real().Uniform4fv, uniform4fv);
+        hook(glad_glUniformMatrix4fv, real().UniformMatrix4fv, uniformMatrix4fv);
+        hook(glad_glGetUniformLocation, real().GetUniformLocation, getUniformLocation);
+        hook(glad_glBufferData, real().BufferData, bufferData);
+        hook(glad_glBufferSubData, real().BufferSubData, bufferSubData);
+        hook(glad_glTexImage2D, real().TexImage2D, texImage2D);
+        hook(glad_glCompressedTexImage2D, real().CompressedTexImage2D, compressedTexImage2D);
+        hook(glad_glGenTextures, real().GenTextures, genTextures);
+        hook(glad_glDeleteTextures, real().DeleteTextures, deleteTextures);
+        hook(glad_glGenBuffers, real().GenBuffers, genBuffers);
+        hook(glad_glDeleteBuffers, real().DeleteBuffers, deleteBuffers);
+        hook(glad_glGenVertexArrays, real().GenVertexArrays, genVertexArrays);
+        hook(glad_glDeleteVertexArrays, real().DeleteVertexArrays, deleteVertexArrays);
+        hook(glad_glCreateProgram, real().CreateProgram, createProgram);
+        hook(glad_glDeleteProgram, real().DeleteProgram, deleteProgram);
+        hook(glad_glCreateShader, real().CreateShader, createShader);
+        hook(glad_glDeleteShader, real().DeleteShader, deleteShader);
+    }
+    bool Installed() const { return this->installed; }
+
+    // called by the main loop after each frame
+    void EndFrame()
+    {
+        if (!this->installed)
+            return;
+        std::memcpy(this->last, this->current, sizeof(this->current));
+        for (unsigned int scope = 0; scope < Profiler::MAX_SCOPES; ++scope)
+            for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter)
+                this->total[scope][counter] += this->current[scope][counter];
+        std::memset(this->current, 0, sizeof(this->current));
+        ++this->frames;
+    }
+    uint64_t Frames() const { return this->frames; }
+    // counts of the last finished frame, of one scope or of all
+    uint64_t Last(unsigned int scope, Counter counter) const { return this->last[scope][counter]; }
+    uint64_t Last(Counter counter) const
+    {
+        uint64_t sum = 0;
+        for (unsigned int scope = 0; scope < Profiler::MAX_SCOPES; ++scope)
+            sum += this->last[scope][counter];
+        return sum;
+    }
+    int64_t Live(Object object) const { return this->live[object]; }
+
+    // compares the live objects with the previous call for the same event, prints and returns the growth
+    int64_t CheckLeaks(const char *event)
+    {
+        if (!this->installed)
+            return 0;
+        Checkpoint *checkpoint = nullptr;
+        for (unsigned int i = 0; i < this->checkpointCount && !checkpoint; ++i)
+            if (std::strcmp(this->checkpoints[i].Event, event) == 0)
+                checkpoint = &this->checkpoints[i];
+        if (!checkpoint)
+        {
+            if (this->checkpointCount == MAX_CHECKPOINTS)
+                return 0;
+            checkpoint = &this->checkpoints[this->checkpointCount++];
+            checkpoint->Event = event;
+            std::memcpy(checkpoint->Live, this->live, sizeof(this->live));
+            return 0;
+        }
+        int64_t grown = 0;
+        for (unsigned int object = 0; object < OBJECT_COUNT; ++object)
+        {
+            int64_t growth = this->live[object] - checkpoint->Live[object];
+            if (growth > 0)
+            {
+                std::cout << "WARNING::GLSTATS: " << growth << " more " << ObjectName(object) << " alive than after the previous "
+                          << event << " (" << this->live[object] << " now), leaked?" << std::endl;
+                this->leaks[object] += growth;
+                grown += growth;
+            }
+        }
+        std::memcpy(checkpoint->Live, this->live, sizeof(this->live));
+        return grown;
+    }
+
+    // writes the per-frame averages of every scope, the last frame and the object counts
+    bool Write(const std::string &path) const
+    {
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        const Profiler &profiler = Profiler::Main();
+        std::fprintf(file, "GL calls per frame over %llu frames (average / last frame)\n\n%-20s",
+                     static_cast<unsigned long long>(this->frames), "scope");
+        for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter)
+            if (counter != CREATED && counter != DELETED)
+                std::fprintf(file, " %22s", CounterName(counter));
+        std::fprintf(file, "\n");
+        for (unsigned int scope = 0; scope < Profiler::MAX_SCOPES; ++scope)
+        {
+            bool used = false;
+            for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter)
+                used |= this->total[scope][counter] != 0;
+            if (!used)
+                continue;
+            std::fprintf(file, "%-20s", scope == 0 ? "(outside scopes)" : profiler.ScopeName(scope));
+            for (unsigned int counter = 0; counter < COUNTER_COUNT; ++counter)
+                if (counter != CREATED && counter != DELETED)
+                    std::fprintf(file, " %12.1f / %7llu", this->frames ? double(this->total[scope][counter]) / this->frames : 0.0,
+                                 static_cast<unsigned long long>(this->last[scope][counter]));
+            std::fprintf(file, "\n");
+        }
+        std::fprintf(file, "\n%-20s %10s %10s %10s %10s\n", "objects", "created", "deleted", "alive", "leaked");
+        for (unsigned int object = 0; object < OBJECT_COUNT; ++object)
+            std::fprintf(file, "%-20s %10llu %10llu %10lld %10lld\n", ObjectName(object),
+                         static_cast<unsigned long long>(this->created[object]), static_cast<unsigned long long>(this->deleted[object]),
+                         static_cast<long long>(this->live[object]), static_cast<long long>(this->leaks[object]));
+        return std::fclose(file) == 0;
+    }
+
+private:
+    static constexpr unsigned int MAX_CHECKPOINTS = 8;
+
+    struct RealFunctions {
+        PFNGLDRAWARRAYSPROC DrawArrays;
+        PFNGLDRAWELEMENTSPROC DrawElements;
+        PFNGLBINDTEXTUREPROC BindTexture;
+        PFNGLBINDBUFFERPROC BindBuffer;
+        PFNGLBINDVERTEXARRAYPROC BindVertexArray;
+        PFNGLUSEPROGRAMPROC UseProgram;
+        PFNGLACTIVETEXTUREPROC ActiveTexture;
+        PFNGLBLENDFUNCPROC BlendFunc;
+        PFNGLUNIFORM1IPROC Uniform1i;
+        PFNGLUNIFORM1FPROC Uniform1f;
+        PFNGLUNIFORM2FPROC Uniform2f;
+        PFNGLUNIFORM3FPROC Uniform3f;
+        PFNGLUNIFORM4FPROC Uniform4f;
+        PFNGLUNIFORM1FVPROC Uniform1fv;
+        PFNGLUNIFORM2FVPROC Uniform2fv;
+        PFNGLUNIFORM3FVPROC Uniform3fv;
+        PFNGLUNIFORM4FVPROC Uniform4fv;
+        PFNGLUNIFORMMATRIX4FVPROC UniformMatrix4fv;
+        PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+        PFNGLBUFFERDATAPROC BufferData;
+        PFNGLBUFFERSUBDATAPROC BufferSubData;
+        PFNGLTEXIMAGE2DPROC TexImage2D;
+        PFNGLCOMPRESSEDTEXIMAGE2DPROC CompressedTexImage2D;
+        PFNGLGENTEXTURESPROC GenTextures;
+        PFNGLDELETETEXTURESPROC DeleteTextures;
+        PFNGLGENBUFFERSPROC GenBuffers;
+        PFNGLDELETEBUFFERSPROC DeleteBuffers;
+        PFNGLGENVERTEXARRAYSPROC GenVertexArrays;
+        PFNGLDELETEVERTEXARRAYSPROC DeleteVertexArrays;
+        PFNGLCREATEPROGRAMPROC CreateProgram;
+        PFNGLDELETEPROGRAMPROC DeleteProgram;
+        PFNGLCREATESHADERPROC CreateShader;
+        PFNGLDELETESHADERPROC DeleteShader;
+    };
+    struct Checkpoint {
+        const char *Event;
+        int64_t Live[OBJECT_COUNT];
+    };
+
+    bool installed = false;
+    uint64_t frames = 0;
+    uint64_t current[Profiler::MAX_SCOPES][COUNTER_COUNT] = {};
+    uint64_t last[Profiler::MAX_SCOPES][COUNTER_COUNT] = {};
+    uint64_t total[Profiler::MAX_SCOPES][COUNTER_COUNT] = {};
+    uint64_t created[OBJECT_COUNT] = {}, deleted[OBJECT_COUNT] = {};
+    int64_t live[OBJECT_COUNT] = {}, leaks[OBJECT_COUNT] = {};
+    Checkpoint checkpoints[MAX_CHECKPOINTS];
+    unsigned int checkpointCount = 0;
+
+    GLStats() { }
+
+    static RealFunctions &real()
+    {
+        static RealFunctions functions;
+        return functions;
+    }
+    template <typename F>
+    static void hook(F &glad, F &original, F wrapper)
+    {
+        original = glad;
+        if (glad)
+            glad = wrapper;
+    }
+    static void count(Counter counter, uint64_t amount = 1)
+    {
+        unsigned int scope = Profiler::CurrentScope();
+        Main().current[scope < Profiler::MAX_SCOPES ? scope : 0][counter] += amount;
+    }
+    static void objects(Object object, GLsizei n, const GLuint *names, bool create)
+    {
+        GLStats &stats = Main();
+        GLsizei valid = 0;
+        for (GLsizei i = 0; i < n; ++i)
+            valid += names[i] != 0;
+        count(create ? CREATED : DELETED, valid);
+        (create ? stats.created : stats.deleted)[object] += valid;
+        stats.live[object] += create ? valid : -valid;
+    }
+    static unsigned int channels(GLenum format)
+    {
+        switch (format)
+        {
+        case GL_RED:  return 1;
+        case GL_RG:   return 2;
+        case GL_RGB:  return 3;
+        default:      return 4;
+        }
+    }
+
+    // counting wrappers, one per hooked entry point
+    static void APIENTRY drawArrays(GLenum mode, GLint first, GLsizei n) { count(DRAWS); real().DrawArrays(mode, first, n); }
+    static void APIENTRY drawElements(GLenum mode, GLsizei n, GLenum type, const void *indices) { count(DRAWS); real().DrawElements(mode, n, type, indices); }
+    static void APIENTRY bindTexture(GLenum target, GLuint texture) { count(BINDS); real().BindTexture(target, texture); }
+    static void APIENTRY bindBuffer(GLenum target, GLuint buffer) { count(BINDS); real().BindBuffer(target, buffer); }
+    static void APIENTRY bindVertexArray(GLuint array) { count(BINDS); real().BindVertexArray(array); }
+    static void APIENTRY useProgram(GLuint program) { count(BINDS); real().UseProgram(program); }
+    static void APIENTRY activeTexture(GLenum texture) { count(BINDS); real().ActiveTexture(texture); }
+    static void APIENTRY blendFunc(GLenum source, GLenum destination) { count(BINDS); real().BlendFunc(source, destination); }
+    static void APIENTRY uniform1i(GLint location, GLint x) { count(UNIFORMS); real().Uniform1i(location, x); }
+    static void APIENTRY uniform1f(GLint location, GLfloat x) { count(UNIFORMS); real().Uniform1f(location, x); }
+    static void APIENTRY uniform2f(GLint location, GLfloat x, GLfloat y) { count(UNIFORMS); real().Uniform2f(location, x, y); }
+    static void APIENTRY uniform3f(GLint location, GLfloat x, GLfloat y, GLfloat z) { count(UNIFORMS); real().Uniform3f(location, x, y, z); }
+    static void APIENTRY uniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w) { count(UNIFORMS); real().Uniform4f(location, x, y, z, w); }
+    static void APIENTRY uniform1fv(GLint location, GLsizei n, const GLfloat *v) { count(UNIFORMS); real().Uniform1fv(location, n, v); }
+    static void APIENTRY uniform2fv(GLint location, GLsizei n, const GLfloat *v) { count(UNIFORMS); real().Uniform2fv(location, n, v); }
+    static void APIENTRY uniform3fv(GLint location, GLsizei n, const GLfloat *v) { count(UNIFORMS); real().Uniform3fv(location, n, v); }
+    static void APIENTRY uniform4fv(GLint location, GLsizei n, const GLfloat *v) { count(UNIFORMS); real().Uniform4fv(location, n, v); }
+    static void APIENTRY uniformMatrix4fv(GLint location, GLsizei n, GLboolean transpose, const GLfloat *v) { count(UNIFORMS); real().UniformMatrix4fv(location, n, transpose, v); }
+    static GLint APIENTRY getUniformLocation(GLuint program, const GLchar *name) { count(UNIFORM_LOOKUPS); return real().GetUniformLocation(program, name); }
+    static void APIENTRY bufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+    {
+        count(BUFFER_UPLOADS);
+        count(UPLOAD_BYTES, data ? uint64_t(size) : 0);
+        real().BufferData(target, size, data, usage);
+    }
+    static void APIENTRY bufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+    {
+        count(BUFFER_UPLOADS);
+        count(UPLOAD_BYTES, uint64_t(size));
+        real().BufferSubData(target, offset, size, data);
+    }
+    static void APIENTRY texImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border,
+                                    GLenum format, GLenum type, const void *pixels)
+    {
+        count(TEXTURE_UPLOADS);
+        count(UPLOAD_BYTES, pixels ? uint64_t(width) * height * channels(format) : 0);
+        real().TexImage2D(target, level, internalFormat, width, height, border, format, type, pixels);
+    }
+    static void APIENTRY compressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border,
+                                              GLsizei size, const void *data)
+    {
+        count(TEXTURE_UPLOADS);
+        count(UPLOAD_BYTES, uint64_t(size));
+        real().CompressedTexImage2D(target, level, internalFormat, width, height, border, size, data);
+    }
+    static void APIENTRY genTextures(GLsizei n, GLuint *names) { real().GenTextures(n, names); objects(TEXTURES, n, names, true); }
+    static void APIENTRY deleteTextures(GLsizei n, const GLuint *names) { objects(TEXTURES, n, names, false); real().DeleteTextures(n, names); }
+    static void APIENTRY genBuffers(GLsizei n, GLuint *names) { real().GenBuffers(n, names); objects(BUFFERS, n, names, true); }
+    static void APIENTRY deleteBuffers(GLsizei n, const GLuint *names) { objects(BUFFERS, n, names, false); real().DeleteBuffers(n, names); }
+    static void APIENTRY genVertexArrays(GLsizei n, GLuint *names) { real().GenVertexArrays(n, names); objects(VERTEX_ARRAYS, n, names, true); }
+    static void APIENTRY deleteVertexArrays(GLsizei n, const GLuint *names) { objects(VERTEX_ARRAYS, n, names, false); real().DeleteVertexArrays(n, names); }
+    static GLuint APIENTRY createProgram()
+    {
+        GLuint program = real().CreateProgram();
+        objects(PROGRAMS, 1, &program, true);
+        return program;
+    }
+    static void APIENTRY deleteProgram(GLuint program) { objects(PROGRAMS, 1, &program, false); real().DeleteProgram(program); }
+    static GLuint APIENTRY createShader(GLenum type)
+    {
+        GLuint shader = real().CreateShader(type);
+        objects(SHADERS, 1, &shader, true);
+        return shader;
+    }
+    static void APIENTRY deleteShader(GLuint shader) { objects(SHADERS, 1, &shader, false); real().DeleteShader(shader); }
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef GL_STUB_H
+#define GL_STUB_H
+
+#include <glad/glad.h>
+
+
+// StubGL points the GLAD functions the game calls at no-op stubs, so the
+// renderers and the resource manager run without a window or GL context
+// (benchmarks, headless runs on CI machines). Object names count up from 1,
+// shaders always compile and no extensions are reported. Link glad.c for
+// the pointer table; gladLoadGLLoader is never called.
+template <typename F>
+struct GLStub;
+template <typename R, typename... Args>
+struct GLStub<R (APIENTRYP)(Args...)>
+{
+    static R APIENTRY Call(Args...) { return R(); }
+};
+
+namespace GLStubs
+{
+    inline GLuint &LastName()
+    {
+        static GLuint name = 0;
+        return name;
+    }
+    inline void APIENTRY genNames(GLsizei n, GLuint *names)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+            names[i] = ++LastName();
+    }
+    inline GLuint APIENTRY createName()
+    {
+        return ++LastName();
+    }
+    inline GLuint APIENTRY createShader(GLenum)
+    {
+        return ++LastName();
+    }
+    // compile and link status queries succeed, programs have no active uniforms
+    inline void APIENTRY getObjectiv(GLuint, GLenum name, GLint *params)
+    {
+        *params = name == GL_ACTIVE_UNIFORMS ? 0 : GL_TRUE;
+    }
+    inline void APIENTRY getIntegerv(GLenum, GLint *params)
+    {
+        *params = 0;
+    }
+}
+
+#define GL_STUB(name) glad_##name = GLStub<decltype(glad_##name)>::Call
+
+inline void StubGL()
+{
+    GL_STUB(glViewport);
+    GL_STUB(glEnable);
+    GL_STUB(glBlendFunc);
+    GL_STUB(glClearColor);
+    GL_STUB(glClear);
+    GL_STUB(glPixelStorei);
+    GL_STUB(glDrawArrays);
+    GL_STUB(glDrawElements);
+    GL_STUB(glActiveTexture);
+    GL_STUB(glBindTexture);
+    GL_STUB(glBindBuffer);
+    GL_STUB(glBindVertexArray);
+    GL_STUB(glTexParameteri);
+    GL_STUB(glTexImage2D);
+    GL_STUB(glCompressedTexImage2D);
+    GL_STUB(glBufferData);
+    GL_STUB(glBufferSubData);
+    GL_STUB(glVertexAttribPointer);
+    GL_STUB(glEnableVertexAttribArray);
+    GL_STUB(glDeleteTextures);
+    GL_STUB(glDeleteBuffers);
+    GL_STUB(glDeleteVertexArrays);
+    GL_STUB(glShaderSource);
+    GL_STUB(glCompileShader);
+    GL_STUB(glAttachShader);
+    GL_STUB(glLinkProgram);
+    GL_STUB(glUseProgram);
+    GL_STUB(glDeleteShader);
+    GL_STUB(glDeleteProgram);
+    GL_STUB(glGetShaderInfoLog);
+    GL_STUB(glGetProgramInfoLog);
+    GL_STUB(glGetActiveUniform);
+    GL_STUB(glGetUniformLocation);
+    GL_STUB(glGetUniformfv);
+    GL_STUB(glGetUniformiv);
+    GL_STUB(glGetStringi);
+    GL_STUB(glUniform1i);
+    GL_STUB(glUniform1f);
+    GL_STUB(glUniform2f);
+    GL_STUB(glUniform3f);
+    GL_STUB(glUniform4f);
+    GL_STUB(glUniform1fv);
+    GL_STUB(glUniform2fv);
+    GL_STUB(glUniform3fv);
+    GL_STUB(glUniform4fv);
+    GL_STUB(glUniformMatrix4fv);
+    glad_glGenTextures = GLStubs::genNames;
+    glad_glGenBuffers = GLStubs::genNames;
+    glad_glGenVertexArrays = GLStubs::genNames;
+    glad_glCreateProgram = GLStubs::createName;
+    glad_glCreateShader = GLStubs::createShader;
+    glad_glGetShaderiv = GLStubs::getObjectiv;
+    glad_glGetProgramiv = GLStubs::getObjectiv;
+    glad_glGetIntegerv = GLStubs::getIntegerv;
+}
+
+#undef GL_STUB
+
+#endif
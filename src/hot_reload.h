@@ -0,0 +1,124 @@
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <condition_variable>
+
+#include "file_watcher.h"
+#include "thread_pool.h"
+#include "resource_manager.h"
+
+
+// HotReload applies edits of watched asset folders while the game runs.
+// A changed shader file relinks only the programs built from it, a changed
+// image is decoded on the worker pool and re-uploaded into its texture slot
+// on a later frame. Files it does not own (levels) are handed back to the
+// caller. Update runs on the GL thread between frames.
+class HotReload
+{
+public:
+    HotReload() : running(0) { }
+    // waits for decodes still running on the pool
+    ~HotReload()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idle.wait(lock, [this]() { return this->running == 0; });
+    }
+    HotReload(const HotReload&) = delete;
+    HotReload &operator=(const HotReload&) = delete;
+
+    bool Watch(const std::string &folder)
+    {
+        return this->watcher.Watch(folder);
+    }
+    // uploads finished decodes and reloads what changed since the last call,
+    // changed files that are neither shaders nor textures are appended to other
+    void Update(std::vector<std::string> &other)
+    {
+        this->uploadDecoded();
+        std::vector<std::string> changed;
+        this->watcher.Poll(changed);
+        for (const std::string &file : changed)
+        {
+            std::vector<ShaderHandle> shaders = ResourceManager::ShadersUsing(file);
+            std::vector<TextureHandle> textures = ResourceManager::TexturesUsing(file);
+            if (shaders.empty() && textures.empty())
+            {
+                other.push_back(file);
+                continue;
+            }
+            ResourceManager::PreferLooseFile(file);
+            for (ShaderHandle shader : shaders)
+            {
+                auto start = std::chrono::steady_clock::now();
+                if (ResourceManager::ReloadShader(shader))
+                    std::cout << "Reloaded shader " << file << " in " << elapsedMs(start) << " ms" << std::endl;
+            }
+            for (TextureHandle texture : textures)
+                this->decode(texture, file);
+        }
+    }
+
+private:
+    struct Decode {
+        TextureHandle Texture;
+        std::string File;
+        TextureImage Image;
+        std::chrono::steady_clock::time_point Start;
+    };
+
+    FileWatcher watcher;
+    std::deque<std::shared_ptr<Decode>> decoded;
+    unsigned int running;
+    std::mutex mutex;
+    std::condition_variable idle;
+
+    static double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    void decode(TextureHandle texture, const std::string &file)
+    {
+        std::shared_ptr<Decode> job = std::make_shared<Decode>();
+        job->Texture = texture;
+        job->File = file;
+        job->Start = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ++this->running;
+        }
+        ThreadPool::Shared().Submit([this, job]() {
+            {
+                TRACE_SCOPE("texture reload decode");
+                job->Image = ResourceManager::DecodeTexture(job->File.c_str());
+            }
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->decoded.push_back(job);
+            --this->running;
+            this->idle.notify_all();
+        });
+    }
+    void uploadDecoded()
+    {
+        std::deque<std::shared_ptr<Decode>> ready;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            ready.swap(this->decoded);
+        }
+        for (const std::shared_ptr<Decode> &job : ready)
+        {
+            if (ResourceManager::ReloadTexture(job->Texture, job->Image))
+                std::cout << "Reloaded texture " << job->File << " in " << elapsedMs(job->Start) << " ms" << std::endl;
+            else
+                std::cout << "ERROR::TEXTURE: Reload of " << job->File << " failed, keeping the previous texture" << std::endl;
+        }
+    }
+};
+
+#endif
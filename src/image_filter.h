@@ -0,0 +1,151 @@
+#ifndef IMAGE_FILTER_H
+#define IMAGE_FILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGE_FILTER_SSE2
+#endif
+
+
+// CPU image operations used by the offline texture import: alpha
+// premultiplication, area resampling and 2x2 box reduction for mip chains.
+// Images are tightly packed 8-bit rows with 3 or 4 channels.
+struct Image {
+    int Width = 0, Height = 0, Channels = 0;
+    std::vector<unsigned char> Pixels;
+
+    Image() { }
+    Image(int width, int height, int channels)
+        : Width(width), Height(height), Channels(channels), Pixels(size_t(width) * height * channels) { }
+    unsigned char *At(int x, int y) { return &this->Pixels[(size_t(y) * this->Width + x) * this->Channels]; }
+    const unsigned char *At(int x, int y) const { return &this->Pixels[(size_t(y) * this->Width + x) * this->Channels]; }
+};
+
+// multiplies the color channels of an RGBA image by its alpha
+inline void PremultiplyAlpha(Image &image)
+{
+    if (image.Channels != 4)
+        return;
+    for (size_t i = 0; i < image.Pixels.size(); i += 4)
+    {
+        unsigned int a = image.Pixels[i + 3];
+        for (int c = 0; c < 3; ++c)
+            image.Pixels[i + c] = static_cast<unsigned char>((image.Pixels[i + c] * a + 127) / 255);
+    }
+}
+// inverse of PremultiplyAlpha (fully transparent pixels stay black)
+inline void UnpremultiplyAlpha(Image &image)
+{
+    if (image.Channels != 4)
+        return;
+    for (size_t i = 0; i < image.Pixels.size(); i += 4)
+    {
+        unsigned int a = image.Pixels[i + 3];
+        if (a == 0)
+            continue;
+        for (int c = 0; c < 3; ++c)
+            image.Pixels[i + c] = static_cast<unsigned char>(std::min(255u, (image.Pixels[i + c] * 255u + a / 2) / a));
+    }
+}
+
+// halves an image with a 2x2 box filter (odd edges are clamped), the standard next mip level
+inline Image BoxDownsample(const Image &src)
+{
+    int width = std::max(1, src.Width / 2), height = std::max(1, src.Height / 2);
+    int channels = src.Channels;
+    Image dst(width, height, channels);
+    for (int y = 0; y < height; ++y)
+    {
+        int y0 = std::min(2 * y, src.Height - 1), y1 = std::min(2 * y + 1, src.Height - 1);
+        const unsigned char *row0 = src.At(0, y0);
+        const unsigned char *row1 = src.At(0, y1);
+        unsigned char *out = dst.At(0, y);
+        int x = 0;
+#ifdef IMAGE_FILTER_SSE2
+        // 4 source pixels -> 2 destination pixels per step for RGBA
+        if (channels == 4)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(2);
+            for (; 2 * x + 3 < src.Width && x + 1 < width; x += 2)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+                // vertical sums in 16 bit: lo = pixels 0,1  hi = pixels 2,3
+                __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+                // horizontal pairs: pixel0 + pixel1, pixel2 + pixel3
+                __m128i sum0 = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                __m128i sum1 = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+                __m128i sum = _mm_unpacklo_epi64(sum0, sum1);
+                sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            int x0 = std::min(2 * x, src.Width - 1), x1 = std::min(2 * x + 1, src.Width - 1);
+            for (int c = 0; c < channels; ++c)
+            {
+                unsigned int total = row0[x0 * channels + c] + row0[x1 * channels + c] +
+                                     row1[x0 * channels + c] + row1[x1 * channels + c];
+                out[x * channels + c] = static_cast<unsigned char>((total + 2) / 4);
+            }
+        }
+    }
+    return dst;
+}
+
+// resamples to an arbitrary smaller size by averaging the exact source area under each destination pixel
+inline Image AreaResample(const Image &src, int width, int height)
+{
+    int channels = src.Channels;
+    Image dst(width, height, channels);
+    float scaleX = static_cast<float>(src.Width) / width, scaleY = static_cast<float>(src.Height) / height;
+    std::vector<float> sum(channels);
+    for (int y = 0; y < height; ++y)
+    {
+        float sy0 = y * scaleY, sy1 = (y + 1) * scaleY;
+        for (int x = 0; x < width; ++x)
+        {
+            float sx0 = x * scaleX, sx1 = (x + 1) * scaleX;
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            float weightTotal = 0.0f;
+            for (int sy = static_cast<int>(sy0); sy < std::min(src.Height, static_cast<int>(std::ceil(sy1))); ++sy)
+            {
+                float wy = std::min(sy1, sy + 1.0f) - std::max(sy0, static_cast<float>(sy));
+                for (int sx = static_cast<int>(sx0); sx < std::min(src.Width, static_cast<int>(std::ceil(sx1))); ++sx)
+                {
+                    float w = wy * (std::min(sx1, sx + 1.0f) - std::max(sx0, static_cast<float>(sx)));
+                    const unsigned char *p = src.At(sx, sy);
+                    for (int c = 0; c < channels; ++c)
+                        sum[c] += p[c] * w;
+                    weightTotal += w;
+                }
+            }
+            unsigned char *out = dst.At(x, y);
+            for (int c = 0; c < channels; ++c)
+                out[c] = static_cast<unsigned char>(std::min(255.0f, sum[c] / weightTotal + 0.5f));
+        }
+    }
+    return dst;
+}
+
+// shrinks an image to the given size: repeated 2x box steps while the image is
+// at least twice as large, then one exact area resample for the remainder
+inline Image ResizeDown(Image image, int width, int height)
+{
+    while (image.Width >= 2 * width && image.Height >= 2 * height)
+        image = BoxDownsample(image);
+    if (image.Width != width || image.Height != height)
+        image = AreaResample(image, width, height);
+    return image;
+}
+
+#endif
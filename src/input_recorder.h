@@ -0,0 +1,317 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <condition_variable>
+
+#include <GLFW/glfw3.h>
+
+#include "tracer.h"
+
+
+// Input recordings hold the keys the game reads (INPUT_KEYS) once per tick,
+// one tick being one call of Game::ProcessInput. Only changes are stored:
+//
+//   "BBIN", version byte, then one varint (LEB128) per change of the keys:
+//   (ticks since the previous change << 7) | keys held from that tick on
+//
+// keys being a bit per entry of INPUT_KEYS, all released before the first
+// change. A record that repeats the keys held ends the recording at its
+// tick; a file without one (the game did not exit cleanly) plays up to its
+// last change. Holding a key for a second or two costs two bytes, so an
+// hour of play is a few kilobytes.
+// (version 2 added BACKSPACE, which rewinds)
+const int INPUT_KEYS[] = { GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_LEFT, GLFW_KEY_RIGHT, GLFW_KEY_R, GLFW_KEY_SPACE, GLFW_KEY_BACKSPACE };
+const unsigned int INPUT_KEY_COUNT = sizeof(INPUT_KEYS) / sizeof(INPUT_KEYS[0]);
+const unsigned char INPUT_FILE_VERSION = 2;
+
+// the recorded keys of a Keys[1024] array as a bit mask
+inline unsigned char PackInputKeys(const bool *keys)
+{
+    unsigned char mask = 0;
+    for (unsigned int i = 0; i < INPUT_KEY_COUNT; ++i)
+        if (keys[INPUT_KEYS[i]])
+            mask |= 1 << i;
+    return mask;
+}
+inline bool IsInputKey(int key)
+{
+    return std::find(std::begin(INPUT_KEYS), std::end(INPUT_KEYS), key) != std::end(INPUT_KEYS);
+}
+// writes value as LEB128 (7 bits per byte, low first), returns the byte count (at most 10)
+inline size_t EncodeVarint(uint64_t value, unsigned char *out)
+{
+    size_t size = 0;
+    while (value >= 0x80)
+    {
+        out[size++] = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<unsigned char>(value);
+    return size;
+}
+// reads a varint at offset and moves offset past it, false if it is cut off or longer than 64 bits
+inline bool DecodeVarint(const unsigned char *data, size_t size, size_t &offset, uint64_t &value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && offset < size; shift += 7)
+    {
+        unsigned char byte = data[offset++];
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// InputRecorder streams a recording to disk. Record only compares the keys
+// with the previous tick and, when they changed, appends a few bytes to a
+// buffer; a writer thread takes the buffer when it fills up or once a second
+// and writes it out, so the game thread never touches the file.
+class InputRecorder
+{
+public:
+    static constexpr size_t FLUSH_BYTES = 4096;
+
+    InputRecorder() { }
+    ~InputRecorder() { this->Close(); }
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder &operator=(const InputRecorder&) = delete;
+
+    bool Open(const std::string &path)
+    {
+        this->Close();
+        this->file = std::fopen(path.c_str(), "wb");
+        if (!this->file)
+            return false;
+        const unsigned char header[5] = { 'B', 'B', 'I', 'N', INPUT_FILE_VERSION };
+        std::fwrite(header, 1, sizeof(header), this->file);
+        this->ticks = this->lastChange = 0;
+        this->keys = 0;
+        this->bytes = sizeof(header);
+        // both buffers keep their capacity across swaps, recording does not allocate
+        this->pending.reserve(FLUSH_BYTES * 4);
+        this->writing.reserve(FLUSH_BYTES * 4);
+        this->running = true;
+        this->thread = std::thread([this]() {
+            Tracer::NameThread("input writer");
+            this->run();
+        });
+        return true;
+    }
+    // once per tick with the keys the game is about to read
+    void Record(const bool *keys)
+    {
+        unsigned char mask = PackInputKeys(keys);
+        if (mask != this->keys)
+            this->append(mask);
+        ++this->ticks;
+    }
+    // ends the recording and writes what is left
+    void Close()
+    {
+        if (!this->file)
+            return;
+        this->append(this->keys); // end marker
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->running = false;
+        }
+        this->wake.notify_all();
+        if (this->thread.joinable())
+            this->thread.join();
+        std::fclose(this->file);
+        this->file = nullptr;
+    }
+
+    bool IsOpen() const { return this->file != nullptr; }
+    uint64_t Ticks() const { return this->ticks; }
+    // size of the recording so far, including what the writer has not written yet
+    uint64_t Bytes() const { return this->bytes; }
+
+private:
+    std::FILE *file = nullptr;
+    uint64_t ticks = 0, lastChange = 0, bytes = 0; // game thread only
+    unsigned char keys = 0;
+    std::vector<unsigned char> pending; // filled by the game thread, guarded by mutex
+    std::vector<unsigned char> writing; // writer thread only
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+    std::thread thread;
+
+    void append(unsigned char mask)
+    {
+        unsigned char record[10];
+        size_t size = EncodeVarint(((this->ticks - this->lastChange) << INPUT_KEY_COUNT) | mask, record);
+        bool flush;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending.insert(this->pending.end(), record, record + size);
+            flush = this->pending.size() >= FLUSH_BYTES;
+        }
+        if (flush)
+            this->wake.notify_one();
+        this->lastChange = this->ticks;
+        this->keys = mask;
+        this->bytes += size;
+    }
+    void run()
+    {
+        for (;;)
+        {
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                // flushing once a second keeps a crash from losing more than that
+                this->wake.wait_for(lock, std::chrono::seconds(1));
+                std::swap(this->pending, this->writing);
+                stop = !this->running;
+            }
+            if (!this->writing.empty())
+            {
+                TRACE_SCOPE("input write");
+                std::fwrite(this->writing.data(), 1, this->writing.size(), this->file);
+                std::fflush(this->file);
+                this->writing.clear();
+            }
+            if (stop)
+                break;
+        }
+    }
+};
+
+// InputPlayback plays a recording back into the Keys/KeysProcessed arrays
+// of the game, one tick per Next. The file is small enough to read whole;
+// Open also notes the decoder state every INDEX_EVERY changes so Seek only
+// decodes forward from the nearest one.
+class InputPlayback
+{
+public:
+    static constexpr size_t INDEX_EVERY = 256;
+
+    bool Open(const std::string &path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+            return false;
+        this->data.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+        this->index.clear();
+        if (this->data.size() < 5 || std::string(this->data.begin(), this->data.begin() + 4) != "BBIN" || this->data[4] != INPUT_FILE_VERSION)
+        {
+            std::cout << "ERROR::INPUT: " << path << " is not an input recording" << std::endl;
+            this->data.clear();
+            return false;
+        }
+        // walk the changes once: seek points and the length
+        Cursor cursor;
+        cursor.Offset = 5;
+        this->length = 0;
+        bool ended = false;
+        for (size_t count = 0; !ended; ++count)
+        {
+            if (count % INDEX_EVERY == 0)
+                this->index.push_back(cursor);
+            uint64_t tick;
+            unsigned char mask;
+            size_t next = cursor.Offset;
+            if (!this->peek(cursor, next, tick, mask))
+                break;
+            ended = mask == cursor.Keys;
+            this->length = ended ? tick : tick + 1;
+            cursor.Offset = next;
+            cursor.Tick = tick;
+            cursor.Keys = mask;
+        }
+        if (!ended)
+            std::cout << "WARNING::INPUT: " << path << " has no end (recording was cut off), playing " << this->length << " ticks" << std::endl;
+        this->Seek(0);
+        return true;
+    }
+
+    uint64_t Length() const { return this->length; }
+    uint64_t Tick() const { return this->tick; }
+    bool Finished() const { return this->tick >= this->length; }
+
+    // continues from tick (clamped to the length)
+    void Seek(uint64_t tick)
+    {
+        this->tick = std::min(tick, this->length);
+        if (this->index.empty())
+            return;
+        // the last seek point at or before tick, then decode forward
+        auto point = std::upper_bound(this->index.begin(), this->index.end(), this->tick,
+                                      [](uint64_t target, const Cursor &cursor) { return target < cursor.Tick; });
+        this->cursor = point == this->index.begin() ? this->index.front() : *(point - 1);
+        this->advance();
+    }
+    // the recorded keys of the current tick
+    unsigned char Keys() const { return this->cursor.Keys; }
+    // sets the recorded keys of the current tick in keys (Game::Keys) and moves to the next tick,
+    // false once the recording is over; released keys clear keysProcessed like key_callback does
+    bool Next(bool *keys, bool *keysProcessed)
+    {
+        if (this->Finished())
+            return false;
+        this->advance();
+        for (unsigned int i = 0; i < INPUT_KEY_COUNT; ++i)
+        {
+            bool down = (this->cursor.Keys >> i) & 1;
+            if (!down && keys[INPUT_KEYS[i]])
+                keysProcessed[INPUT_KEYS[i]] = false;
+            keys[INPUT_KEYS[i]] = down;
+        }
+        ++this->tick;
+        return true;
+    }
+
+private:
+    // decoder state: next record at Offset, Keys held since the change at Tick
+    struct Cursor {
+        size_t Offset = 0;
+        uint64_t Tick = 0;
+        unsigned char Keys = 0;
+    };
+    std::vector<unsigned char> data;
+    std::vector<Cursor> index;
+    Cursor cursor;
+    uint64_t length = 0, tick = 0;
+
+    // decodes the record at offset, false at the end of the data
+    bool peek(const Cursor &from, size_t &offset, uint64_t &tick, unsigned char &mask) const
+    {
+        uint64_t value;
+        if (!DecodeVarint(this->data.data(), this->data.size(), offset, value))
+            return false;
+        tick = from.Tick + (value >> INPUT_KEY_COUNT);
+        mask = static_cast<unsigned char>(value & ((1 << INPUT_KEY_COUNT) - 1));
+        return true;
+    }
+    // applies the changes up to the current tick
+    void advance()
+    {
+        for (;;)
+        {
+            uint64_t tick;
+            unsigned char mask;
+            size_t next = this->cursor.Offset;
+            if (!this->peek(this->cursor, next, tick, mask) || tick > this->tick || mask == this->cursor.Keys)
+                return;
+            this->cursor.Offset = next;
+            this->cursor.Tick = tick;
+            this->cursor.Keys = mask;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef JOB_GRAPH_H
+#define JOB_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+#include "thread_pool.h"
+#include "startup_report.h"
+
+
+// JobGraph runs a set of loading jobs in dependency order. Each job has an
+// optional Work step, executed on the worker pool, and an optional Finish
+// step, executed on the main thread by Pump (GL uploads, anything touching
+// the renderer). A job's dependents start once its Finish step has run.
+// Pump is called once per frame with a time budget so a loading screen keeps
+// rendering while the graph drains.
+class JobGraph
+{
+public:
+    typedef unsigned int Job;
+
+    JobGraph() : done(0), running(0), started(false) { }
+    // waits for work steps still running on the pool, they may reference the graph's owner
+    ~JobGraph()
+    {
+        this->Wait();
+    }
+    JobGraph(const JobGraph&) = delete;
+    JobGraph &operator=(const JobGraph&) = delete;
+
+    // adds a job running after all dependencies finished, work and/or finish may be empty
+    Job Add(const std::string &name, std::function<void()> work, std::function<void()> finish, const std::vector<Job> &dependencies = {})
+    {
+        Job job = static_cast<Job>(this->nodes.size());
+        this->nodes.emplace_back();
+        Node &node = this->nodes.back();
+        node.Name = name;
+        node.Work = std::move(work);
+        node.Finish = std::move(finish);
+        node.Waiting = static_cast<unsigned int>(dependencies.size());
+        for (Job dependency : dependencies)
+            this->nodes[dependency].Dependents.push_back(job);
+        return job;
+    }
+    // schedules every job without dependencies
+    void Start()
+    {
+        this->started = true;
+        for (Job job = 0; job < this->nodes.size(); ++job)
+            if (this->nodes[job].Waiting == 0)
+                this->schedule(job);
+    }
+    // runs finished jobs' main-thread steps until budgetMs is spent (at least one step
+    // when one is ready), returns true once every job has finished
+    bool Pump(double budgetMs)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            Job job;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                if (this->finished.empty())
+                    break;
+                job = this->finished.front();
+                this->finished.pop_front();
+            }
+            Node &node = this->nodes[job];
+            if (node.Finish)
+            {
+                TRACE_SCOPE(node.Name.c_str());
+                STARTUP_PHASE("finish", &node.Name);
+                node.Finish();
+            }
+            node.Work = nullptr;
+            node.Finish = nullptr;
+            ++this->done;
+            for (Job dependent : node.Dependents)
+                if (--this->nodes[dependent].Waiting == 0)
+                    this->schedule(dependent);
+            if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs)
+                break;
+        }
+        return this->Done();
+    }
+    bool Done() const { return this->started && this->done == this->nodes.size(); }
+    // fraction of finished jobs in [0, 1]
+    float Progress() const { return this->nodes.empty() ? 1.0f : static_cast<float>(this->done) / this->nodes.size(); }
+    // blocks until no work step is running on the pool
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->idle.wait(lock, [this]() { return this->running == 0; });
+    }
+
+private:
+    struct Node {
+        std::string Name;
+        std::function<void()> Work;
+        std::function<void()> Finish;
+        std::vector<Job> Dependents;
+        unsigned int Waiting = 0; // unfinished dependencies
+    };
+
+    // nodes never move once added and are only modified on the main thread
+    std::deque<Node> nodes;
+    size_t done;
+    // jobs whose work step is done and whose finish step is due (shared with workers)
+    std::deque<Job> finished;
+    unsigned int running;
+    std::mutex mutex;
+    std::condition_variable idle;
+    bool started;
+
+    void schedule(Job job)
+    {
+        Node &node = this->nodes[job];
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (!node.Work)
+        {
+            this->finished.push_back(job);
+            return;
+        }
+        ++this->running;
+        ThreadPool::Shared().Submit([this, job]() {
+            {
+                TRACE_SCOPE(this->nodes[job].Name.c_str());
+                STARTUP_PHASE("work", &this->nodes[job].Name);
+                this->nodes[job].Work();
+            }
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->finished.push_back(job);
+            --this->running;
+            this->idle.notify_all();
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef LEVEL_GENERATOR_H
+#define LEVEL_GENERATOR_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// LevelRecipe describes a synthetic level: how many blocks, how densely
+// they fill the grid, which share moves and how the rest is split between
+// the block types. GenerateLevel turns it into the text of a level file
+// (rows of tile codes, see game_level.h), so the result loads through
+// GameLevel::Parse like the shipped levels and can be written to disk and
+// played. The same recipe and seed always give the same level.
+struct LevelRecipe {
+    unsigned int Blocks = 300;
+    float Density = 0.3f;  // blocks per grid cell, the grid keeps the 4:3 screen shape
+    float Moving = 0.02f;  // share of moving blocks (5, 6 evenly)
+    // relative weights of the other blocks by tile code
+    struct Weight {
+        unsigned int Tile;
+        float Share;
+    };
+    std::vector<Weight> Mix = { { 1, 60.0f }, { 2, 15.0f }, { 3, 10.0f }, { 4, 10.0f }, { 10, 2.5f }, { 11, 2.5f } };
+    uint32_t Seed = 1;
+};
+
+// grid size the recipe ends up with
+inline void LevelGridSize(const LevelRecipe &recipe, unsigned int &width, unsigned int &height)
+{
+    double cells = std::ceil(recipe.Blocks / std::max(0.0001, double(recipe.Density)));
+    width = std::max(4u, unsigned(std::lround(std::sqrt(cells * 4.0 / 3.0))));
+    height = std::max(4u, unsigned(std::ceil(cells / width)));
+    // the start and goal corners are kept free, make room for them
+    while (double(width) * height < recipe.Blocks + 10.0)
+        ++height;
+}
+
+// the start is at the top left with free space around it, the goal at the bottom right
+inline std::string GenerateLevel(const LevelRecipe &recipe)
+{
+    unsigned int width, height;
+    LevelGridSize(recipe, width, height);
+    uint32_t state = recipe.Seed;
+    auto random01 = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.0 / 16777216.0);
+    };
+    float total = 0.0f;
+    for (const LevelRecipe::Weight &weight : recipe.Mix)
+        total += weight.Share;
+
+    std::string text;
+    text.reserve(size_t(width) * height * 3);
+    // selection sampling: every free cell takes a block with the chance that
+    // leaves exactly Blocks placed at the end
+    uint64_t needed = recipe.Blocks, free = uint64_t(width) * height - 10;
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            unsigned int tile = 0;
+            if (x == 1 && y == 1)
+                tile = 8;
+            else if (x == width - 1 && y == height - 1)
+                tile = 9;
+            else if (x <= 2 && y <= 2)
+                tile = 0; // room for the ball to spawn
+            else
+            {
+                if (free > 0 && random01() * free < needed)
+                {
+                    --needed;
+                    if (random01() < recipe.Moving)
+                        tile = random01() < 0.5 ? 5 : 6;
+                    else
+                    {
+                        double pick = random01() * total;
+                        tile = recipe.Mix.empty() ? 1 : recipe.Mix.back().Tile;
+                        for (const LevelRecipe::Weight &weight : recipe.Mix)
+                        {
+                            if (pick < weight.Share)
+                            {
+                                tile = weight.Tile;
+                                break;
+                            }
+                            pick -= weight.Share;
+                        }
+                    }
+                }
+                if (free > 0)
+                    --free;
+            }
+            if (x > 0)
+                text += ' ';
+            text += std::to_string(tile);
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef LEVEL_STREAMER_H
+#define LEVEL_STREAMER_H
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <iostream>
+#include <condition_variable>
+
+#include "game_level.h"
+#include "thread_pool.h"
+#include "startup_report.h"
+
+
+// LevelStreamer loads levels on demand instead of parsing every level file
+// at startup. It keeps the untouched copy of the level being played (so a
+// reset is a copy instead of a disk read) and parses the level expected next
+// on the worker pool, so reaching a goal only swaps in an already built level.
+class LevelStreamer
+{
+public:
+    LevelStreamer() : count(0), width(0), height(0), currentIndex(0), hasCurrent(false) { }
+    // waits for an in-flight prefetch, the job refers to the level files of this streamer
+    ~LevelStreamer()
+    {
+        this->waitPrefetch();
+    }
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer &operator=(const LevelStreamer&) = delete;
+
+    // levels are <folder>/1.txt .. <folder>/<count>.txt, laid out in a levelWidth x levelHeight area
+    void Open(const std::string &folder, unsigned int count, unsigned int levelWidth, unsigned int levelHeight)
+    {
+        this->waitPrefetch();
+        this->folder = folder;
+        this->count = count;
+        this->width = levelWidth;
+        this->height = levelHeight;
+        this->hasCurrent = false;
+        this->prefetched.reset();
+    }
+    unsigned int Count() const { return this->count; }
+
+    // returns the untouched state of level index: the prefetched level if it was
+    // requested (waiting for it if still being parsed), otherwise it is loaded here
+    const GameLevel &Get(unsigned int index)
+    {
+        if (this->hasCurrent && this->currentIndex == index)
+            return this->current;
+        if (this->prefetched && this->prefetched->Index == index)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::shared_ptr<PrefetchJob> job = this->waitPrefetch();
+            double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (waited > 1.0)
+                std::cout << "WARNING::LEVEL: Waited " << waited << " ms for level " << index + 1 << " to finish loading" << std::endl;
+            this->current = std::move(job->Level);
+        }
+        else
+            this->current = this->load(index);
+        this->currentIndex = index;
+        this->hasCurrent = true;
+        return this->current;
+    }
+    // forgets the loaded or prefetched state of level index (its file changed), the next Get reads it again
+    void Invalidate(unsigned int index)
+    {
+        if (this->hasCurrent && this->currentIndex == index)
+            this->hasCurrent = false;
+        if (this->prefetched && this->prefetched->Index == index)
+        {
+            this->waitPrefetch();
+            this->Prefetch(index);
+        }
+    }
+    // starts parsing level index on the worker pool (replacing an earlier request)
+    void Prefetch(unsigned int index)
+    {
+        if (index >= this->count || (this->prefetched && this->prefetched->Index == index))
+            return;
+        this->waitPrefetch();
+        std::shared_ptr<PrefetchJob> job = std::make_shared<PrefetchJob>();
+        job->Index = index;
+        this->prefetched = job;
+        std::string path = this->pathOf(index);
+        unsigned int levelWidth = this->width, levelHeight = this->height;
+        ThreadPool::Shared().Submit([job, path, levelWidth, levelHeight]() {
+            GameLevel level;
+            {
+                TRACE_SCOPE("level prefetch");
+                STARTUP_PHASE("level prefetch", &path);
+                level.Load(path.c_str(), levelWidth, levelHeight);
+            }
+            std::lock_guard<std::mutex> lock(job->Mutex);
+            job->Level = std::move(level);
+            job->Ready = true;
+            job->Done.notify_all();
+        });
+    }
+
+private:
+    // a level being parsed on a worker
+    struct PrefetchJob {
+        unsigned int Index = 0;
+        GameLevel Level;
+        bool Ready = false;
+        std::mutex Mutex;
+        std::condition_variable Done;
+    };
+
+    std::string folder;
+    unsigned int count, width, height;
+    GameLevel current;
+    unsigned int currentIndex;
+    bool hasCurrent;
+    std::shared_ptr<PrefetchJob> prefetched;
+
+    std::string pathOf(unsigned int index) const
+    {
+        return this->folder + "/" + std::to_string(index + 1) + ".txt";
+    }
+    GameLevel load(unsigned int index) const
+    {
+        GameLevel level;
+        std::string path = this->pathOf(index);
+        STARTUP_PHASE("level", &path);
+        level.Load(path.c_str(), this->width, this->height);
+        return level;
+    }
+    // blocks until the pending prefetch (if any) is finished and hands it over
+    std::shared_ptr<PrefetchJob> waitPrefetch()
+    {
+        std::shared_ptr<PrefetchJob> job = std::move(this->prefetched);
+        if (job)
+        {
+            std::unique_lock<std::mutex> lock(job->Mutex);
+            job->Done.wait(lock, [&job]() { return job->Ready; });
+        }
+        return job;
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+// A small byte-oriented LZ77 codec used for optional per-entry compression
+// in the asset pack. The stream is a list of sequences:
+//   token   : high nibble = literal count, low nibble = match length - 4
+//   [ext]   : extra 255-terminated length bytes when a nibble is 15
+//   literals
+//   offset  : 2 bytes little endian (only if more input follows)
+// It favours decode speed over ratio, which is what matters at load time.
+const unsigned int LZ_MIN_MATCH = 4;
+const unsigned int LZ_MAX_OFFSET = 65535;
+const unsigned int LZ_HASH_BITS = 14;
+
+// compresses src into dst (dst is overwritten)
+inline void LZCompress(const unsigned char *src, size_t size, std::vector<unsigned char> &dst)
+{
+    dst.clear();
+    dst.reserve(size + size / 255 + 16);
+    std::vector<int64_t> table(size_t(1) << LZ_HASH_BITS, -1);
+    auto readU32 = [&](size_t p) { uint32_t v; std::memcpy(&v, src + p, 4); return v; };
+    auto hash = [&](size_t p) { return (readU32(p) * 2654435761u) >> (32 - LZ_HASH_BITS); };
+    auto writeLength = [&](size_t length) {
+        while (length >= 255)
+        {
+            dst.push_back(255);
+            length -= 255;
+        }
+        dst.push_back(static_cast<unsigned char>(length));
+    };
+    auto emit = [&](size_t literalStart, size_t literalCount, size_t matchLength, size_t offset) {
+        size_t lit = literalCount < 15 ? literalCount : 15;
+        size_t mat = 0;
+        if (matchLength)
+            mat = (matchLength - LZ_MIN_MATCH) < 15 ? (matchLength - LZ_MIN_MATCH) : 15;
+        dst.push_back(static_cast<unsigned char>((lit << 4) | mat));
+        if (lit == 15)
+            writeLength(literalCount - 15);
+        dst.insert(dst.end(), src + literalStart, src + literalStart + literalCount);
+        if (matchLength)
+        {
+            dst.push_back(static_cast<unsigned char>(offset & 0xFF));
+            dst.push_back(static_cast<unsigned char>(offset >> 8));
+            if (mat == 15)
+                writeLength(matchLength - LZ_MIN_MATCH - 15);
+        }
+    };
+
+    size_t anchor = 0, pos = 0;
+    while (size >= LZ_MIN_MATCH && pos + LZ_MIN_MATCH <= size)
+    {
+        uint32_t h = hash(pos);
+        int64_t candidate = table[h];
+        table[h] = static_cast<int64_t>(pos);
+        if (candidate >= 0 && pos - candidate <= LZ_MAX_OFFSET && readU32(candidate) == readU32(pos))
+        {
+            size_t length = LZ_MIN_MATCH;
+            while (pos + length < size && src[candidate + length] == src[pos + length])
+                ++length;
+            emit(anchor, pos - anchor, length, pos - candidate);
+            pos += length;
+            anchor = pos;
+        }
+        else
+            ++pos;
+    }
+    // trailing literals (a sequence without a match ends the stream)
+    emit(anchor, size - anchor, 0, 0);
+}
+
+// decompresses src into dst which must hold exactly rawSize bytes, returns false on corrupt input
+inline bool LZDecompress(const unsigned char *src, size_t size, unsigned char *dst, size_t rawSize)
+{
+    size_t ip = 0, op = 0;
+    auto readLength = [&](size_t &length) {
+        unsigned char b;
+        do
+        {
+            if (ip >= size)
+                return false;
+            b = src[ip++];
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+    while (ip < size)
+    {
+        unsigned char token = src[ip++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals))
+            return false;
+        if (ip + literals > size || op + literals > rawSize)
+            return false;
+        std::memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        // the last sequence carries no match
+        if (ip == size)
+            break;
+        if (ip + 2 > size)
+            return false;
+        size_t offset = src[ip] | (src[ip + 1] << 8);
+        ip += 2;
+        size_t length = token & 0x0F;
+        if (length == 15 && !readLength(length))
+            return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || op + length > rawSize)
+            return false;
+        // byte-wise copy so overlapping matches (offset < length) repeat correctly
+        const unsigned char *match = dst + op - offset;
+        for (size_t i = 0; i < length; ++i)
+            dst[op + i] = match[i];
+        op += length;
+    }
+    return op == rawSize;
+}
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// MappedFile maps a whole file read-only into memory. The mapping stays
+// valid until Close() is called or the object is destroyed, so pointers
+// handed out by Data() can be passed around without copying the bytes.
+class MappedFile
+{
+public:
+    MappedFile() { }
+    ~MappedFile()
+    {
+        this->Close();
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other) noexcept
+    {
+        this->moveFrom(other);
+    }
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            this->Close();
+            this->moveFrom(other);
+        }
+        return *this;
+    }
+
+    // maps the given file, returns false if it could not be opened
+    bool Open(const char *path)
+    {
+        this->Close();
+#ifdef _WIN32
+        this->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (this->file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            this->Close();
+            return false;
+        }
+        this->size = static_cast<size_t>(fileSize.QuadPart);
+        this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (this->mapping == NULL)
+        {
+            this->Close();
+            return false;
+        }
+        this->data = static_cast<const unsigned char*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+        if (this->data == nullptr)
+        {
+            this->Close();
+            return false;
+        }
+#else
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return false;
+        }
+        this->size = static_cast<size_t>(st.st_size);
+        void *ptr = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file
+        close(fd);
+        if (ptr == MAP_FAILED)
+        {
+            this->size = 0;
+            return false;
+        }
+        this->data = static_cast<const unsigned char*>(ptr);
+#endif
+        return true;
+    }
+    // unmaps the file
+    void Close()
+    {
+#ifdef _WIN32
+        if (this->data)
+            UnmapViewOfFile(this->data);
+        if (this->mapping != NULL)
+            CloseHandle(this->mapping);
+        if (this->file != INVALID_HANDLE_VALUE)
+            CloseHandle(this->file);
+        this->mapping = NULL;
+        this->file = INVALID_HANDLE_VALUE;
+#else
+        if (this->data)
+            munmap(const_cast<unsigned char*>(this->data), this->size);
+#endif
+        this->data = nullptr;
+        this->size = 0;
+    }
+
+    // asks the OS to drop the file's pages from its file cache so the next read
+    // comes from disk (best effort: no-op where the OS offers no way to do it)
+    static void DropFromCache(const char *path)
+    {
+#ifdef _WIN32
+        // an unbuffered handle makes the cache manager flush and purge the file's cached data
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        int file = open(path, O_RDONLY);
+        if (file < 0)
+            return;
+#ifdef POSIX_FADV_DONTNEED
+        posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+        close(file);
+#endif
+    }
+
+    bool IsOpen() const { return this->data != nullptr; }
+    const unsigned char *Data() const { return this->data; }
+    size_t Size() const { return this->size; }
+
+private:
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+    void moveFrom(MappedFile &other)
+    {
+        this->data = other.data;
+        this->size = other.size;
+        other.data = nullptr;
+        other.size = 0;
+#ifdef _WIN32
+        this->file = other.file;
+        this->mapping = other.mapping;
+        other.file = INVALID_HANDLE_VALUE;
+        other.mapping = NULL;
+#endif
+    }
+};
+
+#endif
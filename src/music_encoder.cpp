@@ -0,0 +1,116 @@
+// music_encoder - converts music tracks into the streamed format the game plays.
+//
+//   music_encoder [--force] [track ...]
+//
+// Decodes each track (default: every file in resources/audio that is at
+// least 20 seconds long) and writes it as an IMA ADPCM WAV to
+// resources/audio/streamed/<name>.wav, which the game decodes block by block
+// on its music thread instead of holding the whole track in memory.
+// The game writes a missing one itself the first time it plays the track;
+// this does it ahead of time, for the asset pack and for every track at once.
+// Tracks whose output is newer than the source are skipped unless --force
+// is given. Prints the size and the signal-to-noise ratio of every result.
+// Run from the repository root, before asset_packer.
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_pack.h"
+#include "audio_mixer.h"
+#include "audio_irrklang.h"
+#include "music_stream.h"
+
+namespace fs = std::filesystem;
+
+static const double MIN_MUSIC_SECONDS = 20.0;
+
+static bool decode(const std::string &file, AudioBuffer &buffer)
+{
+    AssetData bytes = AssetData::FromFile(file.c_str());
+    if (!bytes.IsValid())
+        return false;
+    return DecodeWav(bytes.Data, bytes.Size, AudioMixer::SAMPLE_RATE, buffer) ||
+           DecodeWithIrrKlang(bytes.Data, bytes.Size, file.c_str(), buffer);
+}
+
+// decodes the written file back and compares it with the source
+static double measureSNR(const std::string &output, const AudioBuffer &source)
+{
+    WavStreamDecoder decoder;
+    if (!decoder.Mapping.Open(output.c_str()) || !decoder.Open(decoder.Mapping.Data(), decoder.Mapping.Size()))
+        return 0.0;
+    std::vector<int16_t> chunk(4096 * 2);
+    double signal = 0.0, noise = 0.0;
+    size_t frame = 0, count;
+    while ((count = decoder.Read(chunk.data(), 4096)) > 0)
+    {
+        for (size_t i = 0; i < count * 2 && frame * 2 + i < source.Samples.size(); ++i)
+        {
+            double expected = source.Samples[frame * 2 + i], error = chunk[i] - expected;
+            signal += expected * expected;
+            noise += error * error;
+        }
+        frame += count;
+    }
+    if (frame != source.Frames())
+        return 0.0;
+    return noise > 0.0 ? 10.0 * std::log10(signal / noise) : 99.0;
+}
+
+int main(int argc, char *argv[])
+{
+    bool force = false;
+    std::vector<std::string> tracks;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--force")
+            force = true;
+        else
+            tracks.push_back(arg);
+    }
+    bool explicitTracks = !tracks.empty();
+    if (!explicitTracks)
+    {
+        std::error_code ec;
+        for (const fs::directory_entry &entry : fs::directory_iterator("resources/audio", ec))
+            if (entry.is_regular_file())
+                tracks.push_back(entry.path().generic_string());
+    }
+
+    int failures = 0;
+    for (const std::string &track : tracks)
+    {
+        std::string output = StreamedMusicFile(track);
+        std::error_code ec;
+        if (!force && fs::exists(output, ec) && fs::last_write_time(output, ec) >= fs::last_write_time(track, ec))
+        {
+            std::cout << output << " is up to date" << std::endl;
+            continue;
+        }
+        AudioBuffer buffer;
+        if (!decode(track, buffer))
+        {
+            std::cout << "ERROR::MUSICENCODER: Could not decode " << track << std::endl;
+            ++failures;
+            continue;
+        }
+        double seconds = double(buffer.Frames()) / AudioMixer::SAMPLE_RATE;
+        // short files are sound effects, the sound bank keeps those decoded
+        if (!explicitTracks && seconds < MIN_MUSIC_SECONDS)
+            continue;
+        fs::create_directories(fs::path(output).parent_path(), ec);
+        if (!WriteAdpcmWav(output.c_str(), buffer.Samples.data(), buffer.Frames(), AudioMixer::SAMPLE_RATE))
+        {
+            std::cout << "ERROR::MUSICENCODER: Could not write " << output << std::endl;
+            ++failures;
+            continue;
+        }
+        std::printf("%s: %.1f s, %.1f MB, SNR %.1f dB\n", output.c_str(), seconds,
+                    fs::file_size(output, ec) / (1024.0 * 1024.0), measureSNR(output, buffer));
+    }
+    return failures ? 1 : 0;
+}
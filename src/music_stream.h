@@ -0,0 +1,598 @@
+#ifndef MUSIC_STREAM_H
+#define MUSIC_STREAM_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include "audio_mixer.h"
+#include "mapped_file.h"
+#include "tracer.h"
+#include "startup_report.h"
+
+
+// Music is streamed from IMA ADPCM WAV files (4 bits per sample, decodable
+// block by block) that music_encoder writes next to the source tracks:
+// resources/audio/foo.mp3 -> resources/audio/streamed/foo.wav
+inline std::string StreamedMusicFile(const std::string &file)
+{
+    size_t slash = file.find_last_of('/');
+    size_t dot = file.find_last_of('.');
+    std::string folder = slash == std::string::npos ? std::string() : file.substr(0, slash + 1);
+    size_t start = slash == std::string::npos ? 0 : slash + 1;
+    std::string stem = file.substr(start, dot == std::string::npos || dot < start ? std::string::npos : dot - start);
+    return folder + "streamed/" + stem + ".wav";
+}
+
+namespace ImaAdpcm {
+    static const int StepTable[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+        253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+        1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+        12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+    static const int IndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+    static const int BLOCK_ALIGN = 2048; // bytes per stereo block
+    static const int FRAMES_PER_BLOCK = (BLOCK_ALIGN - 4 * 2) * 2 / 2 + 1; // 4-byte header per channel, then 2 codes per byte
+
+    struct Channel {
+        int Predictor = 0;
+        int Index = 0;
+    };
+    // applies one 4-bit code to the channel state and returns the new sample
+    inline int16_t Decode(Channel &channel, int code)
+    {
+        int step = StepTable[channel.Index];
+        int diff = step >> 3;
+        if (code & 1) diff += step >> 2;
+        if (code & 2) diff += step >> 1;
+        if (code & 4) diff += step;
+        channel.Predictor += (code & 8) ? -diff : diff;
+        channel.Predictor = std::max(-32768, std::min(32767, channel.Predictor));
+        channel.Index = std::max(0, std::min(88, channel.Index + IndexTable[code & 7]));
+        return int16_t(channel.Predictor);
+    }
+    // picks the code closest to sample, advancing the channel exactly like Decode
+    inline int Encode(Channel &channel, int sample)
+    {
+        int step = StepTable[channel.Index];
+        int diff = sample - channel.Predictor;
+        int code = 0;
+        if (diff < 0)
+        {
+            code = 8;
+            diff = -diff;
+        }
+        if (diff >= step) { code |= 4; diff -= step; }
+        step >>= 1;
+        if (diff >= step) { code |= 2; diff -= step; }
+        step >>= 1;
+        if (diff >= step) code |= 1;
+        Decode(channel, code);
+        return code;
+    }
+}
+
+// writes 16-bit stereo samples as a stereo IMA ADPCM WAV file (a quarter of the PCM size)
+inline bool WriteAdpcmWav(const char *path, const int16_t *samples, size_t frames, int sampleRate)
+{
+    using namespace ImaAdpcm;
+    std::FILE *file = std::fopen(path, "wb");
+    if (!file)
+        return false;
+    auto put32 = [&](uint32_t value) { unsigned char b[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) }; std::fwrite(b, 1, 4, file); };
+    auto put16 = [&](uint16_t value) { unsigned char b[2] = { uint8_t(value), uint8_t(value >> 8) }; std::fwrite(b, 1, 2, file); };
+    size_t blocks = (frames + FRAMES_PER_BLOCK - 1) / FRAMES_PER_BLOCK;
+    uint32_t bytes = uint32_t(blocks * BLOCK_ALIGN);
+    std::fwrite("RIFF", 1, 4, file); put32(4 + 28 + 12 + 8 + bytes); std::fwrite("WAVEfmt ", 1, 8, file);
+    put32(20); put16(0x11); put16(2); put32(sampleRate);
+    put32(uint32_t(uint64_t(sampleRate) * BLOCK_ALIGN / FRAMES_PER_BLOCK)); put16(BLOCK_ALIGN); put16(4);
+    put16(2); put16(FRAMES_PER_BLOCK);
+    std::fwrite("fact", 1, 4, file); put32(4); put32(uint32_t(frames));
+    std::fwrite("data", 1, 4, file); put32(bytes);
+
+    Channel channels[2];
+    std::vector<unsigned char> block(BLOCK_ALIGN);
+    for (size_t first = 0; first < frames; first += FRAMES_PER_BLOCK)
+    {
+        // frames past the end repeat the last one
+        auto sample = [&](size_t frame, int c) { return int(samples[std::min(frame, frames - 1) * 2 + c]); };
+        unsigned char *out = block.data();
+        for (int c = 0; c < 2; ++c)
+        {
+            // the block header carries the first sample verbatim, so errors never cross blocks
+            channels[c].Predictor = sample(first, c);
+            out[0] = uint8_t(channels[c].Predictor);
+            out[1] = uint8_t(channels[c].Predictor >> 8);
+            out[2] = uint8_t(channels[c].Index);
+            out[3] = 0;
+            out += 4;
+        }
+        // groups of 8 samples per channel, 4 bytes each, low nibble first
+        for (size_t group = 0; group < (FRAMES_PER_BLOCK - 1) / 8; ++group)
+            for (int c = 0; c < 2; ++c)
+                for (int i = 0; i < 8; i += 2)
+                {
+                    size_t frame = first + 1 + group * 8 + i;
+                    int low = Encode(channels[c], sample(frame, c));
+                    int high = Encode(channels[c], sample(frame + 1, c));
+                    *out++ = uint8_t(low | high << 4);
+                }
+        std::fwrite(block.data(), 1, block.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+// A source of music frames, 16-bit stereo at SampleRate. Read returns 0 at the end.
+class MusicDecoder
+{
+public:
+    int SampleRate = AudioMixer::SAMPLE_RATE;
+
+    virtual ~MusicDecoder() { }
+    virtual size_t Read(int16_t *out, size_t frames) = 0;
+    virtual void Rewind() = 0;
+};
+
+// Decodes a WAV file (PCM, float or IMA ADPCM) a chunk at a time straight
+// from memory: a view into the asset pack or a mapped loose file kept in
+// Mapping, so only the pages being played are touched.
+class WavStreamDecoder : public MusicDecoder
+{
+public:
+    MappedFile Mapping; // owns the bytes when they come from a loose file
+
+    bool Open(const unsigned char *data, size_t size)
+    {
+        auto u16 = [&](size_t at) { return uint32_t(data[at] | data[at + 1] << 8); };
+        auto u32 = [&](size_t at) { return uint32_t(data[at] | data[at + 1] << 8 | data[at + 2] << 16 | uint32_t(data[at + 3]) << 24); };
+        if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+            return false;
+        size_t factFrames = 0;
+        for (size_t at = 12; at + 8 <= size; )
+        {
+            uint32_t chunk = u32(at + 4);
+            size_t body = at + 8;
+            if (std::memcmp(data + at, "fmt ", 4) == 0 && chunk >= 16 && body + 16 <= size)
+            {
+                this->format = u16(body);
+                this->channels = u16(body + 2);
+                this->SampleRate = int(u32(body + 4));
+                this->blockAlign = u16(body + 12);
+                this->bits = u16(body + 14);
+                if (this->format == 0xFFFE && chunk >= 26)
+                    this->format = u16(body + 24);
+                if (this->format == 0x11 && chunk >= 20)
+                    this->framesPerBlock = u16(body + 18);
+            }
+            else if (std::memcmp(data + at, "fact", 4) == 0 && chunk >= 4 && body + 4 <= size)
+                factFrames = u32(body);
+            else if (std::memcmp(data + at, "data", 4) == 0)
+            {
+                this->data = data + body;
+                this->size = std::min<size_t>(chunk, size - body);
+                break;
+            }
+            at = body + chunk + (chunk & 1);
+        }
+        if (!this->data || this->channels < 1 || this->channels > 2 || this->SampleRate <= 0)
+            return false;
+        if (this->format == 0x11)
+        {
+            if (this->bits != 4 || this->blockAlign <= 4 * this->channels ||
+                this->framesPerBlock != (this->blockAlign - 4 * this->channels) * 2 / this->channels + 1)
+                return false;
+            size_t blocks = this->size / this->blockAlign;
+            this->frames = factFrames ? std::min(factFrames, blocks * this->framesPerBlock) : blocks * this->framesPerBlock;
+            this->block.resize(this->framesPerBlock * 2);
+        }
+        else
+        {
+            bool isFloat = this->format == 3;
+            if ((this->format != 1 && !isFloat) || (this->bits != 8 && this->bits != 16 && this->bits != 24 && this->bits != 32) ||
+                (isFloat && this->bits != 32))
+                return false;
+            this->frames = this->size / (this->channels * this->bits / 8);
+        }
+        this->Rewind();
+        return true;
+    }
+    size_t Read(int16_t *out, size_t frames) override
+    {
+        size_t done = 0;
+        while (done < frames && this->position < this->frames)
+        {
+            size_t count = std::min(frames - done, this->frames - this->position);
+            if (this->format == 0x11)
+            {
+                size_t index = this->position / this->framesPerBlock;
+                size_t offset = this->position % this->framesPerBlock;
+                if (index != this->decodedBlock)
+                    this->decodeBlock(index);
+                count = std::min(count, size_t(this->framesPerBlock) - offset);
+                std::memcpy(out + done * 2, this->block.data() + offset * 2, count * 4);
+            }
+            else
+            {
+                size_t frameBytes = this->channels * this->bits / 8;
+                ConvertPCM(this->data + this->position * frameBytes, count, this->channels, this->bits, this->format == 3,
+                           this->SampleRate, this->SampleRate, this->converted);
+                std::memcpy(out + done * 2, this->converted.Samples.data(), count * 4);
+            }
+            done += count;
+            this->position += count;
+        }
+        return done;
+    }
+    void Rewind() override
+    {
+        this->position = 0;
+    }
+    size_t Frames() const { return this->frames; }
+
+private:
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    int format = 0, channels = 0, bits = 0, blockAlign = 0, framesPerBlock = 0;
+    size_t frames = 0, position = 0;
+    size_t decodedBlock = size_t(-1);
+    std::vector<int16_t> block; // the current ADPCM block, decoded
+    AudioBuffer converted;      // the current PCM chunk, converted
+
+    void decodeBlock(size_t index)
+    {
+        const unsigned char *in = this->data + index * this->blockAlign;
+        ImaAdpcm::Channel state[2];
+        for (int c = 0; c < this->channels; ++c)
+        {
+            state[c].Predictor = int16_t(in[0] | in[1] << 8);
+            state[c].Index = std::min<int>(in[2], 88);
+            this->block[c] = int16_t(state[c].Predictor);
+            in += 4;
+        }
+        for (int group = 0; group < (this->framesPerBlock - 1) / 8; ++group)
+            for (int c = 0; c < this->channels; ++c)
+                for (int i = 0; i < 8; i += 2, ++in)
+                {
+                    size_t frame = 1 + group * 8 + i;
+                    this->block[frame * 2 + c] = ImaAdpcm::Decode(state[c], *in & 15);
+                    this->block[(frame + 1) * 2 + c] = ImaAdpcm::Decode(state[c], *in >> 4);
+                }
+        if (this->channels == 1)
+            for (int frame = 0; frame < this->framesPerBlock; ++frame)
+                this->block[frame * 2 + 1] = this->block[frame * 2];
+        this->decodedBlock = index;
+    }
+};
+
+// Plays an already decoded buffer, for tracks that have no streamed version yet.
+class BufferDecoder : public MusicDecoder
+{
+public:
+    explicit BufferDecoder(AudioBuffer buffer) : buffer(std::move(buffer)) { }
+    size_t Read(int16_t *out, size_t frames) override
+    {
+        size_t count = std::min(frames, this->buffer.Frames() - this->position);
+        std::memcpy(out, this->buffer.Samples.data() + this->position * 2, count * 4);
+        this->position += count;
+        return count;
+    }
+    void Rewind() override
+    {
+        this->position = 0;
+    }
+
+private:
+    AudioBuffer buffer;
+    size_t position = 0;
+};
+
+// Lock-free ring of 16-bit stereo frames between the decoder thread (Write)
+// and the output thread (Read), Capacity frames, a power of two.
+template <size_t Capacity>
+class SampleRing
+{
+public:
+    size_t Available() const
+    {
+        return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+    }
+    size_t Free() const { return Capacity - this->Available(); }
+    size_t Write(const int16_t *in, size_t frames)
+    {
+        size_t tail = this->tail.load(std::memory_order_relaxed);
+        frames = std::min(frames, Capacity - (tail - this->head.load(std::memory_order_acquire)));
+        size_t start = tail & (Capacity - 1), first = std::min(frames, Capacity - start);
+        std::memcpy(this->samples + start * 2, in, first * 4);
+        std::memcpy(this->samples, in + first * 2, (frames - first) * 4);
+        this->tail.store(tail + frames, std::memory_order_release);
+        return frames;
+    }
+    size_t Read(int16_t *out, size_t frames)
+    {
+        size_t head = this->head.load(std::memory_order_relaxed);
+        frames = std::min(frames, this->tail.load(std::memory_order_acquire) - head);
+        size_t start = head & (Capacity - 1), first = std::min(frames, Capacity - start);
+        std::memcpy(out, this->samples + start * 2, first * 4);
+        std::memcpy(out + first * 2, this->samples, (frames - first) * 4);
+        this->head.store(head + frames, std::memory_order_release);
+        return frames;
+    }
+
+private:
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    int16_t samples[Capacity * 2];
+    std::atomic<size_t> head{ 0 }, tail{ 0 };
+};
+
+typedef std::function<std::unique_ptr<MusicDecoder>(const std::string &file)> MusicOpener;
+
+// One track being played: the decoder thread keeps its ring topped up and
+// the mixer reads from the ring. Looping rewinds the decoder before the
+// ring runs dry, so the seam is gapless. Memory is the ring plus one
+// decode chunk, whatever the length of the track.
+class MusicStream : public AudioStream
+{
+public:
+    static constexpr size_t RING_FRAMES = 32768;  // 0.74 s at 44.1 kHz
+    static constexpr size_t PRIME_FRAMES = 8192;  // buffered before the voice starts
+    static constexpr size_t CHUNK_FRAMES = 2048;
+
+    const std::string File;
+    const bool Loop;
+
+    MusicStream(const std::string &file, bool loop) : File(file), Loop(loop) { }
+
+    size_t Read(int16_t *out, size_t frames) override
+    {
+        return this->ring.Read(out, frames);
+    }
+    bool Finished() const override
+    {
+        return this->ended.load(std::memory_order_acquire) && this->ring.Available() == 0;
+    }
+    // ready to start: enough is buffered, or the track already ended (or failed to open)
+    bool Primed() const
+    {
+        return this->ended.load(std::memory_order_acquire) || this->ring.Available() >= PRIME_FRAMES;
+    }
+    bool Failed() const { return this->failed.load(std::memory_order_acquire); }
+
+    // decoder thread: opens the track on first use and tops up the ring,
+    // returns whether anything was decoded
+    bool Fill(const MusicOpener &open)
+    {
+        if (this->ended.load(std::memory_order_relaxed))
+            return false;
+        if (!this->decoder)
+        {
+            {
+                STARTUP_PHASE("music open", &this->File);
+                this->decoder = open(this->File);
+            }
+            if (!this->decoder)
+            {
+                std::cout << "ERROR::MUSIC: Could not open " << this->File << std::endl;
+                this->failed.store(true, std::memory_order_release);
+                this->ended.store(true, std::memory_order_release);
+                return false;
+            }
+            this->step = double(this->decoder->SampleRate) / AudioMixer::SAMPLE_RATE;
+            this->chunk.resize(CHUNK_FRAMES * 2);
+            this->resampled.reserve(size_t(CHUNK_FRAMES / this->step + 2) * 2);
+        }
+        bool decoded = false;
+        // a chunk resamples to at most CHUNK_FRAMES / step + 1 frames
+        while (this->ring.Free() >= size_t(CHUNK_FRAMES / this->step) + 2)
+        {
+            size_t count = this->decoder->Read(this->chunk.data(), CHUNK_FRAMES);
+            if (count == 0)
+            {
+                if (!this->Loop || !this->hasData)
+                {
+                    this->ended.store(true, std::memory_order_release);
+                    break;
+                }
+                this->decoder->Rewind();
+                continue;
+            }
+            this->hasData = true;
+            decoded = true;
+            if (this->decoder->SampleRate == AudioMixer::SAMPLE_RATE)
+                this->ring.Write(this->chunk.data(), count);
+            else
+            {
+                this->resample(count);
+                this->ring.Write(this->resampled.data(), this->resampled.size() / 2);
+            }
+        }
+        return decoded;
+    }
+
+private:
+    SampleRing<RING_FRAMES> ring;
+    std::unique_ptr<MusicDecoder> decoder;
+    std::atomic<bool> ended{ false }, failed{ false };
+    bool hasData = false;
+    std::vector<int16_t> chunk, resampled;
+    // linear resampler state, carried across chunks and loop seams
+    double step = 1.0, phase = 0.0;
+    int16_t previous[2] = { 0, 0 };
+
+    void resample(size_t count)
+    {
+        this->resampled.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const int16_t *current = this->chunk.data() + i * 2;
+            for (; this->phase < 1.0; this->phase += this->step)
+                for (int c = 0; c < 2; ++c)
+                    this->resampled.push_back(int16_t(this->previous[c] + (current[c] - this->previous[c]) * this->phase));
+            this->phase -= 1.0;
+            this->previous[0] = current[0];
+            this->previous[1] = current[1];
+        }
+    }
+};
+
+// MusicPlayer plays one music track at a time on the mixer and crossfades
+// when the track changes. Tracks are opened and decoded on a background
+// thread; Play and Update run on the game thread and never wait for it.
+class MusicPlayer
+{
+public:
+    MusicPlayer() { }
+    ~MusicPlayer() { this->Stop(); }
+    MusicPlayer(const MusicPlayer&) = delete;
+    MusicPlayer &operator=(const MusicPlayer&) = delete;
+
+    // starts the decoder thread, open turns a track name into a decoder
+    void Start(AudioMixer &mixer, MusicOpener open)
+    {
+        this->Stop();
+        this->mixer = &mixer;
+        this->open = std::move(open);
+        this->running = true;
+        this->thread = std::thread([this]() {
+            Tracer::NameThread("music");
+            this->run();
+        });
+    }
+    // stops decoding; the mixer output must be stopped before the player is destroyed
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->running = false;
+        }
+        this->wake.notify_all();
+        if (this->thread.joinable())
+            this->thread.join();
+    }
+    // switches to file, crossfading over seconds once it is buffered; the current track just keeps playing
+    void Play(const std::string &file, float volume, float crossfade = 1.0f, bool loop = true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            // a track that was requested but never started is dropped, unless it is this one
+            bool keep = false;
+            for (auto track = this->tracks.rbegin(); track != this->tracks.rend(); ++track)
+            {
+                if (track->Retiring)
+                    continue;
+                if (track->Stream->File == file)
+                {
+                    keep = true;
+                    break;
+                }
+                if (!track->Voice)
+                    track->Retiring = true;
+            }
+            if (keep)
+                return;
+            Track track;
+            track.Stream = std::make_shared<MusicStream>(file, loop);
+            track.Volume = volume;
+            track.Fade = crossfade;
+            this->tracks.push_back(track);
+        }
+        this->wake.notify_all();
+    }
+    // game thread, once per frame: starts buffered tracks and frees faded-out ones
+    void Update()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (size_t i = 0; i < this->tracks.size(); ++i)
+        {
+            Track &track = this->tracks[i];
+            if (track.Retiring || track.Voice || !track.Stream->Primed())
+                continue;
+            if (track.Stream->Failed())
+            {
+                // keep what was playing
+                track.Retiring = true;
+                continue;
+            }
+            track.Voice = this->mixer->PlayStream(track.Stream.get(), track.Volume, 0.0f, track.Fade);
+            for (size_t j = 0; j < this->tracks.size(); ++j)
+                if (j != i && !this->tracks[j].Retiring)
+                {
+                    if (this->tracks[j].Voice)
+                        this->mixer->Stop(this->tracks[j].Voice, track.Fade);
+                    this->tracks[j].Retiring = true;
+                }
+        }
+        // the mixer no longer reads a stream once its voice is gone
+        this->tracks.erase(std::remove_if(this->tracks.begin(), this->tracks.end(), [this](const Track &track) {
+            bool silent = !track.Voice || !this->mixer->IsPlaying(track.Voice);
+            return silent && (track.Retiring || (track.Voice && track.Stream->Finished()));
+        }), this->tracks.end());
+    }
+    // the track that is playing or about to, empty when none
+    std::string Current() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (auto track = this->tracks.rbegin(); track != this->tracks.rend(); ++track)
+            if (!track->Retiring)
+                return track->Stream->File;
+        return std::string();
+    }
+    // tracks alive, two while crossfading
+    size_t Tracks() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->tracks.size();
+    }
+
+private:
+    struct Track {
+        std::shared_ptr<MusicStream> Stream; // shared with the decoder thread while it fills
+        VoiceId Voice = 0;
+        float Volume = 1.0f, Fade = 1.0f;
+        bool Retiring = false;
+    };
+
+    AudioMixer *mixer = nullptr;
+    MusicOpener open;
+    std::vector<Track> tracks;
+    std::vector<std::shared_ptr<MusicStream>> filling; // decoder thread only
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+    std::thread thread;
+
+    void run()
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                // a ring lasts 0.7 s, checking every 20 ms keeps it well above the prime level
+                this->wake.wait_for(lock, std::chrono::milliseconds(20));
+                if (!this->running)
+                    break;
+                this->filling.clear();
+                for (const Track &track : this->tracks)
+                    this->filling.push_back(track.Stream);
+            }
+            // decode outside the lock so opening a track never stalls Play or Update
+            TRACE_SCOPE("music decode");
+            for (const std::shared_ptr<MusicStream> &stream : this->filling)
+                stream->Fill(this->open);
+        }
+        this->filling.clear();
+    }
+};
+
+#endif
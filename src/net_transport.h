@@ -0,0 +1,257 @@
+#ifndef NET_TRANSPORT_H
+#define NET_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <tuple>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+
+// Transport moves datagrams between the two players of a versus game. Like
+// UDP, a datagram arrives whole or not at all, maybe late, maybe out of
+// order; the rollback session (rollback.h) copes with all of that. Neither
+// call blocks.
+class Transport
+{
+public:
+    static constexpr size_t MAX_DATAGRAM = 512;
+
+    virtual ~Transport() { }
+    // sends one datagram, false if it could not be handed to the network
+    virtual bool Send(const unsigned char *data, size_t size) = 0;
+    // the next received datagram in data, its size, 0 when none is waiting
+    virtual size_t Receive(unsigned char *data, size_t capacity) = 0;
+};
+
+// UdpTransport is a non-blocking UDP socket bound to a local port that only
+// talks to one remote address, e.g. two games on one machine:
+//   player 0: Open(7000, "127.0.0.1", 7001)   player 1: Open(7001, "127.0.0.1", 7000)
+// Datagrams from any other address are dropped.
+class UdpTransport : public Transport
+{
+public:
+    UdpTransport() { }
+    ~UdpTransport() { this->Close(); }
+    UdpTransport(const UdpTransport&) = delete;
+    UdpTransport &operator=(const UdpTransport&) = delete;
+
+    bool Open(unsigned short localPort, const std::string &remoteHost, unsigned short remotePort)
+    {
+        this->Close();
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        {
+            std::cout << "ERROR::NET: WSAStartup failed" << std::endl;
+            return false;
+        }
+        this->started = true;
+#endif
+        addrinfo hints;
+        std::memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo *found = nullptr;
+        if (getaddrinfo(remoteHost.c_str(), std::to_string(remotePort).c_str(), &hints, &found) != 0 || !found)
+        {
+            std::cout << "ERROR::NET: Could not resolve " << remoteHost << std::endl;
+            this->Close();
+            return false;
+        }
+        std::memcpy(&this->remote, found->ai_addr, sizeof(this->remote));
+        freeaddrinfo(found);
+
+        this->socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (!this->IsOpen())
+        {
+            std::cout << "ERROR::NET: Could not create a UDP socket" << std::endl;
+            this->Close();
+            return false;
+        }
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        local.sin_port = htons(localPort);
+        if (bind(this->socket, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0)
+        {
+            std::cout << "ERROR::NET: Could not bind UDP port " << localPort << std::endl;
+            this->Close();
+            return false;
+        }
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(this->socket, FIONBIO, &nonBlocking);
+#else
+        fcntl(this->socket, F_SETFL, fcntl(this->socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        return true;
+    }
+    void Close()
+    {
+        if (this->IsOpen())
+        {
+#ifdef _WIN32
+            closesocket(this->socket);
+#else
+            close(this->socket);
+#endif
+        }
+        this->socket = INVALID;
+#ifdef _WIN32
+        if (this->started)
+            WSACleanup();
+        this->started = false;
+#endif
+    }
+    bool IsOpen() const { return this->socket != INVALID; }
+
+    bool Send(const unsigned char *data, size_t size) override
+    {
+        if (!this->IsOpen())
+            return false;
+        return sendto(this->socket, reinterpret_cast<const char*>(data), int(size), 0,
+                      reinterpret_cast<const sockaddr*>(&this->remote), sizeof(this->remote)) == int(size);
+    }
+    size_t Receive(unsigned char *data, size_t capacity) override
+    {
+        while (this->IsOpen())
+        {
+            sockaddr_in from;
+            socklen_t fromSize = sizeof(from);
+            int size = int(recvfrom(this->socket, reinterpret_cast<char*>(data), int(capacity), 0,
+                                    reinterpret_cast<sockaddr*>(&from), &fromSize));
+            if (size <= 0)
+                return 0; // nothing waiting (or an error, e.g. the other game is not up yet)
+            if (from.sin_addr.s_addr == this->remote.sin_addr.s_addr && from.sin_port == this->remote.sin_port)
+                return size_t(size);
+        }
+        return 0;
+    }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+    static constexpr Socket INVALID = INVALID_SOCKET;
+    bool started = false;
+#else
+    typedef int Socket;
+    static constexpr Socket INVALID = -1;
+#endif
+    Socket socket = INVALID;
+    sockaddr_in remote;
+};
+
+// SimulatedLink connects two in-process endpoints through a network that
+// runs on a tick clock: every datagram is held for Latency ticks plus up to
+// Jitter more (so they can overtake each other) and dropped with
+// probability Loss. The random numbers come from Seed, a test run replays
+// exactly. Step() advances the clock, once per simulated tick.
+class SimulatedLink
+{
+public:
+    struct Settings {
+        unsigned int Latency = 3;
+        unsigned int Jitter = 0;
+        float Loss = 0.0f;
+        uint32_t Seed = 1;
+    };
+
+    explicit SimulatedLink(const Settings &settings)
+        : settings(settings), random(settings.Seed ? settings.Seed : 1), ends{ { this, 0 }, { this, 1 } } { }
+    SimulatedLink(const SimulatedLink&) = delete;
+    SimulatedLink &operator=(const SimulatedLink&) = delete;
+
+    // the transport of player side (0 or 1)
+    Transport &End(int side) { return this->ends[side]; }
+    void Step() { ++this->now; }
+
+    uint64_t Sent() const { return this->sent; }
+    uint64_t Dropped() const { return this->dropped; }
+
+private:
+    struct Datagram {
+        uint64_t Due = 0, Order = 0;
+        std::vector<unsigned char> Data;
+    };
+    class Endpoint : public Transport
+    {
+    public:
+        Endpoint(SimulatedLink *link, int side) : link(link), side(side) { }
+        bool Send(const unsigned char *data, size_t size) override { return this->link->send(1 - this->side, data, size); }
+        size_t Receive(unsigned char *data, size_t capacity) override { return this->link->receive(this->side, data, capacity); }
+    private:
+        SimulatedLink *link;
+        int side;
+    };
+
+    Settings settings;
+    uint32_t random;
+    Endpoint ends[2];
+    std::vector<Datagram> queues[2]; // datagrams on their way to side 0, 1
+    uint64_t now = 0, order = 0, sent = 0, dropped = 0;
+
+    // xorshift32
+    uint32_t next()
+    {
+        this->random ^= this->random << 13;
+        this->random ^= this->random >> 17;
+        this->random ^= this->random << 5;
+        return this->random;
+    }
+    bool send(int to, const unsigned char *data, size_t size)
+    {
+        ++this->sent;
+        if (this->settings.Loss > 0.0f && (this->next() & 0xFFFFFF) < uint32_t(this->settings.Loss * 0x1000000))
+        {
+            ++this->dropped;
+            return true; // lost on the way, the sender cannot tell
+        }
+        Datagram datagram;
+        datagram.Due = this->now + this->settings.Latency + (this->settings.Jitter ? this->next() % (this->settings.Jitter + 1) : 0);
+        datagram.Order = this->order++;
+        datagram.Data.assign(data, data + size);
+        this->queues[to].push_back(std::move(datagram));
+        return true;
+    }
+    size_t receive(int side, unsigned char *data, size_t capacity)
+    {
+        std::vector<Datagram> &queue = this->queues[side];
+        auto first = queue.end();
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+            if (it->Due <= this->now && (first == queue.end() || std::tie(it->Due, it->Order) < std::tie(first->Due, first->Order)))
+                first = it;
+        if (first == queue.end())
+            return 0;
+        size_t size = std::min(capacity, first->Data.size());
+        std::memcpy(data, first->Data.data(), size);
+        queue.erase(first);
+        return size;
+    }
+};
+
+#endif
@@ -7,6 +7,8 @@
 
 #include "shader.h"
 #include "texture.h"
+#include "resource_handle.h"
+#include "resource_manager.h"
 #include "game_object.h"
 
 
@@ -27,11 +29,19 @@ class ParticleGenerator
 {
 public:
     // constructor
-    ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
+    ParticleGenerator(ShaderHandle shader, TextureHandle texture, unsigned int amount)
         : shader(shader), texture(texture), amount(amount)
     {
         this->init();
     }
+    // destructor
+    ~ParticleGenerator()
+    {
+        glDeleteVertexArrays(1, &this->VAO);
+        glDeleteBuffers(1, &this->VBO);
+    }
+    ParticleGenerator(const ParticleGenerator&) = delete;
+    ParticleGenerator &operator=(const ParticleGenerator&) = delete;
     // update all particles
     void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f))
     {
@@ -56,13 +66,15 @@ public:
     // render all particles
     void Draw()
     {
-        this->shader.Use();
+        Shader &shader = ResourceManager::GetShader(this->shader);
+        Texture2D &texture = ResourceManager::GetTexture(this->texture);
+        shader.Use();
         for (Particle particle : this->particles)
         {
             if (particle.Life > 0.0f)
             {
-                this->shader.SetVector2f("offset", particle.Position);
-                this->shader.SetVector4f("color", particle.Color);
+                shader.SetVector2f("offset", particle.Position);
+                shader.SetVector4f("color", particle.Color);
                 glActiveTexture(GL_TEXTURE0);
                 texture.Bind();
                 glBindVertexArray(this->VAO);
@@ -71,11 +83,12 @@ public:
             }
         }
     }
-    // delete particle
+    // delete particle - kills every particle, the mesh is kept
     void deleteParticle()
     {
-        particles.clear();
-        this->init();
+        for (Particle &particle : this->particles)
+            particle = Particle();
+        this->lastUsedParticle = 0;
     }
 
 private:
@@ -83,15 +96,14 @@ private:
     std::vector<Particle> particles;
     unsigned int amount;
     // render state
-    Shader shader;
-    Texture2D texture;
-    unsigned int VAO;
+    ShaderHandle shader;
+    TextureHandle texture;
+    unsigned int VAO, VBO;
 
     // initializes buffer and vertex attributes
     void init()
     {
         // set up mesh and attribute properties
-        unsigned int VBO;
         float particle_quad[] = {
             0.0f, 1.0f, 0.0f, 1.0f,
             1.0f, 0.0f, 1.0f, 0.0f,
@@ -102,10 +114,10 @@ private:
             1.0f, 0.0f, 1.0f, 0.0f
         }; 
         glGenVertexArrays(1, &this->VAO);
-        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &this->VBO);
         glBindVertexArray(this->VAO);
         // fill mesh buffer
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(particle_quad), particle_quad, GL_STATIC_DRAW);
         // set mesh attributes
         glEnableVertexAttribArray(0);
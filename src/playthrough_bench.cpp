@@ -0,0 +1,510 @@
+// playthrough_bench - plays every level from input scripts without a window and gates regressions.
+//
+//   playthrough_bench [--runs <n>] [--level <n>] [--write-baseline <file>]
+//                     [--compare <file>] [--threshold <fraction>] [--solve]
+//                     [--fixed-physics] [--strict-timing]
+//
+// Loads the game with GL stubbed out (gl_stub.h) and the null audio output,
+// then plays level 1 .. 10 from resources/playthrough/<n>.txt through
+// Game::Update and Game::ProcessInput at a fixed 60 Hz timestep, the same
+// calls the main loop makes. For every level it reports the simulated ticks
+// per second, the slowest tick, the heap allocations of the main thread
+// (alloc_tracker.h) and whether the script still reaches the goal; a script
+// that no longer does fails the run. A level without a script is skipped,
+// except with --compare, where every level of resources/gamelevels must
+// have one. The timings are the best of --runs playthroughs (default 10).
+// --write-baseline stores the results, --compare fails (exit code 1) when a
+// level no longer reaches the goal or allocates more than the baseline. A
+// level slower than the baseline by more than --threshold (default 0.25, for
+// the tick rate and the slowest tick) only gets a warning: the timings are
+// those of the machine that wrote the baseline. --strict-timing fails on it
+// too, for a baseline recorded on the same machine. --solve
+// searches for new scripts (beam search over left/right/no input) for the
+// levels whose script is missing or broken and writes them.
+// Every level also gets a hash of the game state after each tick
+// (Game::StateHash). With --fixed-physics the game runs the fixed-point
+// physics on the scripts in resources/playthrough/fixed/, and --compare
+// gates on the hash: every level must be in the baseline with a hash, and
+// the replay must match it bit for bit on every compiler and CPU, which
+// makes resources/playthrough/baseline_fixed.txt usable on any machine.
+// Float physics only reports it.
+// Run from the repository root.
+#define ALLOC_TRACKER_IMPLEMENTATION
+#include "alloc_tracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <tuple>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl_stub.h"
+#include "game.h"
+
+static const float TICK = 1.0f / 60.0f;
+static const char *const SCRIPT_FOLDER = "resources/playthrough";
+// --fixed-physics plays its own scripts: the fixed-point ball ends up on the other side of
+// a speed or collision threshold now and then, so float recordings drift off course
+static const char *const FIXED_SCRIPT_FOLDER = "resources/playthrough/fixed";
+static bool fixedScripts = false;
+
+// one input per tick: which of the movement keys are held
+enum TickInput : unsigned char { INPUT_NONE = 0, INPUT_LEFT = 1, INPUT_RIGHT = 2 };
+
+// scripts are lines of "<ticks> <keys>", keys being L, R or - (nothing), # starts a comment
+static bool loadScript(const std::string &file, std::vector<unsigned char> &ticks)
+{
+    std::ifstream stream(file);
+    if (!stream)
+        return false;
+    ticks.clear();
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned int count;
+        std::string keys;
+        if (!(fields >> count >> keys))
+            continue;
+        unsigned char input = INPUT_NONE;
+        if (keys.find('L') != std::string::npos)
+            input |= INPUT_LEFT;
+        if (keys.find('R') != std::string::npos)
+            input |= INPUT_RIGHT;
+        ticks.insert(ticks.end(), count, input);
+    }
+    return !ticks.empty();
+}
+
+static bool writeScript(const std::string &file, unsigned int level, const std::vector<unsigned char> &ticks)
+{
+    std::ofstream stream(file);
+    if (!stream)
+        return false;
+    stream << "# level " << level << " - one line per run of ticks (1/60 s): <ticks> <keys>, L = left, R = right, - = none\n";
+    for (size_t i = 0; i < ticks.size();)
+    {
+        size_t run = 1;
+        while (i + run < ticks.size() && ticks[i + run] == ticks[i])
+            ++run;
+        const char *keys = ticks[i] == INPUT_LEFT ? "L" : ticks[i] == INPUT_RIGHT ? "R" : ticks[i] ? "LR" : "-";
+        stream << run << ' ' << keys << '\n';
+        i += run;
+    }
+    return bool(stream);
+}
+
+static std::string scriptFile(unsigned int level)
+{
+    return std::string(fixedScripts ? FIXED_SCRIPT_FOLDER : SCRIPT_FOLDER) + "/" + std::to_string(level) + ".txt";
+}
+
+// the game between ticks, enough to resume a level from the same point (used by the solver)
+struct Snapshot {
+    GameLevel Level;
+    float SpeedX = 0.0f, SpeedY = 0.0f;
+    Fixed FixedSpeedX, FixedSpeedY;
+};
+
+class Playthrough
+{
+public:
+    Game World;
+
+    Playthrough() : World(800, 600) { }
+
+    void Load()
+    {
+        StubGL();
+        this->World.SetAudioOutput("null");
+        this->World.Init();
+        // the loading screen: jobs run on the workers, their GL parts in Update
+        while (this->World.State == GAME_LOADING)
+        {
+            this->World.Update(TICK);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        StartupReport::Main().Close();
+    }
+    // starts level (1-based) like the menu does
+    void Start(unsigned int level)
+    {
+        this->World.enterLevel(level - 1);
+        this->World.State = GAME_ACTIVE;
+        this->World.deathCount = 0;
+        std::fill(std::begin(this->World.Keys), std::end(this->World.Keys), false);
+        std::fill(std::begin(this->World.KeysProcessed), std::end(this->World.KeysProcessed), false);
+    }
+    // one frame of the main loop
+    void Tick(unsigned char input)
+    {
+        this->World.Keys[GLFW_KEY_A] = (input & INPUT_LEFT) != 0;
+        this->World.Keys[GLFW_KEY_D] = (input & INPUT_RIGHT) != 0;
+        this->World.Update(TICK);
+        this->World.ProcessInput(TICK);
+    }
+    bool Reached(unsigned int level) const
+    {
+        return this->World.Level != level - 1 || this->World.State == GAME_WIN;
+    }
+    void Save(Snapshot &snapshot) const
+    {
+        snapshot.Level = this->World.CurrentLevel;
+        snapshot.SpeedX = PLAYER_SPEED_X;
+        snapshot.SpeedY = PLAYER_SPEED_Y;
+        snapshot.FixedSpeedX = FIXED_SPEED_X;
+        snapshot.FixedSpeedY = FIXED_SPEED_Y;
+    }
+    void Restore(unsigned int level, const Snapshot &snapshot)
+    {
+        this->World.Level = level - 1;
+        this->World.State = GAME_ACTIVE;
+        this->World.pendingLevel = -1;
+        this->World.CurrentLevel = snapshot.Level;
+        PLAYER_SPEED_X = snapshot.SpeedX;
+        PLAYER_SPEED_Y = snapshot.SpeedY;
+        FIXED_SPEED_X = snapshot.FixedSpeedX;
+        FIXED_SPEED_Y = snapshot.FixedSpeedY;
+    }
+    // distance from the ball to the nearest goal block
+    float GoalDistance() const
+    {
+        const GameObject *ball = this->World.GetPlayer();
+        float best = 1e9f;
+        for (const GameObject &block : this->World.CurrentLevel.Blocks)
+            if (block.Type == GOAL)
+                best = std::min(best, glm::length((block.Position + block.Size * 0.5f) - (ball->Position + ball->Size * 0.5f)));
+        return best;
+    }
+};
+
+struct LevelResult {
+    unsigned int Level = 0;
+    bool Reached = false;
+    unsigned int Ticks = 0, Deaths = 0;
+    double TicksPerSecond = 0.0, WorstTick = 0.0; // WorstTick in microseconds
+    uint64_t Allocations = 0;
+    uint64_t StateHash = 0; // Game::StateHash of every tick folded together, 0 = not recorded
+};
+
+static LevelResult play(Playthrough &game, unsigned int level, const std::vector<unsigned char> &script)
+{
+    LevelResult result;
+    result.Level = level;
+    game.Start(level);
+    uint64_t allocations = AllocTracker::ThreadAllocations();
+    uint64_t hash = 14695981039346656037ull;
+    double total = 0.0;
+    for (unsigned char input : script)
+    {
+        uint64_t before = AllocTracker::ThreadAllocations();
+        auto start = std::chrono::steady_clock::now();
+        game.Tick(input);
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        total += elapsed;
+        ++result.Ticks;
+        hash = (hash ^ game.World.StateHash()) * 1099511628211ull;
+        if (game.Reached(level))
+        {
+            // the last tick starts the next level (disk and streamer), not gameplay
+            result.Reached = true;
+            allocations += AllocTracker::ThreadAllocations() - before;
+            break;
+        }
+        result.WorstTick = std::max(result.WorstTick, elapsed);
+    }
+    result.Allocations = AllocTracker::ThreadAllocations() - allocations;
+    result.Deaths = game.World.deathCount;
+    result.StateHash = hash;
+    result.TicksPerSecond = total > 0.0 ? result.Ticks * 1e6 / total : 0.0;
+    return result;
+}
+
+// search for an input script that reaches the goal without dying: every
+// candidate is extended by a few ticks of each input, the ones closest to
+// the goal go on. Candidates whose ball is in the same state (screen cell,
+// direction of flight, straight flight, blocks broken so far) are merged, per step for the
+// greedy pass and over the whole search for the exploring pass, which is tried when the
+// greedy one gets stuck (levels where the way leads away from the goal first, or through
+// a block that has to be broken on an earlier pass, like 8)
+static bool solve(Playthrough &game, unsigned int level, bool explore, std::vector<unsigned char> &script)
+{
+    const unsigned int SEGMENT = 6, BEAM = 512, MAX_TICKS = 60 * 120, CELL = 10;
+    struct Candidate {
+        std::vector<unsigned char> Inputs;
+        Snapshot State;
+        float Distance;
+    };
+    game.Start(level);
+    std::vector<Candidate> beam(1);
+    game.Save(beam[0].State);
+    beam[0].Distance = game.GoalDistance();
+    std::set<std::tuple<int, int, int, int, bool, unsigned int>> visited;
+    for (unsigned int ticks = 0; ticks < MAX_TICKS && !beam.empty(); ticks += SEGMENT)
+    {
+        std::vector<Candidate> next;
+        if (!explore)
+            visited.clear();
+        for (const Candidate &candidate : beam)
+            for (unsigned char input : { INPUT_NONE, INPUT_LEFT, INPUT_RIGHT })
+            {
+                game.Restore(level, candidate.State);
+                unsigned int deaths = game.World.deathCount;
+                Candidate extended;
+                extended.Inputs = candidate.Inputs;
+                bool alive = true;
+                for (unsigned int i = 0; i < SEGMENT && alive; ++i)
+                {
+                    game.Tick(input);
+                    extended.Inputs.push_back(input);
+                    if (game.Reached(level))
+                    {
+                        script = extended.Inputs;
+                        return true;
+                    }
+                    alive = game.World.deathCount == deaths;
+                }
+                if (!alive)
+                    continue;
+                const GameObject *ball = game.World.GetPlayer();
+                unsigned int broken = 0;
+                for (const GameObject &block : game.World.CurrentLevel.Blocks)
+                    broken += block.Destroyed ? 1 : 0;
+                std::tuple<int, int, int, int, bool, unsigned int> state(int(ball->Position.x) / CELL, int(ball->Position.y) / CELL, PLAYER_SPEED_Y > 0.0f,
+                                                                         int(std::lround(PLAYER_SPEED_X / 100.0f)), ball->isDirectional, broken);
+                if (!visited.insert(state).second)
+                    continue;
+                extended.Distance = game.GoalDistance();
+                game.Save(extended.State);
+                next.push_back(std::move(extended));
+            }
+        std::sort(next.begin(), next.end(), [](const Candidate &a, const Candidate &b) { return a.Distance < b.Distance; });
+        if (next.size() > BEAM)
+            next.resize(BEAM);
+        beam = std::move(next);
+    }
+    return false;
+}
+
+static std::map<unsigned int, LevelResult> readBaseline(const std::string &file)
+{
+    std::map<unsigned int, LevelResult> baseline;
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        LevelResult result;
+        if (fields >> result.Level >> result.Ticks >> result.TicksPerSecond >> result.WorstTick >> result.Allocations)
+        {
+            // the state hash column is optional (older baselines)
+            std::string hash;
+            if (fields >> hash)
+                result.StateHash = std::strtoull(hash.c_str(), nullptr, 16);
+            result.Reached = true;
+            baseline[result.Level] = result;
+        }
+    }
+    return baseline;
+}
+
+static bool writeBaseline(const std::string &file, const std::vector<LevelResult> &results)
+{
+    std::ofstream stream(file);
+    stream << "# playthrough_bench baseline: level ticks ticks_per_second worst_tick_us allocations state_hash\n";
+    for (const LevelResult &result : results)
+    {
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.StateHash));
+        stream << result.Level << ' ' << result.Ticks << ' ' << result.TicksPerSecond << ' ' << result.WorstTick << ' ' << result.Allocations << ' ' << hash << '\n';
+    }
+    return bool(stream);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int runs = 10, onlyLevel = 0;
+    double threshold = 0.25;
+    bool solveMissing = false, fixedPhysics = false, strictTiming = false;
+    std::string baselineOut, baselineIn;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+            runs = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--level" && i + 1 < argc)
+            onlyLevel = std::atoi(argv[++i]);
+        else if (arg == "--threshold" && i + 1 < argc)
+            threshold = std::atof(argv[++i]);
+        else if (arg == "--write-baseline" && i + 1 < argc)
+            baselineOut = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc)
+            baselineIn = argv[++i];
+        else if (arg == "--solve")
+            solveMissing = true;
+        else if (arg == "--fixed-physics")
+            fixedPhysics = true;
+        else if (arg == "--strict-timing")
+            strictTiming = true;
+    }
+
+    Playthrough game;
+    if (fixedPhysics)
+    {
+        game.World.EnableFixedPhysics();
+        fixedScripts = true;
+    }
+    game.Load();
+    unsigned int levels = game.World.maxLevel + 1;
+    int failures = 0;
+
+    std::vector<std::vector<unsigned char>> scripts(levels + 1);
+    for (unsigned int level = 1; level <= levels; ++level)
+    {
+        if (onlyLevel && level != onlyLevel)
+            continue;
+        bool loaded = loadScript(scriptFile(level), scripts[level]);
+        if (solveMissing && (!loaded || !play(game, level, scripts[level]).Reached))
+        {
+            std::vector<unsigned char> found;
+            if ((solve(game, level, false, found) || solve(game, level, true, found)) && writeScript(scriptFile(level), level, found))
+            {
+                std::cout << "Solved level " << level << " in " << found.size() << " ticks, wrote " << scriptFile(level) << std::endl;
+                scripts[level] = found;
+            }
+            else
+                std::cout << "ERROR::PLAYTHROUGH: No script found for level " << level << std::endl;
+        }
+    }
+
+    // best of runs (the level streamer and the mixer make the allocation count vary a little too)
+    std::vector<LevelResult> results;
+    for (unsigned int run = 0; run < runs; ++run)
+        for (unsigned int level = 1, index = 0; level <= levels; ++level)
+        {
+            if ((onlyLevel && level != onlyLevel) || scripts[level].empty())
+                continue;
+            LevelResult result = play(game, level, scripts[level]);
+            if (run == 0)
+                results.push_back(result);
+            else
+            {
+                LevelResult &best = results[index];
+                best.TicksPerSecond = std::max(best.TicksPerSecond, result.TicksPerSecond);
+                best.WorstTick = std::min(best.WorstTick, result.WorstTick);
+                best.Allocations = std::min(best.Allocations, result.Allocations);
+            }
+            ++index;
+        }
+
+    std::printf("%-6s %8s %7s %14s %14s %12s  %s\n", "level", "ticks", "deaths", "ticks/s", "worst tick us", "allocations", "goal");
+    // --compare gates every level the game has, a missing script is a failure there
+    for (unsigned int level = 1; level <= levels; ++level)
+        if ((!onlyLevel || level == onlyLevel) && scripts[level].empty())
+        {
+            if (baselineIn.empty())
+                std::cout << "WARNING::PLAYTHROUGH: No script " << scriptFile(level) << ", level skipped" << std::endl;
+            else
+            {
+                std::cout << "ERROR::PLAYTHROUGH: No script " << scriptFile(level) << " for level " << level << std::endl;
+                ++failures;
+            }
+        }
+    for (const LevelResult &result : results)
+    {
+        std::printf("%-6u %8u %7u %14.0f %14.1f %12llu  %s\n", result.Level, result.Ticks, result.Deaths, result.TicksPerSecond,
+                    result.WorstTick, static_cast<unsigned long long>(result.Allocations), result.Reached ? "reached" : "NOT REACHED");
+        if (!result.Reached)
+        {
+            std::cout << "ERROR::PLAYTHROUGH: Level " << result.Level << " script no longer reaches the goal" << std::endl;
+            ++failures;
+        }
+    }
+
+    if (!baselineIn.empty())
+    {
+        std::map<unsigned int, LevelResult> baseline = readBaseline(baselineIn);
+        if (baseline.empty())
+        {
+            std::cout << "ERROR::PLAYTHROUGH: Could not read baseline " << baselineIn << std::endl;
+            ++failures;
+        }
+        for (const auto &entry : baseline)
+            if ((!onlyLevel || entry.first == onlyLevel) && entry.first > levels)
+            {
+                std::cout << "ERROR::PLAYTHROUGH: Level " << entry.first << " is in the baseline but not in the game" << std::endl;
+                ++failures;
+            }
+        unsigned int identical = 0;
+        for (const LevelResult &result : results)
+        {
+            auto found = baseline.find(result.Level);
+            // fixed point is gated on the hash, a level the baseline does not cover would pass unchecked
+            if (fixedPhysics && (found == baseline.end() || !found->second.StateHash))
+            {
+                std::cout << "ERROR::PLAYTHROUGH: Level " << result.Level << " has no state hash in " << baselineIn << std::endl;
+                ++failures;
+                continue;
+            }
+            if (found == baseline.end())
+                continue;
+            const LevelResult &base = found->second;
+            if (result.Ticks != base.Ticks)
+                std::cout << "Level " << result.Level << " took " << result.Ticks << " ticks instead of " << base.Ticks << " (gameplay changed)" << std::endl;
+            // fixed point must replay bit for bit on every compiler and CPU, float only on the same build
+            if (base.StateHash && result.StateHash != base.StateHash)
+            {
+                if (fixedPhysics)
+                {
+                    std::printf("ERROR::PLAYTHROUGH: Level %u replay is not bit-identical (state hash %016llx, baseline %016llx)\n", result.Level,
+                                static_cast<unsigned long long>(result.StateHash), static_cast<unsigned long long>(base.StateHash));
+                    ++failures;
+                }
+                else
+                    std::cout << "Level " << result.Level << " passed through different states than the baseline (float physics)" << std::endl;
+            }
+            else if (base.StateHash)
+                ++identical;
+            // timings depend on the machine, they only fail the run against a baseline from this one
+            const char *timing = strictTiming ? "ERROR" : "WARNING";
+            if (result.TicksPerSecond < base.TicksPerSecond * (1.0 - threshold))
+            {
+                std::printf("%s::PLAYTHROUGH: Level %u runs %.0f ticks/s, baseline %.0f\n", timing, result.Level, result.TicksPerSecond, base.TicksPerSecond);
+                if (strictTiming)
+                    ++failures;
+            }
+            if (result.WorstTick > base.WorstTick * (1.0 + threshold) && result.WorstTick - base.WorstTick > 100.0)
+            {
+                std::printf("%s::PLAYTHROUGH: Level %u worst tick %.1f us, baseline %.1f us\n", timing, result.Level, result.WorstTick, base.WorstTick);
+                if (strictTiming)
+                    ++failures;
+            }
+            if (result.Allocations > base.Allocations)
+            {
+                std::printf("ERROR::PLAYTHROUGH: Level %u allocates %llu times, baseline %llu\n", result.Level,
+                            static_cast<unsigned long long>(result.Allocations), static_cast<unsigned long long>(base.Allocations));
+                ++failures;
+            }
+        }
+        if (fixedPhysics)
+            std::cout << identical << " of " << results.size() << " levels replayed bit-identical to the baseline" << std::endl;
+    }
+    if (!baselineOut.empty() && !writeBaseline(baselineOut, results))
+    {
+        std::cout << "ERROR::PLAYTHROUGH: Could not write " << baselineOut << std::endl;
+        ++failures;
+    }
+    return failures ? 1 : 0;
+}
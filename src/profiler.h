@@ -0,0 +1,185 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "tracer.h"
+#include "alloc_tracker.h"
+
+// Profiler adds up the time spent in named scopes of the main thread for
+// every frame and keeps the last HISTORY frames in a ring, from which the
+// overlay takes averages and percentiles and WriteCSV dumps one row per
+// frame. Scopes are registered once (a static in PROFILE_SCOPE) and then
+// recorded by index, so a timed scope costs two clock reads and an add.
+// Scopes entered on other threads are ignored.
+class Profiler
+{
+public:
+    static constexpr unsigned int MAX_SCOPES = 32;
+    static constexpr unsigned int HISTORY = 512; // frames, about 8.5 s at 60 fps
+
+    struct ScopeStats {
+        std::string Name;
+        double Average = 0.0, P50 = 0.0, P99 = 0.0, Max = 0.0; // milliseconds
+    };
+
+    static Profiler &Main()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // returns the index of a scope name (scope 0, "total", is the whole frame)
+    unsigned int Register(const char *name)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (unsigned int i = 0; i < this->scopeCount; ++i)
+            if (std::strcmp(this->names[i], name) == 0)
+                return i;
+        if (this->scopeCount == MAX_SCOPES)
+            return MAX_SCOPES; // dropped
+        this->names[this->scopeCount] = name;
+        return this->scopeCount++;
+    }
+    // called by the main loop around each frame
+    void BeginFrame()
+    {
+        this->mainThread = std::this_thread::get_id();
+        std::fill(this->current, this->current + MAX_SCOPES, 0);
+        this->frameStart = std::chrono::steady_clock::now();
+    }
+    void EndFrame()
+    {
+        this->current[0] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->frameStart).count();
+        std::copy(this->current, this->current + MAX_SCOPES, this->history[this->frames % HISTORY]);
+        ++this->frames;
+    }
+    void Add(unsigned int scope, int64_t nanoseconds)
+    {
+        if (scope < MAX_SCOPES && std::this_thread::get_id() == this->mainThread)
+            this->current[scope] += nanoseconds;
+    }
+    uint64_t Frames() const { return this->frames; }
+    unsigned int ScopeCount() const { return this->scopeCount; }
+    const char *ScopeName(unsigned int scope) const { return scope < this->scopeCount ? this->names[scope] : "dropped"; }
+    // the innermost profiled scope of the calling thread, 0 outside every scope
+    static unsigned int &CurrentScope()
+    {
+        thread_local unsigned int scope = 0;
+        return scope;
+    }
+
+    // statistics of every scope over the recorded frames, the frame first
+    std::vector<ScopeStats> Summary() const
+    {
+        std::vector<ScopeStats> stats;
+        unsigned int count = unsigned(std::min<uint64_t>(this->frames, HISTORY));
+        if (count == 0)
+            return stats;
+        std::vector<int64_t> times(count);
+        for (unsigned int scope = 0; scope < this->scopeCount; ++scope)
+        {
+            double total = 0.0;
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                times[i] = this->history[i][scope];
+                total += double(times[i]);
+            }
+            std::sort(times.begin(), times.end());
+            ScopeStats scopeStats;
+            scopeStats.Name = this->names[scope];
+            scopeStats.Average = total / count * 1e-6;
+            scopeStats.P50 = times[count / 2] * 1e-6;
+            scopeStats.P99 = times[std::min(count - 1, count * 99 / 100)] * 1e-6;
+            scopeStats.Max = times[count - 1] * 1e-6;
+            stats.push_back(scopeStats);
+        }
+        return stats;
+    }
+    // writes the recorded frames, oldest first, one column per scope in milliseconds
+    bool WriteCSV(const std::string &path) const
+    {
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        std::fprintf(file, "frame");
+        for (unsigned int scope = 0; scope < this->scopeCount; ++scope)
+            std::fprintf(file, ",%s", this->names[scope]);
+        std::fprintf(file, "\n");
+        uint64_t first = this->frames > HISTORY ? this->frames - HISTORY : 0;
+        for (uint64_t frame = first; frame < this->frames; ++frame)
+        {
+            std::fprintf(file, "%llu", static_cast<unsigned long long>(frame));
+            for (unsigned int scope = 0; scope < this->scopeCount; ++scope)
+                std::fprintf(file, ",%.4f", this->history[frame % HISTORY][scope] * 1e-6);
+            std::fprintf(file, "\n");
+        }
+        return std::fclose(file) == 0;
+    }
+
+private:
+    Profiler()
+    {
+        this->names[0] = "total";
+        this->scopeCount = 1;
+    }
+
+    std::mutex mutex; // guards registration only
+    const char *names[MAX_SCOPES] = {};
+    unsigned int scopeCount = 0;
+    int64_t current[MAX_SCOPES] = {};        // nanoseconds per scope in this frame
+    int64_t history[HISTORY][MAX_SCOPES] = {};
+    uint64_t frames = 0;
+    std::chrono::steady_clock::time_point frameStart;
+    std::thread::id mainThread;
+};
+
+// adds the time until the end of the enclosing block to a profiler scope
+class ProfileScope
+{
+public:
+    explicit ProfileScope(unsigned int scope) : scope(scope), outer(Profiler::CurrentScope()), start(std::chrono::steady_clock::now())
+    {
+        Profiler::CurrentScope() = scope;
+    }
+    ~ProfileScope()
+    {
+        Profiler::Main().Add(this->scope, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start).count());
+        Profiler::CurrentScope() = this->outer;
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope &operator=(const ProfileScope&) = delete;
+
+private:
+    unsigned int scope, outer;
+    std::chrono::steady_clock::time_point start;
+};
+
+// the markers compile to nothing when BOUNCYBALL_NO_PROFILER is defined,
+// profiled scopes are also trace events while the tracer is enabled and tag
+// the allocations made inside them (see AllocTracker)
+#ifndef BOUNCYBALL_NO_PROFILER
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE_SCOPE(name) \
+    static const unsigned int PROFILE_JOIN(profileScopeId, __LINE__) = Profiler::Main().Register(name); \
+    ProfileScope PROFILE_JOIN(profileScope, __LINE__)(PROFILE_JOIN(profileScopeId, __LINE__)); \
+    TraceScope PROFILE_JOIN(traceScope, __LINE__)(name); \
+    ALLOC_SCOPE(name)
+#define PROFILE_FRAME_BEGIN() Profiler::Main().BeginFrame()
+#define PROFILE_FRAME_END() Profiler::Main().EndFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_FRAME_END()
+#endif
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef RESOURCE_HANDLE_H
+#define RESOURCE_HANDLE_H
+
+#include <cstdint>
+
+
+// Interned resource handles: an index into the ResourceManager registry,
+// resolved once from a name and then used instead of string lookups.
+// Index 0 is the null resource (no GL object, draws nothing).
+struct TextureHandle {
+    uint32_t Index = 0;
+
+    bool IsValid() const { return this->Index != 0; }
+    bool operator==(const TextureHandle &other) const { return this->Index == other.Index; }
+    bool operator!=(const TextureHandle &other) const { return this->Index != other.Index; }
+};
+
+struct ShaderHandle {
+    uint32_t Index = 0;
+
+    bool IsValid() const { return this->Index != 0; }
+    bool operator==(const ShaderHandle &other) const { return this->Index == other.Index; }
+    bool operator!=(const ShaderHandle &other) const { return this->Index != other.Index; }
+};
+
+#endif
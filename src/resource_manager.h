@@ -2,7 +2,14 @@
 #define RESOURCE_MANAGER_H
 
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -11,106 +18,430 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "resource_handle.h"
+#include "asset_pack.h"
+#include "texture_cache.h"
+#include "bc_codec.h"
+#include "startup_report.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-// resource storage
-static std::map<std::string, Shader>    Shaders;
-static std::map<std::string, Texture2D> Textures;
+// decoded pixels of a single texture, waiting to be uploaded on the GL thread.
+// Pixels points either into Decoded (fresh stb_image output), into the
+// Cached mapping of a texture cache entry or into an imported .bbtx whose
+// mip chain is listed in Levels (Levels[0] == Pixels).
+struct TextureImage {
+    int Width = 0, Height = 0, Channels = 0;
+    const unsigned char *Pixels = nullptr;
+    std::vector<const unsigned char*> Levels;
+    std::vector<unsigned int> LevelSizes;
+    unsigned int Format = TEXTURE_FORMAT_RAW; // raw pixels or BC1/BC3 blocks
+    bool Premultiplied = false;
+    unsigned char *Decoded = nullptr; // allocated by stb_image
+    MappedFile Cached;
+
+    TextureImage() { }
+    ~TextureImage() { if (this->Decoded) stbi_image_free(this->Decoded); }
+    TextureImage(const TextureImage&) = delete;
+    TextureImage &operator=(const TextureImage&) = delete;
+    TextureImage(TextureImage &&other) noexcept { *this = std::move(other); }
+    TextureImage &operator=(TextureImage &&other) noexcept
+    {
+        std::swap(this->Width, other.Width);
+        std::swap(this->Height, other.Height);
+        std::swap(this->Channels, other.Channels);
+        std::swap(this->Pixels, other.Pixels);
+        std::swap(this->Levels, other.Levels);
+        std::swap(this->LevelSizes, other.LevelSizes);
+        std::swap(this->Format, other.Format);
+        std::swap(this->Premultiplied, other.Premultiplied);
+        std::swap(this->Decoded, other.Decoded);
+        std::swap(this->Cached, other.Cached);
+        return *this;
+    }
+};
+
+// one texture of a load list (Game::Init decodes each on a worker and uploads it on the GL thread)
+struct TextureRequest {
+    const char *File;
+    bool Alpha;
+    std::string Name;
+};
+
+// a registered resource: the GL object owner plus its interned name
+template <typename T>
+struct ResourceSlot {
+    T Resource;
+    std::string Name;
+    std::vector<std::string> Sources; // files it was built from (for hot reload)
+    bool Alpha = false;               // textures: loaded with an alpha channel
+};
+
+// resource slots indexed by handle. Slots live in fixed chunks behind a
+// chunk table that is never reallocated, and a new slot is published by
+// the count only once it is built, so lookups (every draw, on the GL
+// thread) need no lock while a level load interns a name on a worker, and
+// references returned by GetTexture/GetShader stay valid while slots are added
+template <typename T>
+class SlotTable
+{
+public:
+    static constexpr uint32_t CHUNK = 64;
+    static constexpr uint32_t MAX_SLOTS = CHUNK * 1024;
+
+    uint32_t size() const { return this->count.load(std::memory_order_acquire); }
+    ResourceSlot<T> &operator[](uint32_t index) { return this->chunks[index / CHUNK][index % CHUNK]; }
+    // adds a slot named name, false when the table is full; writers hold RegistryMutex
+    bool add(const std::string &name)
+    {
+        uint32_t index = this->count.load(std::memory_order_relaxed);
+        if (index == MAX_SLOTS)
+            return false;
+        if (index % CHUNK == 0)
+            this->chunks[index / CHUNK].reset(new ResourceSlot<T>[CHUNK]);
+        (*this)[index].Name = name;
+        this->count.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::unique_ptr<ResourceSlot<T>[]> chunks[MAX_SLOTS / CHUNK];
+    std::atomic<uint32_t> count{ 0 };
+};
+static SlotTable<Shader>    ShaderSlots;
+static SlotTable<Texture2D> TextureSlots;
+static std::unordered_map<std::string, uint32_t> ShaderNames;
+static std::unordered_map<std::string, uint32_t> TextureNames;
+static std::mutex                       RegistryMutex; // guards interning (adding slots and names), level loads resolve names on workers
+static std::unordered_set<std::string>  LooseFiles;    // changed at runtime, read from disk instead of pack/import
+static std::mutex                       LooseMutex;
+static AssetPack                        Pack;
 
 // A static singleton ResourceManager class that hosts several
 // functions to load Textures and Shaders. Each loaded texture
-// and/or shader is also stored for future reference by string
-// handles. All functions and resources are static and no 
-// public constructor is defined.
+// and/or shader is stored in a registry slot and referenced by an
+// interned handle; names are only resolved once (TextureId/ShaderId).
+// Slots own their GL objects until Clear(); the game loads every shader
+// and texture once at startup and uses them for its whole run, so handles
+// are plain indices and are not counted.
+// All functions and resources are static and no public constructor
+// is defined.
 class ResourceManager
 {
 public:
     
     // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
-    static Shader LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
+    static ShaderHandle LoadShader(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile, std::string name)
+    {
+        STARTUP_PHASE("shader", &name);
+        ShaderHandle handle = ShaderId(name);
+        ResourceSlot<Shader> &slot = ShaderSlots[handle.Index];
+        slot.Resource = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
+        slot.Sources = { vShaderFile, fShaderFile };
+        if (gShaderFile != nullptr)
+            slot.Sources.push_back(gShaderFile);
+        return handle;
+    }
+    // resolves (interning if needed) the handle of a shader name
+    static ShaderHandle ShaderId(const std::string &name)
     {
-        Shaders[name] = loadShaderFromFile(vShaderFile, fShaderFile, gShaderFile);
-        return Shaders[name];
+        return ShaderHandle{ intern(ShaderSlots, ShaderNames, name) };
     }
     // retrieves a stored shader
-    static Shader GetShader(std::string name)
+    static Shader &GetShader(ShaderHandle handle)
+    {
+        return ShaderSlots[handle.Index < ShaderSlots.size() ? handle.Index : 0].Resource;
+    }
+    static Shader &GetShader(const std::string &name)
     {
-        return Shaders[name];
+        return GetShader(ShaderId(name));
     }
     // loads (and generates) a texture from file
-    static Texture2D LoadTexture(const char *file, bool alpha, std::string name)
+    static TextureHandle LoadTexture(const char *file, bool alpha, std::string name)
     {
-        Textures[name] = loadTextureFromFile(file, alpha);
-        return Textures[name];
+        TextureHandle handle = TextureId(name);
+        ResourceSlot<Texture2D> &slot = TextureSlots[handle.Index];
+        slot.Resource = loadTextureFromFile(file, alpha);
+        slot.Sources = { file };
+        slot.Alpha = alpha;
+        return handle;
+    }
+    // resolves (interning if needed) the handle of a texture name; an unknown
+    // name gets an empty slot that draws nothing until the texture is loaded
+    static TextureHandle TextureId(const std::string &name)
+    {
+        return TextureHandle{ intern(TextureSlots, TextureNames, name) };
     }
-
     // retrieves a stored texture
-    static Texture2D GetTexture(std::string name)
+    static Texture2D &GetTexture(TextureHandle handle)
+    {
+        return TextureSlots[handle.Index < TextureSlots.size() ? handle.Index : 0].Resource;
+    }
+    static Texture2D &GetTexture(const std::string &name)
+    {
+        return GetTexture(TextureId(name));
+    }
+
+    // decodes a texture into memory (imported .bbtx, cache or source image), safe to call from worker threads
+    static TextureImage DecodeTexture(const char *file)
+    {
+        return decodeTexture(file);
+    }
+    // creates texture name from a decoded image, must run on the GL thread
+    static TextureHandle UploadTexture(const TextureImage &image, const char *file, bool alpha, const std::string &name)
+    {
+        TextureHandle handle = TextureId(name);
+        ResourceSlot<Texture2D> &slot = TextureSlots[handle.Index];
+        slot.Resource = uploadTexture(image, file, alpha);
+        slot.Sources = { file };
+        slot.Alpha = alpha;
+        return handle;
+    }
+
+    // hot reload support: marks a file edited on disk, from now on it is read
+    // from disk instead of the asset pack or its offline import
+    static void PreferLooseFile(const std::string &file)
+    {
+        std::lock_guard<std::mutex> lock(LooseMutex);
+        LooseFiles.insert(file);
+    }
+    // shaders/textures built from file
+    static std::vector<ShaderHandle> ShadersUsing(const std::string &file)
+    {
+        std::vector<ShaderHandle> handles;
+        for (uint32_t i = 1; i < ShaderSlots.size(); ++i)
+            if (std::find(ShaderSlots[i].Sources.begin(), ShaderSlots[i].Sources.end(), file) != ShaderSlots[i].Sources.end())
+                handles.push_back(ShaderHandle{ i });
+        return handles;
+    }
+    static std::vector<TextureHandle> TexturesUsing(const std::string &file)
+    {
+        std::vector<TextureHandle> handles;
+        for (uint32_t i = 1; i < TextureSlots.size(); ++i)
+            if (std::find(TextureSlots[i].Sources.begin(), TextureSlots[i].Sources.end(), file) != TextureSlots[i].Sources.end())
+                handles.push_back(TextureHandle{ i });
+        return handles;
+    }
+    // recompiles and relinks a shader from its files, keeping its uniform values;
+    // on a compile or link error the previous program stays in use
+    static bool ReloadShader(ShaderHandle handle)
+    {
+        ResourceSlot<Shader> &slot = ShaderSlots[handle.Index];
+        if (handle.Index == 0 || slot.Sources.size() < 2)
+            return false;
+        bool compiled = false;
+        Shader shader = loadShaderFromFile(slot.Sources[0].c_str(), slot.Sources[1].c_str(),
+                                           slot.Sources.size() > 2 ? slot.Sources[2].c_str() : nullptr, &compiled);
+        if (!compiled)
+        {
+            std::cout << "ERROR::SHADER: Reload of '" << slot.Name << "' failed, keeping the previous program" << std::endl;
+            return false;
+        }
+        shader.CopyUniforms(slot.Resource);
+        slot.Resource = std::move(shader);
+        return true;
+    }
+    // replaces the GL texture of handle with a fresh decode of its file (see DecodeTexture)
+    static bool ReloadTexture(TextureHandle handle, const TextureImage &image)
+    {
+        ResourceSlot<Texture2D> &slot = TextureSlots[handle.Index];
+        if (handle.Index == 0 || slot.Sources.empty() || !image.Pixels)
+            return false;
+        slot.Resource = uploadTexture(image, slot.Sources[0].c_str(), slot.Alpha);
+        return true;
+    }
+
+    // maps an asset pack, all later loads look in the pack before falling back to loose files
+    static bool OpenPack(const char *file)
     {
-        return Textures[name];
+        if (!Pack.Open(file))
+            return false;
+        std::cout << "Loaded asset pack " << file << " (" << Pack.Count() << " entries)" << std::endl;
+        return true;
+    }
+    // retrieves the raw bytes of an asset, zero-copy when it lives in the pack
+    static AssetData ReadAsset(const char *file)
+    {
+        if (isLooseFile(file))
+            return AssetData::FromFile(file);
+        AssetData asset = Pack.Find(file);
+        if (!asset.IsValid())
+            asset = AssetData::FromFile(file);
+        return asset;
+    }
+    // like ReadAsset but never copies: a view into the pack, or the loose file mapped into mapping
+    static AssetData MapAsset(const char *file, MappedFile &mapping)
+    {
+        AssetData asset;
+        if (!isLooseFile(file))
+            asset = Pack.Find(file);
+        if (!asset.IsValid() && mapping.Open(file))
+        {
+            asset.Data = mapping.Data();
+            asset.Size = mapping.Size();
+        }
+        return asset;
     }
     // properly de-allocates all loaded resources
     static void Clear()
     {
-        // (properly) delete all shaders	
-        for (auto iter : Shaders)
-            glDeleteProgram(iter.second.ID);
-        // (properly) delete all textures
-        for (auto iter : Textures)
-            glDeleteTextures(1, &iter.second.ID);
+        // (properly) delete all shaders and textures, handles stay interned but resolve to nothing
+        for (uint32_t i = 0; i < ShaderSlots.size(); ++i)
+            ShaderSlots[i].Resource = Shader();
+        for (uint32_t i = 0; i < TextureSlots.size(); ++i)
+            TextureSlots[i].Resource = Texture2D();
     }
 
 private:
     // private constructor, that is we do not want any actual resource manager objects. Its members and functions should be publicly available (static).
     ResourceManager() { }
-    // loads and generates a shader from file
-    static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr)
+    // returns the slot index of name, creating an empty slot for new names (slot 0 is the null resource)
+    template <typename T>
+    static uint32_t intern(SlotTable<T> &slots, std::unordered_map<std::string, uint32_t> &names, const std::string &name)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        try
+        std::lock_guard<std::mutex> lock(RegistryMutex);
+        if (slots.size() == 0)
+            slots.add("");
+        auto found = names.find(name);
+        if (found != names.end())
+            return found->second;
+        uint32_t index = slots.size();
+        if (!slots.add(name))
         {
-            // open files
-            std::ifstream vertexShaderFile(vShaderFile);
-            std::ifstream fragmentShaderFile(fShaderFile);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vertexShaderFile.rdbuf();
-            fShaderStream << fragmentShaderFile.rdbuf();
-            // close file handlers
-            vertexShaderFile.close();
-            fragmentShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            // if geometry shader path is present, also load a geometry shader
-            if (gShaderFile != nullptr)
-            {
-                std::ifstream geometryShaderFile(gShaderFile);
-                std::stringstream gShaderStream;
-                gShaderStream << geometryShaderFile.rdbuf();
-                geometryShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
+            std::cout << "ERROR::RESOURCE: More than " << SlotTable<T>::MAX_SLOTS << " resources, '" << name << "' draws nothing" << std::endl;
+            return 0;
         }
-        catch (std::exception e)
-        {
+        names.emplace(name, index);
+        return index;
+    }
+    static bool isLooseFile(const char *file)
+    {
+        std::lock_guard<std::mutex> lock(LooseMutex);
+        return !LooseFiles.empty() && LooseFiles.count(file) != 0;
+    }
+    // loads and generates a shader from file
+    static Shader loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile = nullptr, bool *compiled = nullptr)
+    {
+        // 1. retrieve the vertex/fragment source code from the pack or filePath
+        std::string vertexCode = ReadAsset(vShaderFile).String();
+        std::string fragmentCode = ReadAsset(fShaderFile).String();
+        std::string geometryCode;
+        // if geometry shader path is present, also load a geometry shader
+        if (gShaderFile != nullptr)
+            geometryCode = ReadAsset(gShaderFile).String();
+        if (vertexCode.empty() || fragmentCode.empty())
             std::cout << "ERROR::SHADER: Failed to read shader files" << std::endl;
-        }
         const char *vShaderCode = vertexCode.c_str();
         const char *fShaderCode = fragmentCode.c_str();
         const char *gShaderCode = geometryCode.c_str();
         // 2. now create shader object from source code
         Shader shader;
-        shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+        bool success = shader.Compile(vShaderCode, fShaderCode, gShaderFile != nullptr ? gShaderCode : nullptr);
+        if (compiled)
+            *compiled = success && !vertexCode.empty() && !fragmentCode.empty();
         return shader;
     }
     // loads a single texture from file
     static Texture2D loadTextureFromFile(const char *file, bool alpha)
+    {
+        TextureImage image = decodeTexture(file);
+        return uploadTexture(image, file, alpha);
+    }
+    // decodes an image into memory (or maps its cached decode), safe to call from worker threads
+    static TextureImage decodeTexture(const char *file)
+    {
+        TextureImage image;
+        AssetData asset = ReadAsset(file);
+        // without the source there is nothing to check the import against
+        uint64_t sourceHash = asset.IsValid() ? HashContent(asset.Data, asset.Size) : 0;
+        // prefer the offline import (resized, mipmapped) when the asset build produced one from the current source
+        if (loadImportedTexture(file, sourceHash, image))
+            return image;
+        if (!asset.IsValid())
+            return image;
+        // warm start: the cache entry matches the current source bytes
+        TextureFileHeader header;
+        if (TextureCache::Load(file, sourceHash, image.Cached, header, image.Pixels))
+        {
+            image.Width = header.Width;
+            image.Height = header.Height;
+            image.Channels = header.Channels;
+            return image;
+        }
+        // cold start or changed source: decode and refresh the cache
+        image.Decoded = stbi_load_from_memory(asset.Data, static_cast<int>(asset.Size), &image.Width, &image.Height, &image.Channels, 0);
+        image.Pixels = image.Decoded;
+        if (image.Decoded)
+            TextureCache::Store(file, sourceHash, image.Width, image.Height, image.Channels, image.Decoded);
+        return image;
+    }
+    // path of the offline import of a texture: resources/textures/ball.png -> resources/textures/imported/ball.bbtx
+    static std::string importedTexturePath(const char *file)
+    {
+        std::string path = file;
+        size_t slash = path.find_last_of("/\\");
+        std::string folder = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+        std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        return folder + "imported/" + name.substr(0, name.find_last_of('.')) + ".bbtx";
+    }
+    // maps the imported .bbtx of a texture from the pack or disk, returns false if there is none
+    // or it was built from another version of the source (sourceHash, 0 = do not check)
+    static bool loadImportedTexture(const char *file, uint64_t sourceHash, TextureImage &image)
+    {
+        // an edited source is newer than its import
+        if (isLooseFile(file))
+            return false;
+        std::string path = importedTexturePath(file);
+        AssetData packed = Pack.Find(path);
+        const unsigned char *data = packed.Data;
+        size_t size = packed.Size;
+        if (!packed.IsValid())
+        {
+            if (!image.Cached.Open(path.c_str()))
+                return false;
+            data = image.Cached.Data();
+            size = image.Cached.Size();
+        }
+        TextureFileHeader header;
+        const TextureFileLevel *levels = ReadTextureFile(data, size, header);
+        if (!levels || (header.Channels != 3 && header.Channels != 4) || header.Format > TEXTURE_FORMAT_BC3)
+        {
+            std::cout << "ERROR::TEXTURE: Invalid imported texture " << path << std::endl;
+            image.Cached.Close();
+            return false;
+        }
+        if (sourceHash && header.SourceHash != sourceHash)
+        {
+            std::cout << "WARNING::TEXTURE: " << path << " was imported from an older " << file << ", loading the source (run texture_importer)" << std::endl;
+            image.Cached.Close();
+            return false;
+        }
+        for (unsigned int i = 0; i < header.LevelCount; ++i)
+        {
+            // every level must hold exactly the pixels or blocks its size implies
+            size_t expected = size_t(levels[i].Width) * levels[i].Height * header.Channels;
+            if (header.Format != TEXTURE_FORMAT_RAW)
+                expected = BCImageBytes(header.Format == TEXTURE_FORMAT_BC1 ? BC1 : BC3, levels[i].Width, levels[i].Height);
+            if (levels[i].Size != expected)
+            {
+                std::cout << "ERROR::TEXTURE: Invalid imported texture " << path << std::endl;
+                image = TextureImage();
+                return false;
+            }
+            image.Levels.push_back(data + levels[i].Offset);
+            image.LevelSizes.push_back(static_cast<unsigned int>(levels[i].Size));
+        }
+        image.Format = header.Format;
+        image.Width = header.Width;
+        image.Height = header.Height;
+        image.Channels = header.Channels;
+        image.Pixels = image.Levels[0];
+        image.Premultiplied = (header.Flags & TEXTURE_FLAG_PREMULTIPLIED) != 0;
+        return true;
+    }
+    // creates the GL texture from decoded pixels, must run on the GL thread
+    static Texture2D uploadTexture(const TextureImage &image, const char *file, bool alpha)
     {
         // create texture object
         Texture2D texture;
@@ -119,13 +450,46 @@ private:
             texture.Internal_Format = GL_RGBA;
             texture.Image_Format = GL_RGBA;
         }
-        // load image
-        int width, height, nrChannels;
-        unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
+        if (!image.Pixels)
+        {
+            std::cout << "ERROR::TEXTURE: Failed to load " << file << std::endl;
+            return texture;
+        }
+        // the data layout follows the decoded image, the requested alpha only picks the internal format
+        if (image.Channels == 4)
+            texture.Image_Format = GL_RGBA;
+        else if (image.Channels == 3)
+            texture.Image_Format = GL_RGB;
+        texture.Premultiplied = image.Premultiplied;
+        // block compressed import: upload as is, or decode on the CPU when the driver lacks S3TC
+        if (image.Format != TEXTURE_FORMAT_RAW)
+        {
+            BCFormat format = image.Format == TEXTURE_FORMAT_BC1 ? BC1 : BC3;
+            if (Texture2D::SupportsS3TC())
+            {
+                unsigned int glFormat = format == BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                texture.GenerateCompressed(image.Width, image.Height, glFormat, image.Levels, image.LevelSizes);
+                return texture;
+            }
+            std::vector<std::vector<unsigned char>> decoded(image.Levels.size());
+            std::vector<const unsigned char*> levels;
+            int width = image.Width, height = image.Height;
+            for (size_t i = 0; i < image.Levels.size(); ++i)
+            {
+                decoded[i].resize(size_t(width) * height * image.Channels);
+                BCDecodeImage(image.Levels[i], width, height, format, image.Channels, decoded[i].data());
+                levels.push_back(decoded[i].data());
+                width = width > 1 ? width / 2 : 1;
+                height = height > 1 ? height / 2 : 1;
+            }
+            texture.Generate(image.Width, image.Height, levels);
+            return texture;
+        }
         // now generate texture
-        texture.Generate(width, height, data);
-        // and finally free image data
-        stbi_image_free(data);
+        if (image.Levels.size() > 1)
+            texture.Generate(image.Width, image.Height, image.Levels);
+        else
+            texture.Generate(image.Width, image.Height, image.Pixels);
         return texture;
     }
 };
@@ -0,0 +1,214 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "input_recorder.h"
+
+
+// RewindBuffer keeps the game state of the last ticks in a fixed amount of
+// memory so play can be stepped back one tick at a time. The state is an
+// opaque byte image of a fixed size per level (Game::SaveState). Each tick
+// is stored as the XOR with the tick before it, run-length coded: runs of
+// unchanged bytes cost a varint, so the static blocks of a level cost next
+// to nothing. Every KeyframeInterval ticks, and whenever the size of the
+// state changes, the state is stored whole instead (a keyframe).
+// All memory is allocated up front, including room for states of up to
+// maxStateBytes (larger ones still work but allocate); when the byte ring
+// or the record ring is full the oldest keyframe and the deltas that
+// depend on it are dropped.
+// Capture costs one pass over the state regardless of how much history is
+// kept. Stepping back over a delta is XOR-ing it into the newest state.
+// Stepping back over a keyframe replays the previous keyframe's deltas,
+// once every KeyframeInterval ticks.
+class RewindBuffer
+{
+public:
+    RewindBuffer(size_t budgetBytes, size_t maxRecords, unsigned int keyframeInterval, size_t maxStateBytes)
+        : bytes(budgetBytes), records(maxRecords), keyframeInterval(std::max(1u, keyframeInterval))
+    {
+        this->current.reserve(maxStateBytes);
+        this->scratch.reserve(maxStateBytes * 2 + 32); // worst case of encode
+    }
+
+    // forgets all ticks (a new level)
+    void Clear()
+    {
+        this->first = this->count = 0;
+        this->writePos = 0;
+        this->sinceKeyframe = 0;
+    }
+    // stores state as the newest tick
+    void Capture(const unsigned char *state, size_t size)
+    {
+        bool keyframe = this->count == 0 || size != this->current.size() || this->sinceKeyframe + 1 >= this->keyframeInterval;
+        if (size != this->current.size())
+            this->current.assign(size, 0);
+        if (this->scratch.size() < size * 2 + 32)
+            this->scratch.resize(size * 2 + 32); // worst case of encode
+        for (;;)
+        {
+            size_t encoded = encode(this->current.data(), state, size, keyframe, this->scratch.data());
+            // making room may drop the keyframe a delta refers to, store this tick whole then
+            if (!this->makeRoom(encoded) || (!keyframe && this->count == 0))
+            {
+                if (keyframe)
+                    return; // does not fit the budget at all
+                keyframe = true;
+                continue;
+            }
+            Record &record = this->records[(this->first + this->count) % this->records.size()];
+            record.Offset = this->writePos;
+            record.Size = uint32_t(encoded);
+            record.StateSize = uint32_t(size);
+            record.Keyframe = keyframe;
+            std::memcpy(this->bytes.data() + this->writePos, this->scratch.data(), encoded);
+            this->writePos += encoded;
+            ++this->count;
+            break;
+        }
+        std::memcpy(this->current.data(), state, size);
+        this->sinceKeyframe = keyframe ? 0 : this->sinceKeyframe + 1;
+    }
+    // drops the newest tick and puts the state of the tick before it in state,
+    // false when no older tick is kept
+    bool Rewind(std::vector<unsigned char> &state)
+    {
+        if (this->count < 2)
+            return false;
+        const Record &newest = this->record(this->count - 1);
+        if (!newest.Keyframe)
+            decode(this->bytes.data() + newest.Offset, newest.Size, this->current.data(), this->current.size());
+        else
+        {
+            // rebuild the tick before from the keyframe of its group
+            size_t index = this->count - 2;
+            while (!this->record(index).Keyframe)
+                --index;
+            const Record &keyframe = this->record(index);
+            this->current.assign(keyframe.StateSize, 0);
+            for (; index < this->count - 1; ++index)
+            {
+                const Record &delta = this->record(index);
+                decode(this->bytes.data() + delta.Offset, delta.Size, this->current.data(), this->current.size());
+            }
+        }
+        this->writePos = newest.Offset;
+        --this->count;
+        // ticks since the keyframe of the new newest tick
+        this->sinceKeyframe = 0;
+        for (size_t index = this->count - 1; !this->record(index).Keyframe; --index)
+            ++this->sinceKeyframe;
+        state.assign(this->current.begin(), this->current.end());
+        return true;
+    }
+
+    // nothing captured since Clear
+    bool Empty() const { return this->count == 0; }
+    // ticks that can be stepped back to (the newest is the present)
+    size_t Ticks() const { return this->count > 0 ? this->count - 1 : 0; }
+    // bytes of the ring holding records
+    size_t Bytes() const
+    {
+        size_t used = 0;
+        for (size_t i = 0; i < this->count; ++i)
+            used += this->record(i).Size;
+        return used;
+    }
+    size_t Budget() const { return this->bytes.size(); }
+
+private:
+    struct Record {
+        size_t Offset = 0;
+        uint32_t Size = 0, StateSize = 0;
+        bool Keyframe = false;
+    };
+    std::vector<unsigned char> bytes;  // ring of encoded ticks
+    std::vector<Record> records;       // ring, records[first] is the oldest
+    size_t first = 0, count = 0, writePos = 0;
+    unsigned int keyframeInterval, sinceKeyframe = 0;
+    std::vector<unsigned char> current, scratch; // the newest state, encoder output
+
+    Record &record(size_t index) { return this->records[(this->first + index) % this->records.size()]; }
+    const Record &record(size_t index) const { return this->records[(this->first + index) % this->records.size()]; }
+
+    // drops the oldest keyframe and its deltas
+    void dropOldest()
+    {
+        do
+        {
+            this->first = (this->first + 1) % this->records.size();
+            --this->count;
+        } while (this->count > 0 && !this->record(0).Keyframe);
+    }
+    // moves writePos to size free bytes, dropping old ticks as needed, false if size exceeds the budget
+    bool makeRoom(size_t size)
+    {
+        if (size > this->bytes.size())
+            return false;
+        if (this->count == this->records.size())
+            this->dropOldest();
+        for (;;)
+        {
+            if (this->count == 0)
+            {
+                if (this->writePos + size > this->bytes.size())
+                    this->writePos = 0;
+                return true;
+            }
+            size_t oldest = this->record(0).Offset;
+            if (oldest >= this->writePos)
+            {
+                // free space runs from writePos up to the oldest record
+                if (this->writePos + size <= oldest)
+                    return true;
+                this->dropOldest();
+            }
+            else if (this->writePos + size <= this->bytes.size())
+                return true; // free space runs to the end of the ring
+            else
+                this->writePos = 0;
+        }
+    }
+    // XOR of state with previous (or with zeros for a keyframe) as (unchanged run, changed run, changed bytes) varints
+    static size_t encode(const unsigned char *previous, const unsigned char *state, size_t size, bool keyframe, unsigned char *out)
+    {
+        size_t written = 0, i = 0;
+        while (i < size)
+        {
+            size_t same = i;
+            // most of a level never changes, compare those runs a word at a time
+            if (!keyframe)
+                while (same + 8 <= size && std::memcmp(state + same, previous + same, 8) == 0)
+                    same += 8;
+            while (same < size && state[same] == (keyframe ? 0 : previous[same]))
+                ++same;
+            size_t changed = same;
+            while (changed < size && state[changed] != (keyframe ? 0 : previous[changed]))
+                ++changed;
+            written += EncodeVarint(same - i, out + written);
+            written += EncodeVarint(changed - same, out + written);
+            for (size_t j = same; j < changed; ++j)
+                out[written++] = state[j] ^ (keyframe ? 0 : previous[j]);
+            i = changed;
+        }
+        return written;
+    }
+    // XORs an encoded tick into state
+    static void decode(const unsigned char *data, size_t size, unsigned char *state, size_t stateSize)
+    {
+        size_t offset = 0, i = 0;
+        uint64_t same, changed;
+        while (offset < size && DecodeVarint(data, size, offset, same) && DecodeVarint(data, size, offset, changed))
+        {
+            i += same;
+            for (uint64_t j = 0; j < changed && i < stateSize && offset < size; ++j)
+                state[i++] ^= data[offset++];
+        }
+    }
+};
+
+#endif
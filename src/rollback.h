@@ -0,0 +1,203 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+#include "net_transport.h"
+
+
+// RollbackSession runs a deterministic two-player simulation in lockstep
+// ticks without waiting for the network. Each tick the local input is used
+// at once; the remote input, when it has not arrived yet, is predicted to
+// be the last one received. The state before every tick is saved, so when
+// the real remote input of a past tick turns out different from the
+// prediction the session loads the state of that tick and simulates up to
+// the present again with the corrected inputs (a rollback). The simulation
+// never runs more than MAX_ROLLBACK ticks past the last confirmed remote
+// input, which bounds both the snapshots kept and the ticks one rollback
+// replays; further Advance calls wait (return false) until inputs arrive.
+//
+// The simulation is three callbacks: Save and Load the whole state as
+// bytes, and Step it one tick with the inputs of player 0 and 1 (the same
+// order on both machines). Step is told when it is replaying ticks so it
+// can leave out sounds and effects that already played.
+//
+// Every datagram carries all local inputs the other side has not
+// acknowledged yet, so a lost datagram is repaired by the next one:
+//   "BBV", version, ack (u32: remote ticks received), first (u32: tick of
+//   the first input), count (u8), count input bytes
+class RollbackSession
+{
+public:
+    static constexpr unsigned int MAX_ROLLBACK = 10;   // ticks simulated ahead of the remote input
+    static constexpr unsigned int INPUT_WINDOW = 64;   // ring of inputs, > 2 * MAX_ROLLBACK + 1
+    static constexpr unsigned char PROTOCOL_VERSION = 1;
+
+    typedef std::function<void(std::vector<unsigned char>&)> SaveFunction;
+    typedef std::function<void(const std::vector<unsigned char>&)> LoadFunction;
+    typedef std::function<void(const unsigned char *inputs, uint32_t tick, bool resimulating)> StepFunction;
+
+    struct Stats {
+        uint64_t Rollbacks = 0, ResimulatedTicks = 0, WaitingCalls = 0;
+        uint64_t DatagramsSent = 0, DatagramsReceived = 0;
+        unsigned int LongestRollback = 0;           // ticks
+        double TotalRollbackMs = 0.0, WorstRollbackMs = 0.0;
+    };
+
+    RollbackSession(Transport &transport, int localPlayer, SaveFunction save, LoadFunction load, StepFunction step)
+        : transport(transport), localPlayer(localPlayer), save(save), load(load), step(step), states(MAX_ROLLBACK + 1) { }
+
+    // simulates one tick with the local input, false when waiting for the remote player
+    bool Advance(unsigned char localInput)
+    {
+        this->receive();
+        if (this->tick >= this->remoteTicks + MAX_ROLLBACK)
+        {
+            ++this->stats.WaitingCalls;
+            this->waiting = true;
+            this->sendInputs(); // the other side may be waiting for ours as well
+            return false;
+        }
+        this->waiting = false;
+        this->localInputs[this->tick % INPUT_WINDOW] = localInput;
+        this->simulate(this->tick, false);
+        ++this->tick;
+        this->sendInputs();
+        return true;
+    }
+    // takes in received inputs without simulating a new tick (e.g. after the last one), sends
+    // again what the remote side has not acknowledged
+    void Poll()
+    {
+        this->receive();
+        if (this->remoteAck < this->tick)
+            this->sendInputs();
+    }
+    // replays the last ticks (at most MAX_ROLLBACK) with the same inputs, the cost of a rollback
+    // that long in ms (for benchmarks, not counted in the stats)
+    double Resimulate(unsigned int ticks)
+    {
+        ticks = std::min({ ticks, MAX_ROLLBACK, this->tick });
+        auto start = std::chrono::steady_clock::now();
+        this->replay(this->tick - ticks);
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    uint32_t Tick() const { return this->tick; }
+    // ticks simulated with the real inputs of both players, their state cannot change any more
+    uint32_t ConfirmedTick() const { return std::min(this->tick, this->remoteTicks); }
+    bool Waiting() const { return this->waiting; }
+    int LocalPlayer() const { return this->localPlayer; }
+    const Stats &GetStats() const { return this->stats; }
+
+private:
+    Transport &transport;
+    int localPlayer;
+    SaveFunction save;
+    LoadFunction load;
+    StepFunction step;
+    std::vector<std::vector<unsigned char>> states; // state before tick t at t % states.size()
+    unsigned char localInputs[INPUT_WINDOW] = {};
+    unsigned char remoteInputs[INPUT_WINDOW] = {};
+    unsigned char predicted[INPUT_WINDOW] = {};   // the remote input each tick was simulated with
+    uint32_t tick = 0;        // next tick to simulate
+    uint32_t remoteTicks = 0; // remote inputs received (all ticks before it)
+    uint32_t remoteAck = 0;   // local inputs the remote side has received
+    bool waiting = false;
+    Stats stats;
+
+    // takes in received inputs and rolls back when a prediction was wrong
+    void receive()
+    {
+        uint32_t rollbackFrom = this->tick;
+        unsigned char datagram[Transport::MAX_DATAGRAM];
+        size_t size;
+        while ((size = this->transport.Receive(datagram, sizeof(datagram))) > 0)
+        {
+            if (size < 13 || datagram[0] != 'B' || datagram[1] != 'B' || datagram[2] != 'V' || datagram[3] != PROTOCOL_VERSION)
+                continue;
+            ++this->stats.DatagramsReceived;
+            uint32_t ack = readU32(datagram + 4), first = readU32(datagram + 8);
+            unsigned int count = std::min<size_t>(datagram[12], size - 13);
+            this->remoteAck = std::max(this->remoteAck, std::min(ack, this->tick));
+            // only the next missing tick is taken, later ones come again until acknowledged
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                uint32_t at = first + i;
+                if (at != this->remoteTicks || at >= this->tick + INPUT_WINDOW - MAX_ROLLBACK - 1)
+                    continue;
+                unsigned char input = datagram[13 + i];
+                this->remoteInputs[at % INPUT_WINDOW] = input;
+                if (at < this->tick && this->predicted[at % INPUT_WINDOW] != input)
+                    rollbackFrom = std::min(rollbackFrom, at);
+                ++this->remoteTicks;
+            }
+        }
+        if (rollbackFrom < this->tick)
+            this->rollback(rollbackFrom);
+    }
+
+    static uint32_t readU32(const unsigned char *data)
+    {
+        return uint32_t(data[0]) | uint32_t(data[1]) << 8 | uint32_t(data[2]) << 16 | uint32_t(data[3]) << 24;
+    }
+    static void writeU32(unsigned char *data, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            data[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    void simulate(uint32_t at, bool resimulating)
+    {
+        this->save(this->states[at % this->states.size()]);
+        unsigned char remote = at < this->remoteTicks ? this->remoteInputs[at % INPUT_WINDOW]
+                             : this->remoteTicks > 0 ? this->remoteInputs[(this->remoteTicks - 1) % INPUT_WINDOW] : 0;
+        this->predicted[at % INPUT_WINDOW] = remote;
+        unsigned char inputs[2];
+        inputs[this->localPlayer] = this->localInputs[at % INPUT_WINDOW];
+        inputs[1 - this->localPlayer] = remote;
+        this->step(inputs, at, resimulating);
+    }
+    // loads the state before tick from and simulates up to the present again
+    void replay(uint32_t from)
+    {
+        this->load(this->states[from % this->states.size()]);
+        for (uint32_t at = from; at < this->tick; ++at)
+            this->simulate(at, true);
+    }
+    void rollback(uint32_t from)
+    {
+        auto start = std::chrono::steady_clock::now();
+        this->replay(from);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        unsigned int ticks = this->tick - from;
+        ++this->stats.Rollbacks;
+        this->stats.ResimulatedTicks += ticks;
+        this->stats.LongestRollback = std::max(this->stats.LongestRollback, ticks);
+        this->stats.TotalRollbackMs += ms;
+        this->stats.WorstRollbackMs = std::max(this->stats.WorstRollbackMs, ms);
+    }
+    void sendInputs()
+    {
+        unsigned char datagram[13 + 255];
+        uint32_t first = std::max(this->remoteAck, this->tick > INPUT_WINDOW - 1 ? this->tick - (INPUT_WINDOW - 1) : 0u);
+        unsigned int count = this->tick - first;
+        datagram[0] = 'B';
+        datagram[1] = 'B';
+        datagram[2] = 'V';
+        datagram[3] = PROTOCOL_VERSION;
+        writeU32(datagram + 4, this->remoteTicks);
+        writeU32(datagram + 8, first);
+        datagram[12] = static_cast<unsigned char>(count);
+        for (unsigned int i = 0; i < count; ++i)
+            datagram[13 + i] = this->localInputs[(first + i) % INPUT_WINDOW];
+        if (this->transport.Send(datagram, 13 + count))
+            ++this->stats.DatagramsSent;
+    }
+};
+
+#endif
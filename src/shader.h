@@ -18,48 +18,103 @@ public:
     // state
     unsigned int ID; 
     // constructor
-    Shader() { }
+    Shader() : ID(0) { }
+    // the shader owns its program: it can be moved but not copied, and deletes the program when destroyed
+    Shader(Shader &&other) noexcept : ID(other.ID) { other.ID = 0; }
+    Shader &operator=(Shader &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (this->ID != 0)
+                glDeleteProgram(this->ID);
+            this->ID = other.ID;
+            other.ID = 0;
+        }
+        return *this;
+    }
+    Shader(const Shader&) = delete;
+    Shader &operator=(const Shader&) = delete;
+    ~Shader()
+    {
+        if (this->ID != 0)
+            glDeleteProgram(this->ID);
+    }
     // sets the current shader as active
     Shader  &Use()
     {
         glUseProgram(this->ID);
         return *this;
     }
-    // compiles the shader from given source code
-    void    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr)
+    // compiles the shader from given source code, returns false when compiling or linking failed
+    bool    Compile(const char *vertexSource, const char *fragmentSource, const char *geometrySource = nullptr)
     {
         unsigned int sVertex, sFragment, gShader;
         // vertex Shader
         sVertex = glCreateShader(GL_VERTEX_SHADER);
         glShaderSource(sVertex, 1, &vertexSource, NULL);
         glCompileShader(sVertex);
-        checkCompileErrors(sVertex, "VERTEX");
+        bool success = checkCompileErrors(sVertex, "VERTEX");
         // fragment Shader
         sFragment = glCreateShader(GL_FRAGMENT_SHADER);
         glShaderSource(sFragment, 1, &fragmentSource, NULL);
         glCompileShader(sFragment);
-        checkCompileErrors(sFragment, "FRAGMENT");
+        success &= checkCompileErrors(sFragment, "FRAGMENT");
         // if geometry shader source code is given, also compile geometry shader
         if (geometrySource != nullptr)
         {
             gShader = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(gShader, 1, &geometrySource, NULL);
             glCompileShader(gShader);
-            checkCompileErrors(gShader, "GEOMETRY");
+            success &= checkCompileErrors(gShader, "GEOMETRY");
         }
-        // shader program
+        // shader program (replacing a previously compiled one)
+        if (this->ID != 0)
+            glDeleteProgram(this->ID);
         this->ID = glCreateProgram();
         glAttachShader(this->ID, sVertex);
         glAttachShader(this->ID, sFragment);
         if (geometrySource != nullptr)
             glAttachShader(this->ID, gShader);
         glLinkProgram(this->ID);
-        checkCompileErrors(this->ID, "PROGRAM");
+        success &= checkCompileErrors(this->ID, "PROGRAM");
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(sVertex);
         glDeleteShader(sFragment);
         if (geometrySource != nullptr)
             glDeleteShader(gShader);
+        return success;
+    }
+    // copies the current values of the uniforms both programs declare from other into this
+    // program (used when a reloaded program replaces a configured one)
+    void    CopyUniforms(const Shader &other)
+    {
+        int count = 0;
+        glGetProgramiv(other.ID, GL_ACTIVE_UNIFORMS, &count);
+        glUseProgram(this->ID);
+        for (int i = 0; i < count; ++i)
+        {
+            char name[256];
+            int size = 0;
+            unsigned int type = 0;
+            glGetActiveUniform(other.ID, i, sizeof(name), nullptr, &size, &type, name);
+            int from = glGetUniformLocation(other.ID, name), to = glGetUniformLocation(this->ID, name);
+            if (from < 0 || to < 0)
+                continue;
+            float f[16];
+            int n[4];
+            switch (type)
+            {
+            case GL_FLOAT:      glGetUniformfv(other.ID, from, f); glUniform1fv(to, 1, f); break;
+            case GL_FLOAT_VEC2: glGetUniformfv(other.ID, from, f); glUniform2fv(to, 1, f); break;
+            case GL_FLOAT_VEC3: glGetUniformfv(other.ID, from, f); glUniform3fv(to, 1, f); break;
+            case GL_FLOAT_VEC4: glGetUniformfv(other.ID, from, f); glUniform4fv(to, 1, f); break;
+            case GL_FLOAT_MAT4: glGetUniformfv(other.ID, from, f); glUniformMatrix4fv(to, 1, false, f); break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D: glGetUniformiv(other.ID, from, n); glUniform1i(to, n[0]); break;
+            default: break;
+            }
+        }
     }
 
     // utility functions
@@ -121,7 +176,7 @@ public:
     
 private:
     // checks if compilation or linking failed and if so, print the error logs
-    void    checkCompileErrors(unsigned int object, std::string type)
+    bool    checkCompileErrors(unsigned int object, std::string type)
     {
         int success;
         char infoLog[1024];
@@ -147,6 +202,7 @@ private:
                     << std::endl;
             }
         }
+        return success != 0;
     }
 };
 
@@ -0,0 +1,147 @@
+#ifndef SOUND_BANK_H
+#define SOUND_BANK_H
+
+#include <chrono>
+#include <iostream>
+
+#include "audio_mixer.h"
+#include "resource_manager.h"
+#ifndef BOUNCYBALL_NO_IRRKLANG
+#include "audio_irrklang.h"
+#endif
+
+
+// sound effects of the game, indices into the bank
+enum SoundEffect {
+    SOUND_BOUNCE,
+    SOUND_BREAKABLE,
+    SOUND_DIR,
+    SOUND_GOAL,
+    SOUND_NORMAL,
+    SOUND_TRAP,
+    SOUND_FALSE_DIR,
+    SOUND_EFFECT_COUNT
+};
+
+// how an effect may be played: at most MaxVoices at once, and not retriggered
+// sooner than Cooldown seconds after its last start
+struct SoundEffectInfo {
+    const char  *File;
+    unsigned int MaxVoices;
+    float        Cooldown;
+};
+
+static const SoundEffectInfo SoundEffects[SOUND_EFFECT_COUNT] = {
+    { "resources/audio/block_bounce.mp3",    2, 0.06f }, // SOUND_BOUNCE
+    { "resources/audio/block_breakable.mp3", 3, 0.03f }, // SOUND_BREAKABLE
+    { "resources/audio/block_dir.mp3",       2, 0.08f }, // SOUND_DIR
+    { "resources/audio/block_goal.mp3",      1, 0.00f }, // SOUND_GOAL
+    { "resources/audio/block_normal.wav",    3, 0.05f }, // SOUND_NORMAL
+    { "resources/audio/block_trap.mp3",      1, 0.10f }, // SOUND_TRAP
+    { "resources/audio/false_dir.mp3",       1, 0.15f }  // SOUND_FALSE_DIR
+};
+
+// decodes a sound asset into a mixer buffer: WAV directly, other formats through irrKlang when available
+inline bool DecodeSound(const char *file, AudioBuffer &buffer)
+{
+    AssetData sound = ResourceManager::ReadAsset(file);
+    if (!sound.IsValid())
+        return false;
+    if (DecodeWav(sound.Data, sound.Size, AudioMixer::SAMPLE_RATE, buffer))
+        return true;
+#ifndef BOUNCYBALL_NO_IRRKLANG
+    return DecodeWithIrrKlang(sound.Data, sound.Size, file, buffer);
+#else
+    return false;
+#endif
+}
+
+// SoundBank decodes every effect once into PCM and plays them by enum on the
+// mixer. Each effect keeps track of its own voices: a trigger inside the
+// cooldown is dropped, and a trigger at the voice cap fades out the oldest
+// voice of that effect before starting a new one, so rapid contacts never
+// pile up voices.
+class SoundBank
+{
+public:
+    // counters for the debug output
+    unsigned int Played = 0, Throttled = 0, Stolen = 0;
+
+    SoundBank() { }
+    SoundBank(const SoundBank&) = delete;
+    SoundBank &operator=(const SoundBank&) = delete;
+
+    // decodes every effect, touches no audio device so it may run on a worker thread
+    void Decode()
+    {
+        for (int i = 0; i < SOUND_EFFECT_COUNT; ++i)
+            if (!DecodeSound(SoundEffects[i].File, this->effects[i].Buffer))
+                std::cout << "ERROR::SOUND: Failed to load " << SoundEffects[i].File << std::endl;
+    }
+    // plays effects on mixer from now on
+    void Attach(AudioMixer &mixer)
+    {
+        this->mixer = &mixer;
+    }
+    // starts effect unless it is cooling down; at the voice cap its oldest voice is stolen
+    void Play(SoundEffect effect)
+    {
+        Effect &state = this->effects[effect];
+        const SoundEffectInfo &info = SoundEffects[effect];
+        if (!this->mixer || !state.Buffer.IsValid())
+            return;
+        auto now = std::chrono::steady_clock::now();
+        if (state.HasPlayed && std::chrono::duration<float>(now - state.LastStart).count() < info.Cooldown)
+        {
+            ++this->Throttled;
+            return;
+        }
+        // forget voices that already ended
+        unsigned int alive = 0;
+        for (unsigned int i = 0; i < state.VoiceCount; ++i)
+            if (this->mixer->IsPlaying(state.Voices[i]))
+                state.Voices[alive++] = state.Voices[i];
+        state.VoiceCount = alive;
+        if (state.VoiceCount >= info.MaxVoices && state.VoiceCount > 0)
+        {
+            // voices are kept oldest first
+            this->mixer->Stop(state.Voices[0], 0.01f);
+            for (unsigned int i = 1; i < state.VoiceCount; ++i)
+                state.Voices[i - 1] = state.Voices[i];
+            --state.VoiceCount;
+            ++this->Stolen;
+        }
+        VoiceId voice = this->mixer->Play(&state.Buffer);
+        state.LastStart = now;
+        state.HasPlayed = true;
+        ++this->Played;
+        if (voice && state.VoiceCount < MAX_VOICES)
+            state.Voices[state.VoiceCount++] = voice;
+    }
+    // fades out every effect voice (the buffers stay loaded)
+    void StopAll()
+    {
+        for (Effect &state : this->effects)
+        {
+            for (unsigned int i = 0; i < state.VoiceCount && this->mixer; ++i)
+                this->mixer->Stop(state.Voices[i]);
+            state.VoiceCount = 0;
+        }
+    }
+
+private:
+    static const unsigned int MAX_VOICES = 4; // upper bound for every MaxVoices above
+
+    struct Effect {
+        AudioBuffer Buffer;
+        VoiceId Voices[MAX_VOICES] = {};
+        unsigned int VoiceCount = 0;
+        std::chrono::steady_clock::time_point LastStart;
+        bool HasPlayed = false;
+    };
+
+    AudioMixer *mixer = nullptr;
+    Effect effects[SOUND_EFFECT_COUNT];
+};
+
+#endif
@@ -7,27 +7,36 @@
 
 #include "texture.h"
 #include "shader.h"
+#include "resource_handle.h"
+#include "resource_manager.h"
 
 
 class SpriteRenderer
 {
 public:
     // Constructor (inits shaders/shapes)
-    SpriteRenderer(Shader &shader)
+    SpriteRenderer(ShaderHandle shader)
+        : shader(shader)
     {
-        this->shader = shader;
         this->initRenderData();
     }
     // Destructor
     ~SpriteRenderer()
     {
         glDeleteVertexArrays(1, &this->quadVAO);
+        glDeleteBuffers(1, &this->quadVBO);
     }
 
-    // Renders a defined quad textured with given sprite
-    void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f))
+    // Renders a defined quad textured with the registered texture
+    void DrawSprite(TextureHandle texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float alpha = 1.0f)
     {
-        this->shader.Use();
+        this->DrawSprite(ResourceManager::GetTexture(texture), position, size, rotate, color, alpha);
+    }
+    // Renders a defined quad textured with given sprite, alpha < 1 makes it see-through
+    void DrawSprite(const Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f), float alpha = 1.0f)
+    {
+        Shader &shader = ResourceManager::GetShader(this->shader);
+        shader.Use();
         glm::mat4 model = glm::mat4(1.0f);
         //이동
         model = glm::translate(model, glm::vec3(position, 0.0f));
@@ -38,27 +47,31 @@ public:
         //스케일
         model = glm::scale(model, glm::vec3(size, 1.0f));
 
-        this->shader.SetMatrix4("model", model);
+        shader.SetMatrix4("model", model);
 
-        // render textured quad
-        this->shader.SetVector3f("spriteColor", color);
+        // render textured quad (premultiplied textures fade by scaling all four channels)
+        shader.SetVector4f("spriteColor", glm::vec4(texture.Premultiplied ? color * alpha : color, alpha));
 
         glActiveTexture(GL_TEXTURE0);
         texture.Bind();
 
+        // premultiplied textures (from the import tool) must not be multiplied by alpha again
+        if (texture.Premultiplied)
+            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
         glBindVertexArray(this->quadVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
+        if (texture.Premultiplied)
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 private:
     // Render state
-    Shader shader; 
-    unsigned int quadVAO;
+    ShaderHandle shader; 
+    unsigned int quadVAO, quadVBO;
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData()
     {
         // configure VAO/VBO
-        unsigned int VBO;
         float vertices[] = { 
         // | pos       | tex
             0.0f, 1.0f, 0.0f, 1.0f,
@@ -71,9 +84,9 @@ private:
         };
 
         glGenVertexArrays(1, &this->quadVAO);
-        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &this->quadVBO);
 
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
         glBindVertexArray(this->quadVAO);
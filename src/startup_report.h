@@ -0,0 +1,137 @@
+#ifndef STARTUP_REPORT_H
+#define STARTUP_REPORT_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+#include "tracer.h"
+
+
+// StartupReport records how long each phase of the launch takes (window
+// and context creation, shader compiles, texture decodes, glyph
+// rasterization, audio device, level parsing, ...) on whatever thread it
+// runs, plus milestones like the first presented frame. Times are in
+// milliseconds since Main() was first called, which main() does before
+// anything else. Recording stops with Close() once the game is up, after
+// that a STARTUP_PHASE costs one relaxed atomic load.
+class StartupReport
+{
+public:
+    struct Phase {
+        std::string Name;
+        std::string Thread;
+        double Start, Duration;
+    };
+    struct Milestone {
+        std::string Name;
+        double Time;
+    };
+
+    static StartupReport &Main()
+    {
+        static StartupReport report;
+        return report;
+    }
+
+    bool Recording() const { return this->recording.load(std::memory_order_relaxed); }
+    double Now() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->epoch).count();
+    }
+    void Record(std::string name, double start, double end)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->phases.push_back(Phase{ std::move(name), Tracer::ThreadName(), start, end - start });
+    }
+    // notes that name happened now (first time only)
+    void Mark(const char *name)
+    {
+        if (!this->Recording())
+            return;
+        double now = this->Now();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (const Milestone &milestone : this->milestones)
+            if (milestone.Name == name)
+                return;
+        this->milestones.push_back(Milestone{ name, now });
+    }
+    // time of a milestone, -1 if it did not happen
+    double MilestoneTime(const char *name) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (const Milestone &milestone : this->milestones)
+            if (milestone.Name == name)
+                return milestone.Time;
+        return -1.0;
+    }
+    void Close() { this->recording.store(false, std::memory_order_relaxed); }
+
+    // phases in start order, then the milestones
+    void Print() const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::vector<Phase> sorted = this->phases;
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Phase &a, const Phase &b) { return a.Start < b.Start; });
+        std::printf("Startup phases (ms since launch)\n%-40s %-10s %10s %10s\n", "phase", "thread", "start", "duration");
+        for (const Phase &phase : sorted)
+            std::printf("%-40s %-10s %10.2f %10.2f\n", phase.Name.c_str(), phase.Thread.c_str(), phase.Start, phase.Duration);
+        for (const Milestone &milestone : this->milestones)
+            std::printf("%-40s %-10s %10.2f\n", milestone.Name.c_str(), "", milestone.Time);
+    }
+    // tab separated "phase <name> <thread> <start> <duration>" and "milestone <name> <time>" lines
+    bool Write(const std::string &path) const
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        std::ofstream file(path);
+        for (const Phase &phase : this->phases)
+            file << "phase\t" << phase.Name << '\t' << phase.Thread << '\t' << phase.Start << '\t' << phase.Duration << '\n';
+        for (const Milestone &milestone : this->milestones)
+            file << "milestone\t" << milestone.Name << '\t' << milestone.Time << '\n';
+        return bool(file);
+    }
+
+private:
+    StartupReport() { }
+
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<bool> recording{ true };
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+    std::vector<Milestone> milestones;
+};
+
+// records the enclosing block as a startup phase named name (+ " " + detail) while the report records
+class StartupPhase
+{
+public:
+    explicit StartupPhase(const char *name, const std::string *detail = nullptr)
+        : name(name), detail(detail), start(StartupReport::Main().Recording() ? StartupReport::Main().Now() : -1.0) { }
+    ~StartupPhase()
+    {
+        if (this->start < 0.0)
+            return;
+        std::string name = this->name;
+        if (this->detail)
+            name += " " + *this->detail;
+        StartupReport::Main().Record(std::move(name), this->start, StartupReport::Main().Now());
+    }
+    StartupPhase(const StartupPhase&) = delete;
+    StartupPhase &operator=(const StartupPhase&) = delete;
+
+private:
+    const char *name;
+    const std::string *detail;
+    double start;
+};
+
+#define STARTUP_JOIN_(a, b) a##b
+#define STARTUP_JOIN(a, b) STARTUP_JOIN_(a, b)
+#define STARTUP_PHASE(...) StartupPhase STARTUP_JOIN(startupPhase, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,330 @@
+// stress_bench - how the per-tick costs grow with the number of blocks, on generated levels.
+//
+//   stress_bench [--min <blocks>] [--max <blocks>] [--steps <per decade>]
+//                [--density <0..1>] [--moving <0..1>] [--mix <tile:weight,...>]
+//                [--seed <n>] [--budget <seconds>] [--csv <file>] [--svg <file>]
+//   stress_bench --write <file> [--blocks <n>] [recipe options]
+//
+// Generates levels of --min (100) to --max (1000000) blocks, --steps sizes
+// per decade (default 2), with level_generator.h and times on each of them
+// the level loading (GameLevel::Parse), one tick of Game::DoCollisions and
+// Game::moveBlock, and the draw submission of GameLevel::Draw. GL goes to
+// the no-op stubs of gl_stub.h, so draw is the CPU side only. Every number
+// is the mean over as many calls as fit in a quarter second (at least one).
+// A measurement whose cost, extrapolated quadratically from the size before,
+// would take longer than --budget (default 1 s) per call is skipped, along
+// with the larger sizes. The table ends with the fitted exponent k of
+// time ~ blocks^k per measurement (sizes from 1000 blocks up): 1 is linear,
+// below 1 sublinear. --csv writes the table, --svg a log-log chart of it.
+// --write stores one generated level (--blocks, default 300) as a level file
+// instead. Recipe: --density blocks per grid cell (default 0.3), --moving
+// share of moving blocks (default 0.02), --mix weights of the other tile
+// codes (default 1:60,2:15,3:10,4:10,10:2.5,11:2.5).
+// Run from the repository root.
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl_stub.h"
+#include "game.h"
+#include "level_generator.h"
+
+static const float TICK = 1.0f / 60.0f;
+
+enum Measurement { LOAD, COLLISIONS, UPDATE, DRAW, MEASUREMENTS };
+static const char *const MEASUREMENT_NAMES[MEASUREMENTS] = { "load", "collisions", "update", "draw" };
+static const char *const MEASUREMENT_COLORS[MEASUREMENTS] = { "#1f77b4", "#d62728", "#2ca02c", "#9467bd" };
+
+struct SizeResult {
+    unsigned int Blocks = 0, Width = 0, Height = 0, Moving = 0;
+    double Micros[MEASUREMENTS] = { }; // per call, < 0 when skipped
+};
+
+// mean time of fn in microseconds over as many calls as fit in the time slice
+static double timeCalls(const std::function<void()> &fn, double slice = 0.25)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double first = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned int calls = unsigned(std::min(1000.0, std::max(1.0, slice / std::max(first, 1e-9))));
+    start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < calls; ++i)
+        fn();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / calls;
+}
+
+// least squares slope of log(time) over log(blocks)
+static double fitExponent(const std::vector<SizeResult> &results, Measurement m)
+{
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    unsigned int n = 0;
+    for (const SizeResult &r : results)
+        if (r.Blocks >= 1000 && r.Micros[m] > 0.0)
+        {
+            double x = std::log(double(r.Blocks)), y = std::log(r.Micros[m]);
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+            ++n;
+        }
+    if (n < 2 || n * sxx - sx * sx <= 0.0)
+        return NAN;
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+static bool parseMix(const std::string &text, std::vector<LevelRecipe::Weight> &mix)
+{
+    mix.clear();
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ','))
+    {
+        LevelRecipe::Weight weight;
+        if (std::sscanf(item.c_str(), "%u:%f", &weight.Tile, &weight.Share) != 2)
+            return false;
+        mix.push_back(weight);
+    }
+    return !mix.empty();
+}
+
+static bool writeCsv(const std::string &path, const std::vector<SizeResult> &results)
+{
+    std::ofstream stream(path);
+    stream << "blocks,grid_width,grid_height,moving_blocks,load_us,collisions_us,update_us,draw_us\n";
+    for (const SizeResult &r : results)
+    {
+        stream << r.Blocks << ',' << r.Width << ',' << r.Height << ',' << r.Moving;
+        for (double micros : r.Micros)
+        {
+            stream << ',';
+            if (micros >= 0.0)
+                stream << micros;
+        }
+        stream << '\n';
+    }
+    return bool(stream);
+}
+
+// log-log chart: blocks on x, microseconds per call on y, one line per measurement
+static bool writeSvg(const std::string &path, const std::vector<SizeResult> &results)
+{
+    const double W = 800.0, H = 500.0, LEFT = 70.0, RIGHT = 160.0, TOP = 30.0, BOTTOM = 50.0;
+    double minX = 1e300, maxX = 0.0, minY = 1e300, maxY = 0.0;
+    for (const SizeResult &r : results)
+        for (double micros : r.Micros)
+            if (micros > 0.0)
+            {
+                minX = std::min(minX, double(r.Blocks)); maxX = std::max(maxX, double(r.Blocks));
+                minY = std::min(minY, micros); maxY = std::max(maxY, micros);
+            }
+    if (maxX <= 0.0)
+        return false;
+    // whole decades on both axes
+    double x0 = std::floor(std::log10(minX)), x1 = std::max(x0 + 1.0, std::ceil(std::log10(maxX)));
+    double y0 = std::floor(std::log10(minY)), y1 = std::max(y0 + 1.0, std::ceil(std::log10(maxY)));
+    auto px = [&](double blocks) { return LEFT + (std::log10(blocks) - x0) / (x1 - x0) * (W - LEFT - RIGHT); };
+    auto py = [&](double micros) { return H - BOTTOM - (std::log10(micros) - y0) / (y1 - y0) * (H - TOP - BOTTOM); };
+
+    std::ofstream svg(path);
+    svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << W << "\" height=\"" << H << "\" font-family=\"sans-serif\" font-size=\"12\">\n";
+    svg << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+    for (double d = x0; d <= x1; d += 1.0)
+        svg << "<line x1=\"" << px(std::pow(10.0, d)) << "\" y1=\"" << TOP << "\" x2=\"" << px(std::pow(10.0, d)) << "\" y2=\"" << H - BOTTOM
+            << "\" stroke=\"#ddd\"/><text x=\"" << px(std::pow(10.0, d)) << "\" y=\"" << H - BOTTOM + 18 << "\" text-anchor=\"middle\">1e" << d << "</text>\n";
+    for (double d = y0; d <= y1; d += 1.0)
+        svg << "<line x1=\"" << LEFT << "\" y1=\"" << py(std::pow(10.0, d)) << "\" x2=\"" << W - RIGHT << "\" y2=\"" << py(std::pow(10.0, d))
+            << "\" stroke=\"#ddd\"/><text x=\"" << LEFT - 6 << "\" y=\"" << py(std::pow(10.0, d)) + 4 << "\" text-anchor=\"end\">1e" << d << "</text>\n";
+    svg << "<text x=\"" << (LEFT + W - RIGHT) / 2 << "\" y=\"" << H - 12 << "\" text-anchor=\"middle\">blocks</text>\n";
+    svg << "<text x=\"16\" y=\"" << (TOP + H - BOTTOM) / 2 << "\" text-anchor=\"middle\" transform=\"rotate(-90 16 " << (TOP + H - BOTTOM) / 2
+        << ")\">microseconds per call</text>\n";
+    // linear growth from the cheapest first point, for reference
+    for (const SizeResult &r : results)
+    {
+        double base = 1e300;
+        for (double micros : r.Micros)
+            if (micros > 0.0)
+                base = std::min(base, micros);
+        if (base == 1e300)
+            continue;
+        double end = std::min(maxX, r.Blocks * std::pow(10.0, y1) / base);
+        svg << "<line x1=\"" << px(r.Blocks) << "\" y1=\"" << py(base) << "\" x2=\"" << px(end) << "\" y2=\"" << py(base * end / r.Blocks)
+            << "\" stroke=\"#999\" stroke-dasharray=\"6 4\"/>\n";
+        svg << "<text x=\"" << W - RIGHT + 10 << "\" y=\"" << TOP + 15 + 18 * MEASUREMENTS << "\" fill=\"#999\">- - linear</text>\n";
+        break;
+    }
+    for (int m = 0; m < MEASUREMENTS; ++m)
+    {
+        svg << "<polyline fill=\"none\" stroke-width=\"2\" stroke=\"" << MEASUREMENT_COLORS[m] << "\" points=\"";
+        for (const SizeResult &r : results)
+            if (r.Micros[m] > 0.0)
+                svg << px(r.Blocks) << ',' << py(r.Micros[m]) << ' ';
+        svg << "\"/>\n";
+        for (const SizeResult &r : results)
+            if (r.Micros[m] > 0.0)
+                svg << "<circle cx=\"" << px(r.Blocks) << "\" cy=\"" << py(r.Micros[m]) << "\" r=\"3\" fill=\"" << MEASUREMENT_COLORS[m] << "\"/>\n";
+        double k = fitExponent(results, Measurement(m));
+        char label[64];
+        if (std::isnan(k))
+            std::snprintf(label, sizeof(label), "%s", MEASUREMENT_NAMES[m]);
+        else
+            std::snprintf(label, sizeof(label), "%s (k = %.2f)", MEASUREMENT_NAMES[m], k);
+        svg << "<text x=\"" << W - RIGHT + 10 << "\" y=\"" << TOP + 15 + 18 * m << "\" fill=\"" << MEASUREMENT_COLORS[m] << "\">" << label << "</text>\n";
+    }
+    svg << "</svg>\n";
+    return bool(svg);
+}
+
+int main(int argc, char *argv[])
+{
+    LevelRecipe recipe;
+    unsigned int minBlocks = 100, maxBlocks = 1000000, steps = 2;
+    double budget = 1.0;
+    std::string csvPath, svgPath, writePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--min" && i + 1 < argc)
+            minBlocks = std::max(10, std::atoi(argv[++i]));
+        else if (arg == "--max" && i + 1 < argc)
+            maxBlocks = std::max(10, std::atoi(argv[++i]));
+        else if (arg == "--steps" && i + 1 < argc)
+            steps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--blocks" && i + 1 < argc)
+            recipe.Blocks = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--density" && i + 1 < argc)
+            recipe.Density = std::min(1.0f, std::max(0.001f, float(std::atof(argv[++i]))));
+        else if (arg == "--moving" && i + 1 < argc)
+            recipe.Moving = std::min(1.0f, std::max(0.0f, float(std::atof(argv[++i]))));
+        else if (arg == "--seed" && i + 1 < argc)
+            recipe.Seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--budget" && i + 1 < argc)
+            budget = std::atof(argv[++i]);
+        else if (arg == "--csv" && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (arg == "--svg" && i + 1 < argc)
+            svgPath = argv[++i];
+        else if (arg == "--write" && i + 1 < argc)
+            writePath = argv[++i];
+        else if (arg == "--mix" && i + 1 < argc)
+        {
+            if (!parseMix(argv[++i], recipe.Mix))
+            {
+                std::cout << "ERROR::STRESS: --mix takes tile:weight pairs, e.g. 1:80,3:20" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (!writePath.empty())
+    {
+        std::ofstream file(writePath, std::ios::binary);
+        file << GenerateLevel(recipe);
+        if (!file)
+        {
+            std::cout << "ERROR::STRESS: Could not write " << writePath << std::endl;
+            return 1;
+        }
+        unsigned int width, height;
+        LevelGridSize(recipe, width, height);
+        std::cout << "Wrote " << writePath << ": " << recipe.Blocks << " blocks on " << width << "x" << height << std::endl;
+        return 0;
+    }
+
+    // the game without a window: stub GL, silent audio, assets from disk
+    StubGL();
+    Game world(800, 600);
+    world.SetAudioOutput("null");
+    world.Init();
+    while (world.State == GAME_LOADING)
+    {
+        world.Update(TICK);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    StartupReport::Main().Close();
+    SpriteRenderer renderer(ResourceManager::ShaderId("sprite"));
+
+    std::vector<unsigned int> sizes;
+    for (double exponent = std::log10(double(minBlocks)); exponent <= std::log10(double(maxBlocks)) + 1e-9; exponent += 1.0 / steps)
+        sizes.push_back(unsigned(std::lround(std::pow(10.0, exponent))));
+
+    std::printf("%10s %12s %8s %14s %14s %14s %14s\n", "blocks", "grid", "moving", "load us", "collisions us", "update us", "draw us");
+    std::vector<SizeResult> results;
+    for (unsigned int blocks : sizes)
+    {
+        recipe.Blocks = blocks;
+        SizeResult result;
+        result.Blocks = blocks;
+        LevelGridSize(recipe, result.Width, result.Height);
+        std::string text = GenerateLevel(recipe);
+
+        // skipped when the size before, grown quadratically, would exceed the budget
+        auto tooSlow = [&](Measurement m) {
+            if (results.empty())
+                return false;
+            const SizeResult &previous = results.back();
+            if (previous.Micros[m] < 0.0)
+                return true;
+            double growth = double(blocks) / previous.Blocks;
+            return previous.Micros[m] * growth * growth > budget * 1e6;
+        };
+        GameLevel level;
+        result.Micros[LOAD] = tooSlow(LOAD) ? -1.0 : timeCalls([&]() { level.Parse(text.data(), text.size(), world.Width, world.Height); });
+        if (result.Micros[LOAD] < 0.0)
+            level.Parse(text.data(), text.size(), world.Width, world.Height);
+        for (const GameObject &block : level.Blocks)
+            if (block.Type == LRMOVE || block.Type == UDMOVE)
+                ++result.Moving;
+
+        // the ball rests on its start cell, clear of blocks, so the tick only tests
+        world.CurrentLevel = level;
+        world.ResetPlayer();
+        result.Micros[COLLISIONS] = tooSlow(COLLISIONS) ? -1.0 : timeCalls([&]() { world.DoCollisions(TICK); });
+        result.Micros[UPDATE] = tooSlow(UPDATE) ? -1.0 : timeCalls([&]() { world.moveBlock(TICK); });
+        result.Micros[DRAW] = tooSlow(DRAW) ? -1.0 : timeCalls([&]() { world.CurrentLevel.Draw(renderer); });
+
+        char grid[32];
+        std::snprintf(grid, sizeof(grid), "%ux%u", result.Width, result.Height);
+        std::printf("%10u %12s %8u", blocks, grid, result.Moving);
+        for (double micros : result.Micros)
+        {
+            if (micros < 0.0)
+                std::printf(" %14s", "skipped");
+            else
+                std::printf(" %14.1f", micros);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+        results.push_back(result);
+    }
+
+    std::printf("%10s %12s %8s", "exponent", "", "");
+    for (int m = 0; m < MEASUREMENTS; ++m)
+    {
+        double k = fitExponent(results, Measurement(m));
+        if (std::isnan(k))
+            std::printf(" %14s", "-");
+        else
+            std::printf(" %14.2f", k);
+    }
+    std::printf("\n");
+
+    int failures = 0;
+    if (!csvPath.empty() && !writeCsv(csvPath, results))
+    {
+        std::cout << "ERROR::STRESS: Could not write " << csvPath << std::endl;
+        ++failures;
+    }
+    if (!svgPath.empty() && !writeSvg(svgPath, results))
+    {
+        std::cout << "ERROR::STRESS: Could not write " << svgPath << std::endl;
+        ++failures;
+    }
+    return failures ? 1 : 0;
+}
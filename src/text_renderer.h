@@ -2,6 +2,9 @@
 #define TEXT_RENDERER_H
 
 #include <map>
+#include <string>
+#include <vector>
+#include <cstring>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -22,6 +25,15 @@ struct Character {
     unsigned int Advance;   // horizontal offset to advance to next glyph
 };
 
+/// A rendered glyph waiting for its texture upload (see TextRenderer::Rasterize)
+struct GlyphBitmap {
+    char         Code;
+    glm::ivec2   Size;
+    glm::ivec2   Bearing;
+    unsigned int Advance;
+    std::vector<unsigned char> Pixels; // Size.x * Size.y coverage values, tightly packed
+};
+
 
 // A renderer class for rendering text displayed by a font loaded using the 
 // FreeType library. A single font is loaded, processed into a list of Character
@@ -32,14 +44,15 @@ public:
     // holds a list of pre-compiled Characters
     std::map<char, Character> Characters; 
     // shader used for text rendering
-    Shader TextShader;
+    ShaderHandle TextShader;
     // constructor
     TextRenderer(unsigned int width, unsigned int height)
     {
         // load and configure shader
         this->TextShader = ResourceManager::LoadShader("src/shader/text.vs", "src/shader/text.fs", nullptr, "text");
-        this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
-        this->TextShader.SetInteger("text", 0);
+        Shader &shader = ResourceManager::GetShader(this->TextShader);
+        shader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
+        shader.SetInteger("text", 0);
         // configure VAO/VBO for texture quads
         glGenVertexArrays(1, &this->VAO);
         glGenBuffers(1, &this->VBO);
@@ -51,25 +64,44 @@ public:
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
     }
+    // destructor, frees the glyph textures and the quad
+    ~TextRenderer()
+    {
+        this->clearCharacters();
+        glDeleteVertexArrays(1, &this->VAO);
+        glDeleteBuffers(1, &this->VBO);
+    }
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer &operator=(const TextRenderer&) = delete;
     // pre-compiles a list of characters from the given font
     void Load(std::string font, unsigned int fontSize)
     {
-        // first clear the previously loaded Characters
-        this->Characters.clear();
-        // then initialize and load the FreeType library
+        this->Upload(Rasterize(font, fontSize));
+    }
+    // renders the first 128 ASCII glyphs of font into memory, touches no GL state so it may run on a worker thread
+    static std::vector<GlyphBitmap> Rasterize(const std::string &font, unsigned int fontSize)
+    {
+        std::vector<GlyphBitmap> glyphs;
+        // initialize and load the FreeType library
         FT_Library ft;    
         if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
+        {
             std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        // load font as face
+            return glyphs;
+        }
+        // load font as face, straight from the asset pack's memory when available
+        AssetData fontData = ResourceManager::ReadAsset(font.c_str());
         FT_Face face;
-        if (FT_New_Face(ft, font.c_str(), 0, &face))
+        if (!fontData.IsValid() || FT_New_Memory_Face(ft, fontData.Data, static_cast<FT_Long>(fontData.Size), 0, &face))
+        {
             std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
+            FT_Done_FreeType(ft);
+            return glyphs;
+        }
         // set size to load glyphs as
         FT_Set_Pixel_Sizes(face, 0, fontSize);
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-        // then for the first 128 ASCII characters, pre-load/compile their characters and store them
-        for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
+        // then for the first 128 ASCII characters, render and keep their bitmaps
+        for (unsigned char c = 0; c < 128; c++) // lol see what I did there 
         {
             // load character glyph 
             if (FT_Load_Char(face, c, FT_LOAD_RENDER))
@@ -77,6 +109,32 @@ public:
                 std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
                 continue;
             }
+            const FT_Bitmap &bitmap = face->glyph->bitmap;
+            GlyphBitmap glyph;
+            glyph.Code = static_cast<char>(c);
+            glyph.Size = glm::ivec2(bitmap.width, bitmap.rows);
+            glyph.Bearing = glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top);
+            glyph.Advance = static_cast<unsigned int>(face->glyph->advance.x);
+            // copy row by row, the FreeType pitch may include padding
+            glyph.Pixels.resize(size_t(bitmap.width) * bitmap.rows);
+            for (unsigned int row = 0; row < bitmap.rows; ++row)
+                std::memcpy(glyph.Pixels.data() + size_t(row) * bitmap.width, bitmap.buffer + ptrdiff_t(row) * bitmap.pitch, bitmap.width);
+            glyphs.push_back(std::move(glyph));
+        }
+        // destroy FreeType once we're finished
+        FT_Done_Face(face);
+        FT_Done_FreeType(ft);
+        return glyphs;
+    }
+    // creates the glyph textures from rasterized bitmaps, replacing the loaded Characters
+    void Upload(const std::vector<GlyphBitmap> &glyphs)
+    {
+        // first clear the previously loaded Characters (and free their textures)
+        this->clearCharacters();
+        // disable byte-alignment restriction
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
+        for (const GlyphBitmap &glyph : glyphs)
+        {
             // generate texture
             unsigned int texture;
             glGenTextures(1, &texture);
@@ -85,12 +143,12 @@ public:
                 GL_TEXTURE_2D,
                 0,
                 GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
+                glyph.Size.x,
+                glyph.Size.y,
                 0,
                 GL_RED,
                 GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
+                glyph.Pixels.empty() ? nullptr : glyph.Pixels.data()
                 );
             // set texture options
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -101,34 +159,41 @@ public:
             // now store character for later use
             Character character = {
                 texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)
+                glyph.Size,
+                glyph.Bearing,
+                glyph.Advance
             };
-            Characters.insert(std::pair<char, Character>(c, character));
+            Characters.insert(std::pair<char, Character>(glyph.Code, character));
         }
         glBindTexture(GL_TEXTURE_2D, 0);
-        // destroy FreeType once we're finished
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
     }
     // renders a string of text using the precompiled list of characters
-    void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f))
+    void RenderText(const std::string &text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f))
+    {
+        this->RenderText(text.c_str(), x, y, scale, color);
+    }
+    // characters without a glyph are skipped, looking them up never inserts (no allocation per frame)
+    void RenderText(const char *text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f))
     {
         // activate corresponding render state	
-        this->TextShader.Use();
-        this->TextShader.SetVector3f("textColor", color);
+        Shader &shader = ResourceManager::GetShader(this->TextShader);
+        shader.Use();
+        shader.SetVector3f("textColor", color);
         glActiveTexture(GL_TEXTURE0);
         glBindVertexArray(this->VAO);
 
+        auto capital = this->Characters.find('H');
+        int top = capital != this->Characters.end() ? capital->second.Bearing.y : 0;
         // iterate through all characters
-        std::string::const_iterator c;
-        for (c = text.begin(); c != text.end(); c++)
+        for (const char *c = text; *c; c++)
         {
-            Character ch = Characters[*c];
+            auto found = this->Characters.find(*c);
+            if (found == this->Characters.end())
+                continue;
+            const Character &ch = found->second;
 
             float xpos = x + ch.Bearing.x * scale;
-            float ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
+            float ypos = y + (top - ch.Bearing.y) * scale;
 
             float w = ch.Size.x * scale;
             float h = ch.Size.y * scale;
@@ -160,6 +225,13 @@ public:
 private:
     // render state
     unsigned int VAO, VBO;
+
+    void clearCharacters()
+    {
+        for (const std::pair<const char, Character> &character : this->Characters)
+            glDeleteTextures(1, &character.second.TextureID);
+        this->Characters.clear();
+    }
 };
 
 #endif 
\ No newline at end of file
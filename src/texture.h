@@ -1,8 +1,20 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <vector>
+#include <cstring>
+#include <utility>
+
 #include <glad/glad.h>
 
+// S3TC formats are an extension and not part of the generated GL loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
 class Texture2D
@@ -20,19 +32,53 @@ public:
     unsigned int Wrap_T; // wrapping mode on T axis
     unsigned int Filter_Min; // filtering mode if texture pixels < screen pixels
     unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
-    // constructor (sets default texture modes)
+    bool Premultiplied; // color channels are already multiplied by alpha
+    // constructor (sets default texture modes), the GL object is only created once image data is generated
     Texture2D()
-        : Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR)
+        : ID(0), Width(0), Height(0), Internal_Format(GL_RGB), Image_Format(GL_RGB), Wrap_S(GL_REPEAT), Wrap_T(GL_REPEAT), Filter_Min(GL_LINEAR), Filter_Max(GL_LINEAR), Premultiplied(false)
+    {
+    }
+    // the texture owns its GL object: it can be moved but not copied, and deletes the object when destroyed
+    Texture2D(Texture2D &&other) noexcept
+        : Texture2D()
+    {
+        *this = std::move(other);
+    }
+    Texture2D &operator=(Texture2D &&other) noexcept
+    {
+        if (this != &other)
+        {
+            this->release();
+            this->ID = other.ID;
+            this->Width = other.Width;
+            this->Height = other.Height;
+            this->Internal_Format = other.Internal_Format;
+            this->Image_Format = other.Image_Format;
+            this->Wrap_S = other.Wrap_S;
+            this->Wrap_T = other.Wrap_T;
+            this->Filter_Min = other.Filter_Min;
+            this->Filter_Max = other.Filter_Max;
+            this->Premultiplied = other.Premultiplied;
+            other.ID = 0;
+        }
+        return *this;
+    }
+    Texture2D(const Texture2D&) = delete;
+    Texture2D &operator=(const Texture2D&) = delete;
+    ~Texture2D()
     {
-        glGenTextures(1, &this->ID);
+        this->release();
     }
     // generates texture from image data
-    void Generate(unsigned int width, unsigned int height, unsigned char* data)
+    void Generate(unsigned int width, unsigned int height, const unsigned char* data)
     {
         this->Width = width;
         this->Height = height;
-        // create Texture
+        // create Texture (rows are tightly packed)
+        if (this->ID == 0)
+            glGenTextures(1, &this->ID);
         glBindTexture(GL_TEXTURE_2D, this->ID);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexImage2D(GL_TEXTURE_2D, 0, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, data);
         // set Texture wrap and filter modes
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
@@ -42,11 +88,80 @@ public:
         // unbind texture
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+    // generates texture from a prebuilt mip chain, levels[i] is level i and each level is half the size of the previous one
+    void Generate(unsigned int width, unsigned int height, const std::vector<const unsigned char*> &levels)
+    {
+        if (levels.size() > 1 && this->Filter_Min == GL_LINEAR)
+            this->Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+        this->Generate(width, height, levels[0]);
+        if (levels.size() < 2)
+            return;
+        glBindTexture(GL_TEXTURE_2D, this->ID);
+        for (unsigned int i = 1; i < levels.size(); ++i)
+        {
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+            glTexImage2D(GL_TEXTURE_2D, i, this->Internal_Format, width, height, 0, this->Image_Format, GL_UNSIGNED_BYTE, levels[i]);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(levels.size() - 1));
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    // generates texture from pre-compressed levels (glCompressedTexImage2D), format is a GL_COMPRESSED_* enum
+    void GenerateCompressed(unsigned int width, unsigned int height, unsigned int format,
+                            const std::vector<const unsigned char*> &levels, const std::vector<unsigned int> &sizes)
+    {
+        this->Width = width;
+        this->Height = height;
+        this->Internal_Format = format;
+        if (levels.size() > 1 && this->Filter_Min == GL_LINEAR)
+            this->Filter_Min = GL_LINEAR_MIPMAP_LINEAR;
+        if (this->ID == 0)
+            glGenTextures(1, &this->ID);
+        glBindTexture(GL_TEXTURE_2D, this->ID);
+        for (unsigned int i = 0; i < levels.size(); ++i)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, format, width, height, 0, sizes[i], levels[i]);
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<int>(levels.size() - 1));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->Wrap_S);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->Wrap_T);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->Filter_Min);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->Filter_Max);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    // whether the driver accepts S3TC (BC1/BC3) data, checked once per run
+    static bool SupportsS3TC()
+    {
+        static int supported = -1;
+        if (supported < 0)
+        {
+            supported = 0;
+            int count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (int i = 0; i < count && !supported; ++i)
+            {
+                const char *name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+                if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0)
+                    supported = 1;
+            }
+        }
+        return supported == 1;
+    }
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const
     {
         glBindTexture(GL_TEXTURE_2D, this->ID);
     }
+
+private:
+    void release()
+    {
+        if (this->ID != 0)
+            glDeleteTextures(1, &this->ID);
+        this->ID = 0;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <cstdio>
+#include <string>
+#include <iostream>
+#include <filesystem>
+
+#include "mapped_file.h"
+#include "texture_file.h"
+
+
+// TextureCache keeps decoded pixels of every loaded texture on disk as
+// .bbtx files under resources/.cache, keyed by the source path and tagged
+// with the content hash of the source image. A warm start maps the entry
+// and uploads straight from the mapping instead of running the PNG/JPEG
+// decoder; when the source changes its hash no longer matches and the
+// entry is rebuilt on the next load.
+class TextureCache
+{
+public:
+    // where cache entries live, relative to the working directory
+    static const char *Directory() { return "resources/.cache"; }
+
+    // maps the cache entry for file if it was built from the same source bytes
+    static bool Load(const char *file, uint64_t sourceHash, MappedFile &mapping, TextureFileHeader &header, const unsigned char *&pixels)
+    {
+        if (!mapping.Open(pathFor(file).c_str()))
+            return false;
+        const TextureFileLevel *levels = ReadTextureFile(mapping.Data(), mapping.Size(), header);
+        if (!levels || header.SourceHash != sourceHash || header.Format != TEXTURE_FORMAT_RAW ||
+            levels[0].Size != uint64_t(header.Width) * header.Height * header.Channels)
+        {
+            mapping.Close();
+            return false;
+        }
+        pixels = mapping.Data() + levels[0].Offset;
+        return true;
+    }
+    // writes (or replaces) the cache entry for file, safe to call from worker threads
+    static void Store(const char *file, uint64_t sourceHash, int width, int height, int channels, const unsigned char *pixels)
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(Directory(), ec);
+        std::string path = pathFor(file);
+        // write to a temporary first so a crash never leaves a truncated entry behind
+        std::string temp = path + ".tmp";
+        TextureFileHeader header = {};
+        header.SourceHash = sourceHash;
+        header.Width = width;
+        header.Height = height;
+        header.Channels = channels;
+        size_t size = size_t(width) * height * channels;
+        if (!WriteTextureFile(temp.c_str(), header, { { pixels, size, uint32_t(width), uint32_t(height) } }))
+        {
+            std::cout << "ERROR::TEXTURECACHE: Failed to write " << temp << std::endl;
+            std::remove(temp.c_str());
+            return;
+        }
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+        {
+            std::cout << "ERROR::TEXTURECACHE: Failed to replace " << path << ": " << ec.message() << std::endl;
+            std::remove(temp.c_str());
+        }
+    }
+
+private:
+    TextureCache() { }
+    // one entry per source path; the file name is a hash so nested paths stay flat
+    static std::string pathFor(const char *file)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "/%016llx.bbtx", static_cast<unsigned long long>(HashContent(reinterpret_cast<const unsigned char*>(file), std::strlen(file))));
+        return std::string(Directory()) + name;
+    }
+};
+
+#endif
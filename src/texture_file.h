@@ -0,0 +1,119 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+
+// Ready-to-upload texture container (.bbtx), all values little endian:
+//   TextureFileHeader
+//   TextureFileLevel[LevelCount]   level 0 is the full size image
+//   pixel data                     each level starting at a TEXTURE_FILE_ALIGNMENT boundary
+// Raw pixels are tightly packed rows of Channels bytes and compressed levels
+// are plain BC blocks, so a level can be handed to glTexImage2D or
+// glCompressedTexImage2D directly from a memory mapping.
+const char     TEXTURE_FILE_MAGIC[4] = { 'B', 'B', 'T', 'X' };
+const uint32_t TEXTURE_FILE_VERSION = 2; // 2 split the import settings out of SourceHash
+const uint32_t TEXTURE_FILE_ALIGNMENT = 64;
+const uint32_t TEXTURE_FLAG_PREMULTIPLIED = 1 << 0; // color channels are multiplied by alpha
+// pixel formats: raw rows of Channels bytes, or BC1/BC3 blocks (see bc_codec.h)
+const uint32_t TEXTURE_FORMAT_RAW = 0;
+const uint32_t TEXTURE_FORMAT_BC1 = 1;
+const uint32_t TEXTURE_FORMAT_BC3 = 2;
+
+struct TextureFileHeader {
+    char     Magic[4];
+    uint32_t Version;
+    uint64_t SourceHash;  // content hash (HashContent) of the source image this was built from
+    uint64_t SettingsHash; // hash of the texture_importer manifest line, 0 in cache entries
+    uint32_t Width;
+    uint32_t Height;
+    uint32_t Channels;
+    uint32_t LevelCount;
+    uint32_t Flags;
+    uint32_t Format;      // TEXTURE_FORMAT_*
+};
+
+struct TextureFileLevel {
+    uint64_t Offset;      // from the start of the file
+    uint64_t Size;
+    uint32_t Width;
+    uint32_t Height;
+};
+
+// fast 64-bit content hash, used to notice when a source file changed
+inline uint64_t HashContent(const unsigned char *data, size_t size)
+{
+    const uint64_t prime = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = size * prime;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// parses and validates a mapped .bbtx, returns the level table or nullptr if the data is unusable
+inline const TextureFileLevel *ReadTextureFile(const unsigned char *data, size_t size, TextureFileHeader &header)
+{
+    if (size < sizeof(TextureFileHeader))
+        return nullptr;
+    std::memcpy(&header, data, sizeof(TextureFileHeader));
+    if (std::memcmp(header.Magic, TEXTURE_FILE_MAGIC, 4) != 0 || header.Version != TEXTURE_FILE_VERSION || header.LevelCount == 0)
+        return nullptr;
+    if (sizeof(TextureFileHeader) + uint64_t(header.LevelCount) * sizeof(TextureFileLevel) > size)
+        return nullptr;
+    const TextureFileLevel *levels = reinterpret_cast<const TextureFileLevel*>(data + sizeof(TextureFileHeader));
+    for (uint32_t i = 0; i < header.LevelCount; ++i)
+        if (levels[i].Offset + levels[i].Size > size)
+            return nullptr;
+    return levels;
+}
+
+// writes a .bbtx from in-memory levels (pointer + size + dimensions), returns false on I/O failure
+struct TextureFileLevelData {
+    const unsigned char *Data;
+    size_t Size;
+    uint32_t Width, Height;
+};
+inline bool WriteTextureFile(const char *path, TextureFileHeader header, const std::vector<TextureFileLevelData> &levels)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+    auto align = [](uint64_t offset) { return (offset + TEXTURE_FILE_ALIGNMENT - 1) / TEXTURE_FILE_ALIGNMENT * TEXTURE_FILE_ALIGNMENT; };
+    std::memcpy(header.Magic, TEXTURE_FILE_MAGIC, 4);
+    header.Version = TEXTURE_FILE_VERSION;
+    header.LevelCount = static_cast<uint32_t>(levels.size());
+    std::vector<TextureFileLevel> table(levels.size());
+    uint64_t offset = align(sizeof(TextureFileHeader) + levels.size() * sizeof(TextureFileLevel));
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        table[i].Offset = offset;
+        table[i].Size = levels[i].Size;
+        table[i].Width = levels[i].Width;
+        table[i].Height = levels[i].Height;
+        offset = align(offset + levels[i].Size);
+    }
+    static const char zeros[TEXTURE_FILE_ALIGNMENT] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(TextureFileHeader));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(TextureFileLevel)));
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        out.write(zeros, static_cast<std::streamsize>(table[i].Offset - position));
+        out.write(reinterpret_cast<const char*>(levels[i].Data), static_cast<std::streamsize>(levels[i].Size));
+    }
+    return static_cast<bool>(out);
+}
+
+#endif
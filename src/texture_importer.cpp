@@ -0,0 +1,235 @@
+// texture_importer - offline texture import for the asset build.
+//
+//   texture_importer [--force] [--min-psnr <dB>] [manifest]
+//
+// Reads the import manifest (default resources/textures/import.txt) and,
+// for every listed texture, writes resources/textures/imported/<name>.bbtx:
+// the image shrunk to its largest on-screen size, an optional mip chain,
+// optionally premultiplied alpha and optionally BC1/BC3 block compression.
+// The game loads these instead of decoding the source image. Outputs whose
+// source and settings did not change are skipped unless --force is given.
+// Compressed textures report their PSNR and encode speed; with --min-psnr
+// the run fails when any texture falls below the given quality.
+// Run from the repository root.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#include "asset_pack.h"
+#include "texture_file.h"
+#include "image_filter.h"
+#include "bc_codec.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+// one manifest line: <file> <max width> <max height> [mipmap] [premultiply] [bc]
+struct ImportSettings {
+    std::string File;
+    int MaxWidth = 0, MaxHeight = 0;
+    bool Mipmap = false;
+    bool Premultiply = false;
+    bool Compress = false; // BC1 for opaque, BC3 for images with alpha
+    std::string Line; // the settings as written, part of the up-to-date check
+};
+
+static bool readManifest(const std::string &path, std::vector<ImportSettings> &entries)
+{
+    std::ifstream manifest(path);
+    if (!manifest)
+        return false;
+    std::string line;
+    while (std::getline(manifest, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream words(line);
+        ImportSettings settings;
+        if (!(words >> settings.File >> settings.MaxWidth >> settings.MaxHeight))
+            continue;
+        std::string option;
+        while (words >> option)
+        {
+            if (option == "mipmap")
+                settings.Mipmap = true;
+            else if (option == "premultiply")
+                settings.Premultiply = true;
+            else if (option == "bc")
+                settings.Compress = true;
+            else
+                std::cout << "WARNING::IMPORTER: Unknown option '" << option << "' for " << settings.File << std::endl;
+        }
+        settings.Line = line;
+        entries.push_back(settings);
+    }
+    return true;
+}
+
+// returns true when output already holds an import built from the same source and settings
+static bool isUpToDate(const std::string &output, uint64_t sourceHash, uint64_t settingsHash)
+{
+    MappedFile existing;
+    if (!existing.Open(output.c_str()))
+        return false;
+    TextureFileHeader header;
+    return ReadTextureFile(existing.Data(), existing.Size(), header) && header.SourceHash == sourceHash && header.SettingsHash == settingsHash;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string manifestPath = "resources/textures/import.txt";
+    bool force = false;
+    double minPSNR = 0.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--force")
+            force = true;
+        else if (arg == "--min-psnr" && i + 1 < argc)
+            minPSNR = std::atof(argv[++i]);
+        else
+            manifestPath = arg;
+    }
+    std::vector<ImportSettings> entries;
+    if (!readManifest(manifestPath, entries))
+    {
+        std::cout << "ERROR::IMPORTER: Could not read " << manifestPath << std::endl;
+        return 1;
+    }
+    fs::path folder = fs::path(manifestPath).parent_path();
+    fs::path outputFolder = folder / "imported";
+    std::error_code ec;
+    fs::create_directories(outputFolder, ec);
+
+    int failures = 0;
+    for (const ImportSettings &settings : entries)
+    {
+        std::string source = (folder / settings.File).generic_string();
+        std::string output = (outputFolder / fs::path(settings.File).stem()).generic_string() + ".bbtx";
+        AssetData bytes = AssetData::FromFile(source.c_str());
+        if (!bytes.IsValid())
+        {
+            std::cout << "ERROR::IMPORTER: Could not read " << source << std::endl;
+            ++failures;
+            continue;
+        }
+        // the settings are part of the key so editing the manifest also triggers a rebuild;
+        // the game checks the source hash alone, it does not read the manifest
+        uint64_t sourceHash = HashContent(bytes.Data, bytes.Size), settingsHash = HashName(settings.Line);
+        if (!force && isUpToDate(output, sourceHash, settingsHash))
+        {
+            std::cout << "  up to date  " << output << std::endl;
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+
+        // decode, keeping 3 channels for opaque sources and 4 when there is alpha
+        int width, height, channels;
+        if (!stbi_info_from_memory(bytes.Data, static_cast<int>(bytes.Size), &width, &height, &channels))
+        {
+            std::cout << "ERROR::IMPORTER: Unsupported image " << source << std::endl;
+            ++failures;
+            continue;
+        }
+        int wanted = (channels == 2 || channels == 4) ? 4 : 3;
+        unsigned char *pixels = stbi_load_from_memory(bytes.Data, static_cast<int>(bytes.Size), &width, &height, &channels, wanted);
+        if (!pixels)
+        {
+            std::cout << "ERROR::IMPORTER: Failed to decode " << source << ": " << stbi_failure_reason() << std::endl;
+            ++failures;
+            continue;
+        }
+        Image image(width, height, wanted);
+        std::copy(pixels, pixels + image.Pixels.size(), image.Pixels.begin());
+        stbi_image_free(pixels);
+
+        // filter in premultiplied space so transparent texels do not bleed their color into edges
+        PremultiplyAlpha(image);
+        int targetWidth = std::min(width, settings.MaxWidth), targetHeight = std::min(height, settings.MaxHeight);
+        std::vector<Image> levels;
+        levels.push_back(ResizeDown(image, std::max(1, targetWidth), std::max(1, targetHeight)));
+        while (settings.Mipmap && (levels.back().Width > 1 || levels.back().Height > 1))
+            levels.push_back(BoxDownsample(levels.back()));
+        if (!settings.Premultiply)
+            for (Image &level : levels)
+                UnpremultiplyAlpha(level);
+
+        TextureFileHeader header = {};
+        header.SourceHash = sourceHash;
+        header.SettingsHash = settingsHash;
+        header.Width = levels[0].Width;
+        header.Height = levels[0].Height;
+        header.Channels = wanted;
+        header.Flags = settings.Premultiply && wanted == 4 ? TEXTURE_FLAG_PREMULTIPLIED : 0;
+        header.Format = TEXTURE_FORMAT_RAW;
+        std::vector<TextureFileLevelData> data;
+        size_t totalBytes = 0;
+        std::vector<std::vector<unsigned char>> blocks;
+        std::string quality;
+        if (settings.Compress)
+        {
+            // every row of 4x4 blocks is an independent job on the worker pool
+            BCFormat format = wanted == 4 ? BC3 : BC1;
+            header.Format = format == BC1 ? TEXTURE_FORMAT_BC1 : TEXTURE_FORMAT_BC3;
+            auto encodeStart = std::chrono::steady_clock::now();
+            size_t texels = 0;
+            for (const Image &level : levels)
+            {
+                blocks.emplace_back(BCImageBytes(format, level.Width, level.Height));
+                unsigned char *out = blocks.back().data();
+                ThreadPool::Shared().ParallelFor((level.Height + 3) / 4, [&](size_t row) {
+                    BCEncodeBlockRow(level.Pixels.data(), level.Width, level.Height, level.Channels, format, static_cast<int>(row), out);
+                });
+                texels += size_t(level.Width) * level.Height;
+            }
+            double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+            // quality of the top level against the uncompressed result
+            std::vector<unsigned char> decoded(levels[0].Pixels.size());
+            BCDecodeImage(blocks[0].data(), levels[0].Width, levels[0].Height, format, wanted, decoded.data());
+            double psnr = ImagePSNR(levels[0].Pixels.data(), decoded.data(), decoded.size());
+            char text[96];
+            std::snprintf(text, sizeof(text), ", %s PSNR %.2f dB, %.1f Mtexel/s", format == BC1 ? "BC1" : "BC3",
+                          psnr, texels / std::max(encodeSeconds, 1e-9) / 1e6);
+            quality = text;
+            if (psnr < minPSNR)
+            {
+                std::cout << "ERROR::IMPORTER: " << source << " compresses to " << psnr << " dB, below " << minPSNR << " dB" << std::endl;
+                ++failures;
+                continue;
+            }
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                data.push_back({ blocks[i].data(), blocks[i].size(), uint32_t(levels[i].Width), uint32_t(levels[i].Height) });
+                totalBytes += blocks[i].size();
+            }
+        }
+        else
+        {
+            for (const Image &level : levels)
+            {
+                data.push_back({ level.Pixels.data(), level.Pixels.size(), uint32_t(level.Width), uint32_t(level.Height) });
+                totalBytes += level.Pixels.size();
+            }
+        }
+        if (!WriteTextureFile(output.c_str(), header, data))
+        {
+            std::cout << "ERROR::IMPORTER: Failed to write " << output << std::endl;
+            ++failures;
+            continue;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  imported    " << output << "  " << width << "x" << height << " -> " << header.Width << "x" << header.Height
+                  << ", " << levels.size() << " level(s), " << size_t(width) * height * wanted << " -> " << totalBytes
+                  << " bytes" << quality << " (" << ms << " ms)" << std::endl;
+    }
+    return failures == 0 ? 0 : 1;
+}
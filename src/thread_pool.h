@@ -0,0 +1,119 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+#include "tracer.h"
+
+
+// A fixed-size pool of worker threads executing queued jobs in FIFO order.
+// Jobs must not touch OpenGL: the GL context only lives on the main thread,
+// so workers produce data and the main thread uploads it.
+class ThreadPool
+{
+public:
+    // starts threadCount workers (0 = one per hardware thread, leaving one for the main thread)
+    explicit ThreadPool(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+        {
+            unsigned int hardware = std::thread::hardware_concurrency();
+            threadCount = hardware > 1 ? hardware - 1 : 1;
+        }
+        for (unsigned int i = 0; i < threadCount; ++i)
+            this->workers.emplace_back([this, i]() {
+                Tracer::NameThread("worker", int(i));
+                this->workerLoop();
+            });
+    }
+    // finishes the queued jobs and joins all workers
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for (std::thread &worker : this->workers)
+            worker.join();
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    // queues a job for execution on a worker thread
+    void Submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->jobs.push_back(std::move(job));
+        }
+        this->wake.notify_one();
+    }
+    unsigned int Size() const { return static_cast<unsigned int>(this->workers.size()); }
+
+    // runs body(i) for every i in [0, count) on the workers and the calling thread, returns when all are done
+    void ParallelFor(size_t count, const std::function<void(size_t)> &body)
+    {
+        std::atomic<size_t> next(0);
+        auto run = [&]() {
+            for (size_t i = next++; i < count; i = next++)
+                body(i);
+        };
+        size_t helpers = std::min<size_t>(this->Size(), count > 0 ? count - 1 : 0);
+        std::mutex doneMutex;
+        std::condition_variable doneSignal;
+        size_t done = 0;
+        for (size_t i = 0; i < helpers; ++i)
+        {
+            this->Submit([&]() {
+                run();
+                std::lock_guard<std::mutex> lock(doneMutex);
+                ++done;
+                doneSignal.notify_one();
+            });
+        }
+        run();
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneSignal.wait(lock, [&]() { return done == helpers; });
+    }
+
+    // pool shared by the loaders, created on first use
+    static ThreadPool &Shared()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(this->mutex);
+                this->wake.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+                if (this->jobs.empty())
+                    return;
+                job = std::move(this->jobs.front());
+                this->jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+
+// Tracer records begin/duration events of named scopes on every thread into
+// per-thread rings (one writer each, no locks after a thread's first event)
+// and writes them as Chrome trace-event JSON, which chrome://tracing and
+// Perfetto load. Rings overwrite their oldest events, so tracing can stay
+// enabled and a dump covers the last WindowSeconds. Disabled, a scope costs
+// one relaxed atomic load.
+class Tracer
+{
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 16384; // power of two
+
+    static Tracer &Main()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void Enable(double windowSeconds)
+    {
+        this->window = int64_t(windowSeconds * 1e9);
+        this->enabled.store(true, std::memory_order_relaxed);
+    }
+    bool Enabled() const { return this->enabled.load(std::memory_order_relaxed); }
+    // names the calling thread in the trace, name must outlive the tracer (a literal)
+    static void NameThread(const char *name, int index = -1)
+    {
+        threadName() = name;
+        threadIndex() = index;
+    }
+    // name given to the calling thread ("thread" if none)
+    static const char *ThreadName() { return threadName(); }
+    // nanoseconds since the tracer was created
+    int64_t Now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->epoch).count();
+    }
+    // adds a finished scope of the calling thread, name must stay valid until the trace is written
+    void Record(const char *name, int64_t start, int64_t end)
+    {
+        ThreadEvents *events = threadEvents();
+        if (!events)
+            events = this->registerThread();
+        size_t index = events->Count.load(std::memory_order_relaxed);
+        Event &event = events->Events[index & (EVENTS_PER_THREAD - 1)];
+        event.Name = name;
+        event.Start = start;
+        event.Duration = end - start;
+        events->Count.store(index + 1, std::memory_order_release);
+    }
+    // writes the events of the last window to path; safe while other threads keep recording
+    bool Write(const std::string &path)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "w");
+        if (!file)
+            return false;
+        int64_t from = this->Now() - this->window;
+        std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (size_t tid = 0; tid < this->threads.size(); ++tid)
+        {
+            ThreadEvents &events = *this->threads[tid];
+            std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"", first ? "" : ",\n", tid);
+            writeName(file, events.Name);
+            if (events.Index >= 0)
+                std::fprintf(file, " %d", events.Index);
+            std::fprintf(file, "\"}}");
+            first = false;
+            // the oldest eighth of a full ring may be overwritten while we read, skip it
+            size_t count = events.Count.load(std::memory_order_acquire);
+            size_t begin = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD + EVENTS_PER_THREAD / 8 : 0;
+            for (size_t i = begin; i < count; ++i)
+            {
+                const Event &event = events.Events[i & (EVENTS_PER_THREAD - 1)];
+                if (event.Start + event.Duration < from || !event.Name)
+                    continue;
+                std::fprintf(file, ",\n{\"name\":\"");
+                writeName(file, event.Name);
+                std::fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+                             tid, event.Start * 1e-3, event.Duration * 1e-3);
+            }
+        }
+        std::fprintf(file, "\n]}\n");
+        return std::fclose(file) == 0;
+    }
+
+private:
+    struct Event {
+        const char *Name = nullptr;
+        int64_t Start = 0, Duration = 0; // nanoseconds
+    };
+    struct ThreadEvents {
+        const char *Name;
+        int Index;
+        std::atomic<size_t> Count{ 0 };
+        Event Events[EVENTS_PER_THREAD];
+    };
+
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::atomic<bool> enabled{ false };
+    int64_t window = 0;
+    std::mutex mutex; // guards the thread list
+    std::vector<std::unique_ptr<ThreadEvents>> threads;
+
+    static const char *&threadName()
+    {
+        thread_local const char *name = "thread";
+        return name;
+    }
+    static int &threadIndex()
+    {
+        thread_local int index = -1;
+        return index;
+    }
+    static ThreadEvents *&threadEvents()
+    {
+        thread_local ThreadEvents *events = nullptr;
+        return events;
+    }
+    ThreadEvents *registerThread()
+    {
+        std::unique_ptr<ThreadEvents> events(new ThreadEvents());
+        events->Name = threadName();
+        events->Index = threadIndex();
+        threadEvents() = events.get();
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->threads.push_back(std::move(events));
+        return this->threads.back().get();
+    }
+    static void writeName(std::FILE *file, const char *name)
+    {
+        for (; *name; ++name)
+        {
+            if (*name == '"' || *name == '\\')
+                std::fputc('\\', file);
+            std::fputc(*name, file);
+        }
+    }
+};
+
+// records the enclosing block as a trace event while tracing is enabled
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) : name(name), start(Tracer::Main().Enabled() ? Tracer::Main().Now() : -1) { }
+    ~TraceScope()
+    {
+        if (this->start >= 0)
+            Tracer::Main().Record(this->name, this->start, Tracer::Main().Now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope &operator=(const TraceScope&) = delete;
+
+private:
+    const char *name;
+    int64_t start;
+};
+
+#ifndef BOUNCYBALL_NO_PROFILER
+#define TRACE_JOIN_(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif
+
+#endif
@@ -0,0 +1,263 @@
+// versus_bench - races two games in one process over the rollback netcode and checks they agree.
+//
+//   versus_bench [--level <n>] [--latency <ticks>] [--jitter <ticks>] [--loss <fraction>]
+//                [--seed <n>] [--delay <ticks>] [--udp <port>]
+//
+// Loads three games with GL stubbed out (gl_stub.h) and the null audio
+// output. Two of them are the players of a versus race (Game::StartRace),
+// connected by the simulated link of net_transport.h (default 4 ticks of
+// latency, 2 of jitter, 10% loss) or, with --udp, by two UDP sockets on
+// 127.0.0.1:<port> and <port>+1. Player 0 plays the fixed-physics script of
+// resources/playthrough/fixed/<n>.txt, player 1 the same script --delay
+// ticks later (default 20). Both keep seeing inputs they did not predict,
+// and the late script no longer fits the level, so player 1 mostly dies and
+// starts over, which rollbacks have to get right as well. The third game
+// steps the same race with both inputs known, no network. For every level
+// with a script (or only --level) it checks, and returns 1 when one fails:
+//   - player 0 reaches the goal in the reference game,
+//   - both games have each player finish on the tick and with the deaths
+//     of the reference, and all three hold the same state after the last
+//     tick, byte for byte (Game::SaveRaceState),
+//   - replaying 10 ticks (RollbackSession::Resimulate, load + 10 steps of
+//     both balls) takes under 1 ms at the 99th percentile, measured halfway
+//     through the race.
+// It also prints the rollbacks the race needed and the slowest one.
+// Run from the repository root.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gl_stub.h"
+#include "game.h"
+#include "net_transport.h"
+
+static const char *const SCRIPT_FOLDER = "resources/playthrough/fixed";
+static const unsigned int RESIMULATE_TICKS = 10;
+static const unsigned int RESIMULATE_RUNS = 1000;
+static const double RESIMULATE_LIMIT_MS = 1.0;
+// the keys of PackInputKeys: A (bit 0) and D (bit 1)
+static const unsigned char INPUT_LEFT = 1, INPUT_RIGHT = 2;
+
+// playthrough scripts: lines of "<ticks> <keys>", keys being L, R or -, # starts a comment
+static bool loadScript(const std::string &file, std::vector<unsigned char> &ticks)
+{
+    std::ifstream stream(file);
+    if (!stream)
+        return false;
+    ticks.clear();
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        unsigned int count;
+        std::string keys;
+        if (!(fields >> count >> keys))
+            continue;
+        unsigned char input = 0;
+        if (keys.find('L') != std::string::npos)
+            input |= INPUT_LEFT;
+        if (keys.find('R') != std::string::npos)
+            input |= INPUT_RIGHT;
+        ticks.insert(ticks.end(), count, input);
+    }
+    return !ticks.empty();
+}
+
+static void load(Game &game)
+{
+    game.SetAudioOutput("null");
+    game.Init();
+    while (game.State == GAME_LOADING)
+    {
+        game.Update(1.0f / 60.0f);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+struct Settings {
+    SimulatedLink::Settings Link;
+    unsigned int Delay = 20;
+    int UdpPort = 0;
+};
+
+// one race on level (1-based), false if a check fails
+static bool race(Game *games[3], unsigned int level, const std::vector<unsigned char> &script, const Settings &settings)
+{
+    const unsigned int ticks = unsigned(script.size()) + settings.Delay + 30;
+    auto input = [&](int player, uint32_t tick) -> unsigned char {
+        uint32_t delay = player == 0 ? 0 : settings.Delay;
+        return tick >= delay && tick - delay < script.size() ? script[tick - delay] : 0;
+    };
+
+    // the reference: both inputs known every tick
+    SimulatedLink unused(settings.Link);
+    Game &reference = *games[2];
+    reference.StartRace(level - 1, 0, unused.End(0));
+    for (uint32_t tick = 0; tick < ticks; ++tick)
+    {
+        unsigned char inputs[2] = { input(0, tick), input(1, tick) };
+        reference.raceStep(inputs, tick, false);
+    }
+
+    SimulatedLink link(settings.Link);
+    UdpTransport sockets[2];
+    Transport *transports[2] = { &link.End(0), &link.End(1) };
+    if (settings.UdpPort > 0)
+    {
+        unsigned short port = static_cast<unsigned short>(settings.UdpPort);
+        if (!sockets[0].Open(port, "127.0.0.1", port + 1) || !sockets[1].Open(port + 1, "127.0.0.1", port))
+            return false;
+        transports[0] = &sockets[0];
+        transports[1] = &sockets[1];
+    }
+    for (int player = 0; player < 2; ++player)
+        games[player]->StartRace(level - 1, player, *transports[player]);
+    RollbackSession *sessions[2] = { games[0]->Race(), games[1]->Race() };
+
+    std::vector<double> resimulate;
+    auto start = std::chrono::steady_clock::now();
+    for (;;)
+    {
+        bool done = true;
+        for (int player = 0; player < 2; ++player)
+        {
+            RollbackSession &session = *sessions[player];
+            if (session.Tick() < ticks)
+                session.Advance(input(player, session.Tick()));
+            else
+                session.Poll();
+            done = done && session.ConfirmedTick() >= ticks;
+        }
+        // halfway: the cost of the longest rollback on player 0 (same inputs, the state does not change)
+        if (resimulate.empty() && sessions[0]->Tick() >= ticks / 2)
+            for (unsigned int run = 0; run < RESIMULATE_RUNS; ++run)
+                resimulate.push_back(sessions[0]->Resimulate(RESIMULATE_TICKS));
+        if (done)
+            break;
+        link.Step();
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(20))
+        {
+            std::cout << "ERROR::VERSUS: Level " << level << " did not finish (ticks " << sessions[0]->Tick() << " / "
+                      << sessions[1]->Tick() << ", confirmed " << sessions[0]->ConfirmedTick() << " / " << sessions[1]->ConfirmedTick() << ")" << std::endl;
+            return false;
+        }
+    }
+
+    bool passed = true;
+    if (reference.GetRacePlayer(0).FinishTick < 0)
+    {
+        std::cout << "ERROR::VERSUS: Level " << level << " player 0 does not reach the goal (script broken?)" << std::endl;
+        passed = false;
+    }
+    for (int player = 0; player < 2; ++player)
+    {
+        const RacePlayer &expected = reference.GetRacePlayer(player);
+        for (int game = 0; game < 2; ++game)
+        {
+            const RacePlayer &actual = games[game]->GetRacePlayer(player);
+            if (actual.FinishTick != expected.FinishTick || actual.Deaths != expected.Deaths)
+            {
+                std::cout << "ERROR::VERSUS: Level " << level << " game " << game << " has player " << player << " finish on tick "
+                          << actual.FinishTick << " after " << actual.Deaths << " deaths, the reference on " << expected.FinishTick
+                          << " after " << expected.Deaths << std::endl;
+                passed = false;
+            }
+        }
+    }
+    std::vector<unsigned char> states[3];
+    for (int game = 0; game < 3; ++game)
+        games[game]->SaveRaceState(states[game]);
+    if (states[0] != states[2] || states[1] != states[2])
+    {
+        std::cout << "ERROR::VERSUS: Level " << level << " the games end in different states" << std::endl;
+        passed = false;
+    }
+    std::sort(resimulate.begin(), resimulate.end());
+    double median = resimulate.empty() ? 0.0 : resimulate[resimulate.size() / 2];
+    double p99 = resimulate.empty() ? 0.0 : resimulate[resimulate.size() * 99 / 100];
+    if (p99 >= RESIMULATE_LIMIT_MS)
+    {
+        std::cout << "ERROR::VERSUS: Level " << level << " replaying " << RESIMULATE_TICKS << " ticks takes " << p99 << " ms (p99)" << std::endl;
+        passed = false;
+    }
+
+    const RollbackSession::Stats &stats = sessions[0]->GetStats();
+    const RollbackSession::Stats &other = sessions[1]->GetStats();
+    std::printf("level %2u  %4u ticks  finish %4d / %4d  deaths %2u / %2u  rollbacks %4llu / %4llu (longest %2u, worst %.3f ms)  "
+                "replay %u ticks: median %.3f ms, p99 %.3f ms  %s\n",
+                level, ticks, reference.GetRacePlayer(0).FinishTick, reference.GetRacePlayer(1).FinishTick,
+                reference.GetRacePlayer(0).Deaths, reference.GetRacePlayer(1).Deaths,
+                (unsigned long long)stats.Rollbacks, (unsigned long long)other.Rollbacks,
+                std::max(stats.LongestRollback, other.LongestRollback), std::max(stats.WorstRollbackMs, other.WorstRollbackMs),
+                RESIMULATE_TICKS, median, p99, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+int main(int argc, char *argv[])
+{
+    Settings settings;
+    settings.Link.Latency = 4;
+    settings.Link.Jitter = 2;
+    settings.Link.Loss = 0.1f;
+    unsigned int onlyLevel = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--level" && i + 1 < argc)
+            onlyLevel = std::atoi(argv[++i]);
+        else if (arg == "--latency" && i + 1 < argc)
+            settings.Link.Latency = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--jitter" && i + 1 < argc)
+            settings.Link.Jitter = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--loss" && i + 1 < argc)
+            settings.Link.Loss = float(std::atof(argv[++i]));
+        else if (arg == "--seed" && i + 1 < argc)
+            settings.Link.Seed = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--delay" && i + 1 < argc)
+            settings.Delay = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--udp" && i + 1 < argc)
+            settings.UdpPort = std::atoi(argv[++i]);
+    }
+
+    StubGL();
+    std::unique_ptr<Game> players[3];
+    Game *games[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        players[i].reset(new Game(800, 600));
+        load(*players[i]);
+        games[i] = players[i].get();
+    }
+    StartupReport::Main().Close();
+    if (settings.UdpPort > 0)
+        std::cout << "UDP on 127.0.0.1:" << settings.UdpPort << " and " << settings.UdpPort + 1 << std::endl;
+    else
+        std::cout << "Simulated link: " << settings.Link.Latency << " ticks latency, " << settings.Link.Jitter << " jitter, "
+                  << settings.Link.Loss * 100.0f << "% loss" << std::endl;
+
+    int failures = 0, raced = 0;
+    for (unsigned int level = 1; level <= games[0]->maxLevel + 1; ++level)
+    {
+        std::vector<unsigned char> script;
+        if ((onlyLevel && level != onlyLevel) || !loadScript(std::string(SCRIPT_FOLDER) + "/" + std::to_string(level) + ".txt", script))
+            continue;
+        ++raced;
+        if (!race(games, level, script, settings))
+            ++failures;
+    }
+    if (raced == 0)
+    {
+        std::cout << "ERROR::VERSUS: No scripts in " << SCRIPT_FOLDER << std::endl;
+        return 1;
+    }
+    std::cout << raced - failures << " of " << raced << " races passed" << std::endl;
+    return failures > 0 ? 1 : 0;
+}